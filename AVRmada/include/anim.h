@@ -0,0 +1,71 @@
+/* ---------------------------------------------------------------------------
+ * anim.h - Header for the Non-Blocking Animation Timeline
+ *
+ * Provides:
+ * - Colour fades of PROGMEM text through precomputed RGB565 ramps
+ * - Blinking regions (e.g. the pending shot cell)
+ * - Indexed-colour RLE sprites played in place, one delta frame at a time
+ *
+ * Animations are tracks stepped by anim_tick() from the main loop, so the
+ * game keeps reading input while they run.
+ *
+ * v2.0
+ * Copyright (c) 2025 Peter Kamp
+ * --------------------------------------------------------------------------- */
+
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "gfx.h"
+
+/* ---------------------------------------------------------------------------
+ * Timeline Configuration
+ * --------------------------------------------------------------------------- */
+#define ANIM_MAX_TRACKS		4		// Tracks running at the same time
+#define ANIM_BUDGET_PX		2048	// Pixels drawn per tick (~8 ms of SPI) before frames are deferred
+#define ANIM_FOREVER		0		// Blink until stopped
+#define ANIM_NONE			(-1)	// No track (returned when all tracks are busy)
+
+/* ---------------------------------------------------------------------------
+ * RGB565 Ramps
+ * --------------------------------------------------------------------------- */
+#define ANIM_RAMP_LEN		16		// Entries in a ramp built with ANIM_RAMP
+
+// Entry k (1..ANIM_RAMP_LEN) of a ramp from black to (r, g, b)
+#define ANIM_RAMP_STEP(r, g, b, k)	RGB565((r) * (k) / ANIM_RAMP_LEN, (g) * (k) / ANIM_RAMP_LEN, (b) * (k) / ANIM_RAMP_LEN)
+
+// Initializer for a PROGMEM ramp from just above black up to (r, g, b)
+#define ANIM_RAMP(r, g, b) \
+	ANIM_RAMP_STEP(r, g, b, 1),  ANIM_RAMP_STEP(r, g, b, 2),  ANIM_RAMP_STEP(r, g, b, 3),  ANIM_RAMP_STEP(r, g, b, 4),  \
+	ANIM_RAMP_STEP(r, g, b, 5),  ANIM_RAMP_STEP(r, g, b, 6),  ANIM_RAMP_STEP(r, g, b, 7),  ANIM_RAMP_STEP(r, g, b, 8),  \
+	ANIM_RAMP_STEP(r, g, b, 9),  ANIM_RAMP_STEP(r, g, b, 10), ANIM_RAMP_STEP(r, g, b, 11), ANIM_RAMP_STEP(r, g, b, 12), \
+	ANIM_RAMP_STEP(r, g, b, 13), ANIM_RAMP_STEP(r, g, b, 14), ANIM_RAMP_STEP(r, g, b, 15), ANIM_RAMP_STEP(r, g, b, 16)
+
+/* Draws one blink phase (on = highlighted) */
+typedef void (*AnimBlinkFn)(bool on);
+
+/* ---------------------------------------------------------------------------
+ * Function Prototypes
+ * --------------------------------------------------------------------------- */
+
+/* Starting tracks (each returns the track ID, or ANIM_NONE) */
+int8_t	anim_fade_text(int16_t x, int16_t y, const char *text, uint8_t size, uint16_t bg,
+					   const uint16_t *ramp, uint8_t rampLen, uint16_t interval, uint16_t delay);
+int8_t	anim_blink(AnimBlinkFn draw, uint16_t pixels, uint16_t interval, uint8_t toggles);
+int8_t	anim_sprite(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *runs,
+					const uint16_t *palette, uint8_t frames, uint16_t interval);
+
+/* Stepping (call every 1 ms) */
+void	anim_tick(void);
+bool	anim_active(void);
+
+/* Interrupting: finish draws the final frame, stop leaves the screen as it is */
+void	anim_finish(int8_t id);
+void	anim_finish_all(void);
+void	anim_stop(int8_t id);
+void	anim_stop_all(void);
+
+#endif  // ANIM_H
@@ -0,0 +1,66 @@
+/* ---------------------------------------------------------------------------
+ * arena.h - Header for the Phase-Scoped SRAM Arena
+ *
+ * Buffers that only one phase of the program needs share one static pool:
+ * - Menu / settings: the open widget screen
+ * - Multiplayer game: the UART receive line
+ * - Single-player game: the spoofed line queue and AI placement scratch
+ *
+ * arena_enter() empties the pool when the game changes phase; inside a phase
+ * buffers are bump-allocated, and scratch is handed back with arena_release().
+ *
+ * v2.0
+ * Copyright (c) 2025 Peter Kamp
+ * --------------------------------------------------------------------------- */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+
+/* ---------------------------------------------------------------------------
+ * Phases
+ * --------------------------------------------------------------------------- */
+typedef enum {
+	ARENA_MENU,				// GS_MAINMENU
+	ARENA_SETTINGS,			// GS_SETTINGS
+	ARENA_GAME,				// GS_NEWGAME .. GS_OVER
+	ARENA_PHASES
+} ArenaPhase;
+
+/* ---------------------------------------------------------------------------
+ * Phase Budgets (bytes)
+ * --------------------------------------------------------------------------- */
+// Each owner asserts its buffer against its budget where the buffer is declared
+#define ARENA_WIDGET_BYTES		sizeof(WidgetState)	// Open widget screen (menu and settings; 14 on AVR, wider pointers on a host)
+#define ARENA_RX_BYTES			32			// UART receive line (multiplayer)
+#define ARENA_UART_RING_BYTES	64			// UART receive ring behind it (multiplayer, power of two)
+#define ARENA_SP_QUEUE_BYTES	128			// Spoofed line queue (single-player)
+#define ARENA_AI_PLACE_BYTES	260			// AI scratch: an endgame search, kept across ticks (single-player, released after use)
+
+#define ARENA_MENU_BYTES		ARENA_WIDGET_BYTES
+#define ARENA_MP_BYTES			(ARENA_RX_BYTES + ARENA_UART_RING_BYTES)
+#define ARENA_SP_BYTES			(ARENA_SP_QUEUE_BYTES + ARENA_AI_PLACE_BYTES)
+
+#define ARENA_SIZE				ARENA_SP_BYTES		// Largest phase
+
+// (The menu phase is checked in battleship_utils.c, where WidgetState is complete)
+_Static_assert(ARENA_MP_BYTES   <= ARENA_SIZE, "Multiplayer phase does not fit in the arena");
+_Static_assert(ARENA_SP_BYTES   <= ARENA_SIZE, "Single-player phase does not fit in the arena");
+
+/* ---------------------------------------------------------------------------
+ * Function Prototypes
+ * --------------------------------------------------------------------------- */
+
+/* Phase changes (frees everything) */
+void		arena_enter(ArenaPhase phase);
+
+/* Allocation (returns NULL when the pool is exhausted) */
+void		*arena_alloc(uint16_t size);
+uint16_t	arena_mark(void);
+void		arena_release(uint16_t mark);
+
+/* Highest pool use seen in a phase since reset */
+uint16_t	arena_peak(ArenaPhase phase);
+
+#endif  // ARENA_H
@@ -28,6 +28,7 @@
  *  Pixel geometry
  * ------------------------------------------------------------------------- */
 #define CELL_SIZE_PX		16
+#define CURSOR_THICKNESS_PX	2		/* Cursor frame thickness */
 #define PLAYER_GRID_X_PX	0
 #define ENEMY_GRID_X_PX		160
 #define GRID_Y_PX			40
@@ -35,28 +36,35 @@
 #define HEADER_HEIGHT_PX	40
 #define STATUS_Y_PX			210
 
+/* Shot animations: explosion on a hit, splash on a miss */
+#define SHOT_SPRITE_PX		(CELL_SIZE_PX - 2 * CURSOR_THICKNESS_PX)	/* Inside the cursor frame */
+#define SHOT_FRAMES			7
+#define SHOT_FRAME_MS		60
+
 /* -------------------------------------------------------------------------
  *  Color definitions
  * ------------------------------------------------------------------------- */
-#define CLR_NONE			rgb(1,2,3)
-#define CLR_MM_BG			rgb(0,0,0)
-#define CLR_BLACK			rgb(0,0,0)
-#define CLR_WHITE			rgb(255,255,255)
-#define CLR_DARK_GRAY		rgb(64,64,64)
-#define CLR_LIGHT_GRAY		rgb(128,128,128)
-#define CLR_GREEN			rgb(0,255,0)
-#define CLR_RED				rgb(255,0,0)
-#define CLR_YELLOW			rgb(255,255,0)
-#define CLR_ORANGE			rgb(255,128,0)
-#define CLR_CYAN			rgb(0,255,255)
-#define CLR_NAVY			rgb(0,0,128)
-#define CLR_SHIP			rgb(64,64,64)
-#define CLR_HIT				rgb(255,0,0)
-#define CLR_MISS			rgb(255,255,255)
-#define CLR_GHOST_OK		rgb(0,255,0)
-#define CLR_GHOST_BAD		rgb(255,0,0)
-#define CLR_CURSOR			rgb(255,255,0)
-#define CLR_PENDING			rgb(255,128,0)
+#define CLR_NONE			RGB565(1,2,3)
+#define CLR_MM_BG			RGB565(0,0,0)
+#define CLR_BLACK			RGB565(0,0,0)
+#define CLR_WHITE			RGB565(255,255,255)
+#define CLR_DARK_GRAY		RGB565(64,64,64)
+#define CLR_LIGHT_GRAY		RGB565(128,128,128)
+#define CLR_GREEN			RGB565(0,255,0)
+#define CLR_RED				RGB565(255,0,0)
+#define CLR_YELLOW			RGB565(255,255,0)
+#define CLR_ORANGE			RGB565(255,128,0)
+#define CLR_CYAN			RGB565(0,255,255)
+#define CLR_NAVY			RGB565(0,0,128)
+#define CLR_SHIP			RGB565(64,64,64)
+#define CLR_HIT				RGB565(255,0,0)
+#define CLR_MISS			RGB565(255,255,255)
+#define CLR_GHOST_OK		RGB565(0,255,0)
+#define CLR_GHOST_BAD		RGB565(255,0,0)
+#define CLR_CURSOR			RGB565(255,255,0)
+#define CLR_PENDING			RGB565(255,128,0)
+#define CLR_RADAR			RGB565(128,0,160)	/* Unshot cell a radar scan found ships near */
+#define CLR_RADAR_CLEAR		RGB565(0,96,96)		/* Unshot cell a radar scan found empty */
 
 /* -------------------------------------------------------------------------
  * Joystick configuration
@@ -82,19 +90,9 @@ extern AIDifficulty aiDifficulty;
  * Ship constants
  * ------------------------------------------------------------------------- */
 #define NUM_SHIPS 5
+#define MAX_SHIP_LENGTH 5		/* Longest entry in SHIP_LENGTHS */
 extern const uint8_t SHIP_LENGTHS[NUM_SHIPS];
 
-/* -------------------------------------------------------------------------
- * Bitmap board states
- *
- * Each of these arrays is BITMAP_SIZE bytes; each bit represents one cell
- * in row-major order (bit 0 = row 0,col 0; bit 1 = row 0,col 1; ... bit 99 = row 9,col 9).
- * ------------------------------------------------------------------------- */
-extern uint8_t playerOccupiedBitmap		[BITMAP_SIZE];
-extern uint8_t playerAttackedAtBitmap	[BITMAP_SIZE];
-extern uint8_t enemyConfirmedHitBitmap	[BITMAP_SIZE];
-extern uint8_t enemyAttackedAtBitmap	[BITMAP_SIZE];
-
 /* -------------------------------------------------------------------------
  * Internal bit-manipulation helpers (static inline)
  * ------------------------------------------------------------------------- */
@@ -169,17 +167,191 @@ typedef struct {
 } Ship;
 
 /* -------------------------------------------------------------------------
- * Extern global game state (defined in main.c)
+ * Radar
+ *
+ * Instead of firing, a player can scan the 3x3 area around a cell (clipped
+ * to the board) and learn how many ship cells it holds. A scan uses the
+ * turn. Frames: "S <seq> <row> <col>" asks (seq = the scanner's scan index,
+ * so resends can be told apart), "Q <row> <col> <count>" answers.
+ * ------------------------------------------------------------------------- */
+#define RADAR_USES			2		/* Scans per player per game */
+#define RADAR_RADIUS		1		/* Cells from the centre: 3x3 */
+#define RADAR_SPAN			(2 * RADAR_RADIUS + 1)
+#define RADAR_NONE			0xFF	/* RadarScan.count of a scan not made yet */
+#define RADAR_HOLD_MS		500		/* Button hold that scans instead of firing */
+
+typedef struct {
+	uint8_t row;			/* Centre */
+	uint8_t col;
+	uint8_t count;			/* Ship cells found, or RADAR_NONE */
+} RadarScan;
+
+/* -------------------------------------------------------------------------
+ * Menu widgets
+ *
+ * The main menu and settings screens are PROGMEM tables of widgets. The
+ * renderer remembers how each widget is drawn and repaints only the parts
+ * (border, label, icon) whose focus or value changed.
+ * ------------------------------------------------------------------------- */
+#define WIDGET_NONE			0xFF	/* No widget: nothing focused, or no neighbour */
+#define WIDGET_MAX			3		/* Most widgets on one screen */
+
+typedef enum {
+	WIDGET_BUTTON,			/* Bordered box with a label and/or a choice */
+	WIDGET_ICON				/* 1-bit PROGMEM bitmap */
+} WidgetKind;
+
+/* Joystick directions, used to index Widget.nav */
+typedef enum {
+	NAV_UP,
+	NAV_DOWN,
+	NAV_LEFT,
+	NAV_RIGHT
+} NavDir;
+
+/* Widget IDs on the main menu and settings screens (table order) */
+enum { WID_MULTIPLAYER, WID_VERSUS_AI, WID_GEAR };
+enum { WID_SOUNDS, WID_DIFFICULTY, WID_BACK };
+
+/* One value of a choice widget */
+typedef struct {
+	const char *text;			/* PROGMEM label */
+	uint16_t	colour;			/* Colour of every label on the widget */
+} WidgetChoice;
+
+typedef struct {
+	uint8_t		kind;			/* WidgetKind */
+	int16_t		x, y;			/* Button box (border centreline) or icon top-left */
+	uint8_t		w, h;			/* Button box or icon size */
+	uint16_t	focusColour;	/* Border (button) or icon colour while focused */
+	const char *label;			/* PROGMEM size-3 label, or NULL */
+	uint8_t		labelDx;		/* Label offset from (x, y) */
+	uint8_t		labelDy;
+	const WidgetChoice *choices;	/* PROGMEM choices indexed by the widget value, or NULL */
+	uint8_t		choiceDx;		/* Choice label offset from (x, y) */
+	uint8_t		choiceDy;
+	uint8_t		choiceSize;
+	const uint8_t *bitmap;		/* PROGMEM icon (WIDGET_ICON) */
+	uint8_t		nav[4];			/* Neighbour per NavDir, WIDGET_NONE = stay */
+} Widget;
+
+typedef struct {
+	const Widget *widgets;		/* PROGMEM widget table */
+	uint8_t		count;
+	uint8_t		entry[4];		/* Widget focused per NavDir when nothing is focused */
+} WidgetScreen;
+
+/* The open screen, borrowed from the arena (ARENA_WIDGET_BYTES) */
+typedef struct {
+	WidgetScreen screen;		/* Open screen (copied from PROGMEM) */
+	uint8_t		focus;			/* Focused widget, WIDGET_NONE if none */
+	uint8_t		value[WIDGET_MAX];	/* Current value of each widget */
+	uint8_t		drawn[WIDGET_MAX];	/* State on screen (WIDGET_FOCUSED | value), WIDGET_NONE = not drawn */
+} WidgetState;
+
+/* -------------------------------------------------------------------------
+ * Game instance state
+ *
+ * Everything one running game owns lives in `game` (defined in main.c). It is
+ * not the firmware's only state: display caches, the single-player AI and the
+ * link counters stay separate globals. The host build (host/instance.c)
+ * therefore swaps the whole data image rather than `game`, and host/farm.c
+ * runs instances in parallel as processes, not threads.
  * ------------------------------------------------------------------------- */
-extern Ship	playerFleet[NUM_SHIPS];
 
-extern uint8_t playerRemaining;
-extern uint8_t enemyRemaining;
+/* Game mode: determined by button selection in the main menu */
+typedef enum {
+	GM_NONE,			/* Default gMode is GM_NONE */
+	GM_MULTIPLAYER,
+	GM_SINGLEPLAYER
+} GameMode;
 
-extern uint8_t selRow;			/* Current cursor row */
-extern uint8_t selCol;			/* Current cursor col */
-extern uint8_t ghostShipIdx;	/* Index of ship being placed */
-extern bool	ghostHorizontal;	/* Orientation of ship placement */
+/* Game states: initially GS_RESET and is determined throughout the game loop */
+typedef enum {
+	GS_RESET,
+	GS_MAINMENU,
+	GS_SETTINGS,
+	GS_NEWGAME,
+	GS_PLACING,
+	GS_WAIT,
+	GS_MYTURN,
+	GS_WAITRES,
+	GS_ENEMYTURN,
+	GS_OVER
+} GameState;
+
+/* Network states */
+typedef enum {
+	NS_IDLE,
+	NS_WAIT_READY,
+	NS_DECIDE,
+	NS_MY_TURN,
+	NS_PEER_TURN,
+	NS_WAIT_RES,
+	NS_GAME_OVER
+} NetState;
+
+typedef struct {
+	/* Bitmap board states: BITMAP_SIZE bytes each; each bit represents one cell
+	 * in row-major order (bit 0 = row 0,col 0; bit 1 = row 0,col 1; ... bit 99 = row 9,col 9) */
+	uint8_t		playerOccupiedBitmap	[BITMAP_SIZE];	/* Where all of the player's ships are */
+	uint8_t		playerAttackedAtBitmap	[BITMAP_SIZE];	/* Squares the player has been attacked at */
+	uint8_t		enemyConfirmedHitBitmap	[BITMAP_SIZE];	/* Confirmed enemy ship squares hit */
+	uint8_t		enemyAttackedAtBitmap	[BITMAP_SIZE];	/* Squares the enemy has been attacked at */
+	uint16_t	lfsr;					/* RNG state */
+
+	/* Fleet and placement */
+	Ship		playerFleet[NUM_SHIPS];
+	uint8_t		playerRemaining;		/* Ship cells left */
+	uint8_t		enemyRemaining;
+	uint8_t		selRow;					/* Current cursor row */
+	uint8_t		selCol;					/* Current cursor col */
+	uint8_t		ghostShipIdx;			/* Index of ship being placed */
+	bool		ghostHorizontal;		/* Orientation of ship placement */
+
+	/* State machines and input */
+	GameMode	gMode;
+	GameState	gState;
+	NetState	nState;
+	uint32_t	systemTime;				/* System milliseconds ticker */
+	uint32_t	nextMoveAllowed;		/* Joystick move repeat throttle */
+	bool		buttonLatch;			/* Prevent multiple button presses */
+	bool		overButtonLatch;
+	uint8_t		overTapCount;
+	uint32_t	invalidTimer;			/* When "Invalid placement!" was shown */
+	bool		showInvalid;
+
+	/* Outgoing shot */
+	int8_t		pendingRow;				/* Row of pending outgoing shot, -1 if none */
+	int8_t		pendingCol;				/* Col of pending outgoing shot */
+	int8_t		pendingBlink;			/* Animation track blinking the pending shot */
+	bool		pendingLit;				/* Blink phase: pending shot drawn in CLR_PENDING */
+
+	/* Link */
+	char		*rxBuf;					/* RX buffer (arena, multiplayer games only) */
+	uint8_t		rxIdx;					/* Current RX buffer index */
+	uint16_t	selfToken;				/* Local token (based on finish time) */
+	uint16_t	peerToken;				/* Remote peer token */
+	uint16_t	peerNewToken;			/* Last READY token heard (believed when heard twice) */
+	uint16_t	resendTick;				/* ms since last packet sent */
+	uint16_t	resendWait;				/* ms before the next attack resend (backs off) */
+	uint32_t	peerWaitTick;			/* ms spent waiting on the peer's move or answer */
+	uint16_t	postReadyLeft;			/* How long to keep sending READY after sync */
+	bool		peerPiggyback;			/* Peer reads "P" frames (flagged in its READY) */
+	bool		carrying;				/* A result is held for, or riding on, our attack */
+	uint8_t		carryRow, carryCol;		/* The carried result */
+	bool		carryHit;
+	uint8_t		holdLeft;				/* ms until a held result is sent alone */
+
+	/* Radar */
+	RadarScan	enemyScans[RADAR_USES];	/* Our scans of the enemy board, in order */
+	uint8_t		radarLeft;				/* Scans we may still make */
+	uint8_t		peerScans;				/* Scans of our board the peer has made (spots resends) */
+	bool		pendingScan;			/* The pending outgoing move is a scan, not a shot */
+	bool		peerRadar;				/* Peer answers scans (flagged in its READY) */
+} GameContext;
+
+extern GameContext game;
 
 /* -------------------------------------------------------------------------
  * Function prototypes
@@ -208,14 +380,16 @@ float		rand_bool(float probability);
 
 /* Drawing primitives */
 void	draw_cell(uint8_t row, uint8_t col, uint16_t colour, uint16_t originX);
+void	draw_shot_cell(uint8_t row, uint8_t col, bool hit, uint16_t originX);
 void	draw_cursor(uint8_t row, uint8_t col, uint16_t originX);
+uint16_t cell_colour(uint8_t row, uint8_t col, uint16_t originX);
 
 /* Text/UI helpers */
 void	header_place(void);
 void	header_play(void);
 void	status_msg(const char *msg);
 
-/* Board reset: clears both occupied and attacked bitmaps, resets counters */
+/* Board reset: clears both occupied and attacked bitmaps, resets counters and radar */
 void	board_reset(void);
 
 /* Can a ship of length len fit at (row,col) without overlapping?
@@ -223,28 +397,45 @@ void	board_reset(void);
  */
 bool	ship_can_fit(const uint8_t *occupiedBitmap, uint8_t row, uint8_t col, uint8_t len, bool horizontal);
 
+/* Row-word boards test a whole row of placements at once: bit c of rows[r]
+ * is cell (r, c). ship_fit_row() returns bit c set wherever a ship of length
+ * len fits at (row, c); it agrees with ship_can_fit() cell for cell.
+ */
+#define GRID_ROW_MASK		((1u << GRID_COLS) - 1)
+void	bitmap_to_rows(const uint8_t *bitmap, uint16_t *rows);
+uint16_t ship_fit_row(const uint16_t *rows, uint8_t row, uint8_t len, bool horizontal);
+
+/* Radar: does `scan` cover (row, col); ship cells in the area around a centre */
+bool	radar_covers(const RadarScan *scan, uint8_t row, uint8_t col);
+uint8_t	radar_count(const uint8_t *occupiedBitmap, uint8_t row, uint8_t col);
+
+/* Repaint the radar area around (row, col) on the enemy board in one pass */
+void	draw_radar_area(uint8_t row, uint8_t col);
+
 /* Ship placement helpers */
-void	ghost_update(uint8_t row, uint8_t col, bool horizontal, bool draw);
+void	ghost_update(uint8_t row, uint8_t col, bool horizontal);
 void	player_place_current_ship(uint8_t row, uint8_t col, bool horizontal, uint8_t len);
 
+/* Menu widgets (on the screen opened by the last gui_draw_main_menu/gui_draw_settings_screen) */
+void	 widgets_close(void);
+uint8_t	 widgets_focus(void);
+bool	 widgets_navigate(NavDir dir);
+void	 widgets_set_value(uint8_t id, uint8_t value);
+void	 widgets_render(void);
+
 /* GUI screen builders */
 void	 gui_draw_main_menu(void);
-void	 gui_draw_multiplayer_button(uint16_t text_color, uint16_t border_color);
-void	 gui_draw_singleplayer_button(uint16_t text_color, uint16_t border_color);
-void     gui_draw_settings_gear(uint16_t color);
 void	 gui_animate_title_letter_v(void);
 void	 gui_draw_placement(void);
 void	 gui_draw_play_screen(void);
-void	 gui_draw_settings_screen(const bool *sounds, const AIDifficulty *difficulty);
-void	 gui_draw_sound_toggle_button(uint16_t text_color, uint16_t border_color, const bool *sound);
-void	 gui_draw_difficulty_button(uint16_t text_color, uint16_t border_color, const AIDifficulty *difficulty);
-void	 gui_draw_settings_back(uint16_t color);
+void	 gui_draw_settings_screen(bool sounds, AIDifficulty difficulty);
 void	 gui_draw_lose_screen();
 void	 gui_draw_win_screen();
 
 /* UART communication helpers */
 void	 uart_init(void);
 int		 uart_putchar(char c, FILE *stream);
+void	 uart_rx_ring(uint8_t *ring);
 uint8_t  uart_char_available(void);
 char	 uart_getchar(void);
 
@@ -38,4 +38,7 @@ void play_enemy_attack_sound(const bool *hit, const bool *soundsEnabled);
 
 void play_radar_sound(const bool *hit, const bool *soundsEnabled);
 
+/* Non-blocking playback (the enemy attack sounds); call every 1 ms tick */
+void buzzer_tick(void);
+
 #endif
@@ -17,9 +17,21 @@
 #define IMG_BYTES          ((IMG_PIXELS + 1) >> 1)  // Two pixels per byte
 #define EEPROM_IMAGE_ADDR  ((uint16_t)0x0000)		// EEPROM base address
 
+/* Stamp stored right after the image: CRC-16 of the image, seeded with the
+ * version. A matching stamp means the image is already programmed. */
+#define EEPROM_IMAGE_VERSION 1						// Bump when imageData changes layout
+#define EEPROM_STAMP_ADDR  (EEPROM_IMAGE_ADDR + IMG_BYTES)
+
+/* Single-player opponent habits (singleplayer.c) fill the bytes left after
+ * the stamp. Erased bytes (0xFF) mean no habit is known yet. */
+#define EEPROM_HABIT_ADDR  (EEPROM_STAMP_ADDR + sizeof(uint16_t))
+#define EEPROM_HABIT_BYTES 9
+
 /* Populate (and/or clear) the EEPROM image region.
- * - If FLASH_IMAGE is defined, this copies the PROGMEM image to EEPROM.
- * - If CLEAR_EEPROM is defined, this zeroes out IMG_BYTES bytes.
+ * - If FLASH_IMAGE is defined, this copies the PROGMEM image to EEPROM,
+ *   unless the stamp shows that EEPROM already holds it.
+ * - If CLEAR_EEPROM is defined, this zeroes out IMG_BYTES bytes and erases
+ *   the opponent habits.
  * - Can do both if both are defined.
  */
 void initEepromImage(void);
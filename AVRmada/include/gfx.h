@@ -18,6 +18,7 @@
 #endif
 
 #include <stdint.h>			// Standard integer types
+#include <stdbool.h>		// Boolean type
 #include <avr/io.h>			// AVR hardware IO definitions
 #include <util/delay.h>		// Delay functions
 #include <stdlib.h>			// Standard functions (abs())
@@ -28,6 +29,13 @@
 #define SCREEN_X			320
 #define SCREEN_Y			240
 
+/* ---------------------------------------------------------------------------
+ * Color Helper Macro
+ * --------------------------------------------------------------------------- */
+
+/* Same conversion as rgb(), usable in constant initializers (e.g. PROGMEM tables) */
+#define RGB565(r, g, b)		((uint16_t)((((r) >> 3) & 0x1F) << 11 | (((g) >> 2) & 0x3F) << 5 | (((b) >> 3) & 0x1F)))
+
 /* ---------------------------------------------------------------------------
  * Pin and Port Assignments
  * --------------------------------------------------------------------------- */
@@ -47,6 +55,13 @@
 #define ILI9341_RST_DDR		DDRB
 #define ILI9341_RST_PIN		PB0
 
+/* ---------------------------------------------------------------------------
+ * Controller Timing (ILI9341 datasheet, ms)
+ * --------------------------------------------------------------------------- */
+#define ILI9341_RESET_WAIT_MS		5	// Reset release -> first command
+#define ILI9341_SLEEP_OUT_WAIT_MS	120	// Reset release -> Sleep Out
+#define ILI9341_CMD_WAIT_MS			5	// Sleep Out -> next command
+
 /* ---------------------------------------------------------------------------
  * SPI Pin Definitions
  * --------------------------------------------------------------------------- */
@@ -75,10 +90,21 @@ __asm__ volatile("nop\n nop"); } while (0)
  * SPI Transfer Macro
  * --------------------------------------------------------------------------- */
 
+// Count display bytes per screen (build with -DGFX_SPI_STATS, read with gfx_spi_take())
+#ifdef GFX_SPI_STATS
+extern uint32_t gfxSpiBytes;
+#define SPI_COUNT()			(gfxSpiBytes++)
+#else
+#define SPI_COUNT()			((void)0)
+#endif
+
+#define SPI_BYTE_US_X2		9	// Time per byte x2: 4 us on the wire at 2 MHz plus the SPIF poll
+
 // Send a single byte via SPI
 #define SPI_TRANSFER(byte)   \
 do {					 \
 	SPDR = (byte);		\
+	SPI_COUNT();		\
 	while (!(SPSR & (1 << SPIF))); \
 } while (0)
 
@@ -99,6 +125,85 @@ typedef struct {
 extern Font font5x7;
 extern Font fontLarge;
 
+/* ---------------------------------------------------------------------------
+ * Overlay (Save-Under) Structures
+ * --------------------------------------------------------------------------- */
+
+#define OVERLAY_MAX_RUNS	4	// Saved runs per overlay (a frame over a plain cell needs 2)
+
+/* One run of identical pixels under an overlay frame */
+typedef struct {
+	uint16_t color;
+	uint8_t len;
+} OverlayRun;
+
+/* Rectangular frame drawn over existing content, with the pixels it covers.
+ * The caller supplies the covered pixels (the panel is not read back), so they
+ * are only as exact as the caller's model of what is on screen. */
+typedef struct {
+	int16_t x, y;			// Top-left corner
+	uint8_t w, h;			// Outer size
+	uint8_t thickness;		// Frame thickness in pixels
+	uint8_t runCount;		// Number of saved runs
+	bool shown;				// Frame currently on screen
+	OverlayRun runs[OVERLAY_MAX_RUNS];
+} Overlay;
+
+/* ---------------------------------------------------------------------------
+ * RLE Sprite Encoding
+ * --------------------------------------------------------------------------- */
+// A sprite frame is a list of one-byte runs over its box in raster order:
+// palette index in the top 3 bits, run length - 1 in the low 5 bits.
+#define SPRITE_RUN(index, len)	((uint8_t)((index) << 5 | ((len) - 1)))
+#define SPRITE_COLORS		7		// Palette entries a run can name
+#define SPRITE_SKIP			7		// Run index that leaves its pixels as they are
+#define SPRITE_END			0xFF	// Leaves the rest of the frame as it is (a skip of 32)
+
+/* ---------------------------------------------------------------------------
+ * Draw-Call Capture (build with -DGFX_CAPTURE)
+ * --------------------------------------------------------------------------- */
+// High-level draw calls are logged as compact records and sent on the UART as
+// "G" lines between game frames, for a host viewer to replay into a 320x240
+// image. Peers drop "G" lines as unknown. Without GFX_CAPTURE the hooks are empty.
+
+/* Record ops (low nibble of the record header) */
+enum {
+	CAP_SCREEN = 1,			// color							fillScreen
+	CAP_RECT,				// pos w h color					fillRect, fast lines, pixels
+	CAP_TEXT,				// pos style color bg len chars		drawString / drawChar (SRAM)
+	CAP_TEXT_P,				// pos style color bg addr			drawString_P (flash address = string id)
+	CAP_CELL,				// row<<4|col color					draw_cell (CAP_F_NEAR = enemy grid; fg/bg hold the last two cell colours)
+	CAP_IMAGE				// pos scale						displayImage (EEPROM splash image)
+};
+
+/* Record header flags (high nibble) */
+#define CAP_F_NEAR			0x10	// pos is (dx, dy) as two int8 from the previous record, else x, y as int16
+#define CAP_F_SAME_FG		0x20	// color omitted: same as the previous record
+#define CAP_F_SAME_BG		0x40	// bg omitted: same as the previous record
+
+#ifdef GFX_CAPTURE
+void	gfx_capture_screen(uint16_t color);
+void	gfx_capture_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void	gfx_capture_text(int16_t x, int16_t y, const char *s, bool progmem,
+						 uint16_t color, uint16_t bg, uint8_t size, uint8_t rotation);
+void	gfx_capture_cell(uint8_t grid, uint8_t row, uint8_t col, uint16_t color);
+void	gfx_capture_image(int16_t x, int16_t y, uint8_t scale);
+void	gfx_capture_suspend(void);
+void	gfx_capture_resume(void);
+void	gfx_capture_tick(void);
+void	gfx_capture_yield(void);
+#else
+#define gfx_capture_screen(color)							((void)0)
+#define gfx_capture_rect(x, y, w, h, color)					((void)0)
+#define gfx_capture_text(x, y, s, p, c, bg, sz, rot)		((void)0)
+#define gfx_capture_cell(grid, row, col, color)				((void)0)
+#define gfx_capture_image(x, y, scale)						((void)0)
+#define gfx_capture_suspend()								((void)0)
+#define gfx_capture_resume()								((void)0)
+#define gfx_capture_tick()									((void)0)
+#define gfx_capture_yield()									((void)0)
+#endif
+
 /* ---------------------------------------------------------------------------
  * Function Prototypes
  * --------------------------------------------------------------------------- */
@@ -107,6 +212,12 @@ extern Font fontLarge;
 void	spi_init(void);
 void	ili9341_init(void);
 
+/* Initialization steps (see ILI9341_*_WAIT_MS for the waits between them) */
+void	ili9341_reset(void);
+void	ili9341_configure(void);
+void	ili9341_sleep_out(void);
+void	ili9341_display_on(void);
+
 /* Command and data transmission */
 void	ili9341_send_command(uint8_t cmd);
 void	ili9341_send_command_bytes(uint8_t cmd, const uint8_t *data, uint8_t len);
@@ -116,16 +227,20 @@ void	ili9341_send_data16(uint16_t data);
 /* Low-level graphics primitives */
 void	ili9341_set_addr_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 void	drawPixel(uint16_t x, uint16_t y, uint16_t color);
+void	ili9341_push_color(uint16_t color, uint32_t count);
 void	fillScreen(uint16_t color);
 
 /* Fast horizontal and vertical line drawing */
 void	drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
 void	drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 void	drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+void	drawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, uint16_t color);
+void	drawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color, uint16_t bg);
 
 /* Shape drawing functions */
 void	drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
 void	fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void	fillCellBlock(int16_t x, int16_t y, uint8_t rows, uint8_t cols, uint8_t size, const uint16_t *colors, uint16_t outline);
 void	fillRectBorder(int16_t rect_x, int16_t rect_y, int16_t rect_w, int16_t rect_h, int16_t border_size, uint16_t color);
 void	drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
 void	fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
@@ -135,6 +250,18 @@ void	drawRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h, int16_t radius,
 void	fillRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h, int16_t radius, uint16_t color);
 void	fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color);
 
+/* Bitmap drawing */
+void	drawBitmap_P(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *bits, uint16_t color, uint16_t bg);
+const uint8_t *drawSpriteFrame_P(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *runs, const uint16_t *palette);
+
+/* Overlay (save-under) functions */
+uint16_t overlay_frame_pixels(uint8_t w, uint8_t h, uint8_t thickness);
+void	overlay_show(Overlay *o, int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t thickness,
+					 uint16_t color, const OverlayRun *under, uint8_t runCount);
+void	overlay_recolor(Overlay *o, uint16_t color);
+void	overlay_hide(Overlay *o);
+void	overlay_discard(Overlay *o);
+
 /* Text rendering functions */
 void	drawChar(int16_t x, int16_t y, char c, uint16_t color, uint16_t bg, uint8_t size, const Font *font, uint8_t rotation);
 void	drawString(int16_t x, int16_t y, const char *s, uint16_t color, uint16_t bg, uint8_t size, const Font *font, uint8_t rotation);
@@ -144,4 +271,9 @@ void	drawString_P(int16_t x, int16_t y, const char *s_progmem, uint16_t color, u
 /* Color helper */
 uint16_t rgb(uint8_t r, uint8_t g, uint8_t b);
 
+#ifdef GFX_SPI_STATS
+/* Bytes sent since the last call */
+uint32_t gfx_spi_take(void);
+#endif
+
 #endif  // GFX_H
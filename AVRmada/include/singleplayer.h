@@ -30,15 +30,21 @@ void sp_reset(void);
 
 void sp_tick(void);
 
-/* Fill the AI board with ships using RNG */
+/* Fill the AI board with ships using RNG (best of several fleets on harder settings) */
 void ai_place_random(void);
 
-/* The algorithm used by the AI to determine which player square to attack */
-void ai_attack_algorithm(int* row_to_attack, int* col_to_attack);
+/* The algorithm used by the AI to determine which player square to attack;
+ * returns true when it would rather radar-scan around that square */
+bool ai_attack_algorithm(int* row_to_attack, int* col_to_attack);
 
 /*  Called from main.c instead of sending real UART traffic */
 void sp_on_tx_ready(uint16_t self_token);
 void sp_on_tx_attack(uint8_t row, uint8_t col);
 void sp_on_tx_result(uint8_t row, uint8_t col, bool hit);   // (unused for now)
+void sp_on_tx_scan(uint8_t seq, uint8_t row, uint8_t col);
+void sp_on_tx_scan_result(uint8_t row, uint8_t col, uint8_t count);
+
+/*  Called from main.c when the game ends (win or lose) */
+void sp_on_game_over(void);
 
 #endif /* SINGLEPLAYER_H */
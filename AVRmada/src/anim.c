@@ -0,0 +1,261 @@
+/* ---------------------------------------------------------------------------
+ * anim.c - Implementation of the Non-Blocking Animation Timeline
+ *
+ * Each track is a list of frames spaced `interval` ms apart. anim_tick()
+ * counts down every track and draws the frames that are due, up to
+ * ANIM_BUDGET_PX pixels per tick; frames over the budget wait for the next
+ * tick. Tracks are served round-robin so one busy track can't starve others.
+ *
+ * v2.0
+ * Copyright (c) 2025 Peter Kamp
+ * --------------------------------------------------------------------------- */
+#include "anim.h"
+#include <avr/pgmspace.h>
+
+/* ---------------------------------------------------------------------------
+ * Track State
+ * --------------------------------------------------------------------------- */
+typedef enum {
+	ANIM_IDLE,
+	ANIM_FADE_TEXT,
+	ANIM_BLINK,
+	ANIM_SPRITE
+} AnimKind;
+
+typedef struct {
+	uint8_t  kind;			// AnimKind
+	uint8_t  frame;			// Frames drawn so far
+	uint8_t  frames;		// Total frames (ANIM_FOREVER = until stopped)
+	uint16_t interval;		// ms between frames
+	uint16_t wait;			// ms until the next frame is due
+	uint16_t cost;			// Pixels drawn per frame
+	union {
+		struct {
+			int16_t x, y;
+			const char *text;		// PROGMEM string
+			const uint16_t *ramp;	// PROGMEM colours, one per frame
+			uint16_t bg;
+			uint8_t size;
+		} fade;
+		struct {
+			AnimBlinkFn draw;
+		} blink;
+		struct {
+			int16_t x, y;
+			const uint8_t *runs;		// PROGMEM runs of the next frame
+			const uint16_t *palette;	// PROGMEM colours; [0] is the final one
+			uint8_t w, h;
+		} sprite;
+	};
+} AnimTrack;
+
+static AnimTrack tracks[ANIM_MAX_TRACKS];
+static uint8_t nextTrack = 0;		// Round-robin start for the next tick
+
+/**
+ * Claim an idle track and fill in the timing shared by all kinds.
+ */
+static int8_t anim_alloc(uint8_t kind, uint8_t frames, uint16_t interval, uint16_t delay, uint16_t cost) {
+	for (uint8_t i = 0; i < ANIM_MAX_TRACKS; i++) {
+		if (tracks[i].kind == ANIM_IDLE) {
+			tracks[i].kind	   = kind;
+			tracks[i].frame	   = 0;
+			tracks[i].frames   = frames;
+			tracks[i].interval = interval;
+			tracks[i].wait	   = delay;
+			tracks[i].cost	   = cost;
+			return i;
+		}
+	}
+	return ANIM_NONE;
+}
+
+/* ---------------------------------------------------------------------------
+ * Frame Drawing
+ * --------------------------------------------------------------------------- */
+
+/**
+ * Draw frame `t->frame` of a track.
+ */
+static void anim_draw(AnimTrack *t) {
+	switch (t->kind) {
+		case ANIM_FADE_TEXT: {
+			uint16_t colour = pgm_read_word(&t->fade.ramp[t->frame]);
+			drawString_P(t->fade.x, t->fade.y, t->fade.text, colour, t->fade.bg, t->fade.size, &font5x7, 0);
+			break;
+		}
+		case ANIM_BLINK:
+			// Even frames switch off, odd frames back on; the track starts from "on"
+			t->blink.draw(t->frame & 1);
+			break;
+		case ANIM_SPRITE:
+			t->sprite.runs = drawSpriteFrame_P(t->sprite.x, t->sprite.y, t->sprite.w, t->sprite.h,
+											   t->sprite.runs, t->sprite.palette);
+			break;
+	}
+}
+
+/* ---------------------------------------------------------------------------
+ * Starting Tracks
+ * --------------------------------------------------------------------------- */
+
+/**
+ * Fade a PROGMEM string in place through `rampLen` ramp colours, starting
+ * after `delay` ms and changing colour every `interval` ms.
+ */
+int8_t anim_fade_text(int16_t x, int16_t y, const char *text, uint8_t size, uint16_t bg,
+					  const uint16_t *ramp, uint8_t rampLen, uint16_t interval, uint16_t delay) {
+	uint16_t glyphPx = (uint16_t)font5x7.width * font5x7.height * size * size;
+	int8_t id = anim_alloc(ANIM_FADE_TEXT, rampLen, interval, delay, glyphPx * strlen_P(text));
+	if (id == ANIM_NONE)
+		return ANIM_NONE;
+
+	AnimTrack *t = &tracks[id];
+	t->fade.x	 = x;
+	t->fade.y	 = y;
+	t->fade.text = text;
+	t->fade.ramp = ramp;
+	t->fade.bg	 = bg;
+	t->fade.size = size;
+	return id;
+}
+
+/**
+ * Blink a region drawn by `draw` (which writes about `pixels` pixels), toggling
+ * every `interval` ms. The region must already be drawn "on"; the first toggle
+ * switches it off. `toggles` = ANIM_FOREVER blinks until stopped.
+ */
+int8_t anim_blink(AnimBlinkFn draw, uint16_t pixels, uint16_t interval, uint8_t toggles) {
+	int8_t id = anim_alloc(ANIM_BLINK, toggles, interval, interval, pixels);
+	if (id != ANIM_NONE)
+		tracks[id].blink.draw = draw;
+	return id;
+}
+
+/**
+ * Play `frames` frames of an RLE sprite (see SPRITE_RUN) in the box at
+ * (x, y), `interval` ms apart. The first frame is drawn straight away and
+ * must write every pixel; later ones write only what changed. The last frame
+ * must leave the box filled with palette[0], so finishing the track early
+ * can fill it in one go. With no free track the box gets palette[0] at once.
+ */
+int8_t anim_sprite(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *runs,
+				   const uint16_t *palette, uint8_t frames, uint16_t interval) {
+	// A frame can write the whole box
+	int8_t id = (frames > 1) ? anim_alloc(ANIM_SPRITE, frames, interval, interval, (uint16_t)w * h) : ANIM_NONE;
+	if (id == ANIM_NONE) {
+		fillRect(x, y, w, h, pgm_read_word(&palette[0]));
+		return ANIM_NONE;
+	}
+
+	AnimTrack *t = &tracks[id];
+	t->sprite.x		  = x;
+	t->sprite.y		  = y;
+	t->sprite.runs	  = runs;
+	t->sprite.palette = palette;
+	t->sprite.w		  = w;
+	t->sprite.h		  = h;
+
+	anim_draw(t);
+	t->frame = 1;
+	return id;
+}
+
+/* ---------------------------------------------------------------------------
+ * Stepping
+ * --------------------------------------------------------------------------- */
+
+/**
+ * Advance every track by 1 ms and draw the frames that are due. The first
+ * due frame is always drawn; more are drawn while they fit in ANIM_BUDGET_PX.
+ */
+void anim_tick(void) {
+	uint16_t budget = ANIM_BUDGET_PX;
+	bool drewAny = false;
+
+	for (uint8_t n = 0; n < ANIM_MAX_TRACKS; n++) {
+		uint8_t i = (nextTrack + n) % ANIM_MAX_TRACKS;
+		AnimTrack *t = &tracks[i];
+
+		if (t->kind == ANIM_IDLE)
+			continue;
+		if (t->wait) {
+			t->wait--;
+			continue;
+		}
+		if (drewAny && t->cost > budget)
+			continue;		// Due, but over budget: try again next tick
+
+		anim_draw(t);
+		budget = (t->cost > budget) ? 0 : budget - t->cost;
+		if (!drewAny)
+			nextTrack = (i + 1) % ANIM_MAX_TRACKS;
+		drewAny = true;
+
+		t->wait = t->interval;
+		if (++t->frame == t->frames)
+			t->kind = ANIM_IDLE;
+		else if (t->frames == ANIM_FOREVER && t->frame == 2)
+			t->frame = 0;	// Endless blink: keep the phase in 0..1
+	}
+}
+
+/**
+ * True while any track is running.
+ */
+bool anim_active(void) {
+	for (uint8_t i = 0; i < ANIM_MAX_TRACKS; i++) {
+		if (tracks[i].kind != ANIM_IDLE)
+			return true;
+	}
+	return false;
+}
+
+/* ---------------------------------------------------------------------------
+ * Interrupting
+ * --------------------------------------------------------------------------- */
+
+/**
+ * Jump a track to its final frame and end it. A blink ends in the "on" phase.
+ */
+void anim_finish(int8_t id) {
+	if (id < 0 || id >= ANIM_MAX_TRACKS || tracks[id].kind == ANIM_IDLE)
+		return;
+
+	AnimTrack *t = &tracks[id];
+	if (t->kind == ANIM_BLINK) {
+		if (t->frame & 1)
+			t->blink.draw(true);
+	} else if (t->kind == ANIM_SPRITE) {
+		// Frames are deltas: fill in the final frame rather than replay them
+		fillRect(t->sprite.x, t->sprite.y, t->sprite.w, t->sprite.h, pgm_read_word(&t->sprite.palette[0]));
+	} else {
+		t->frame = t->frames - 1;
+		anim_draw(t);
+	}
+	t->kind = ANIM_IDLE;
+}
+
+/**
+ * Finish every running track (e.g. when input interrupts an intro).
+ */
+void anim_finish_all(void) {
+	for (uint8_t i = 0; i < ANIM_MAX_TRACKS; i++)
+		anim_finish(i);
+}
+
+/**
+ * End a track without drawing anything.
+ */
+void anim_stop(int8_t id) {
+	if (id >= 0 && id < ANIM_MAX_TRACKS)
+		tracks[id].kind = ANIM_IDLE;
+}
+
+/**
+ * End every track without drawing (e.g. before a screen is cleared).
+ */
+void anim_stop_all(void) {
+	for (uint8_t i = 0; i < ANIM_MAX_TRACKS; i++)
+		tracks[i].kind = ANIM_IDLE;
+}
@@ -0,0 +1,61 @@
+/* ---------------------------------------------------------------------------
+ * arena.c - Implementation of the Phase-Scoped SRAM Arena
+ *
+ * A bump allocator over one static pool. Nothing is freed individually:
+ * arena_enter() drops every buffer of the old phase, and arena_release()
+ * rewinds to a mark taken before a short-lived scratch allocation.
+ *
+ * v2.0
+ * Copyright (c) 2025 Peter Kamp
+ * --------------------------------------------------------------------------- */
+#include "arena.h"
+#include <stddef.h>
+
+static uint8_t  pool[ARENA_SIZE];
+static uint16_t used = 0;					// Bytes handed out in the current phase
+static uint8_t  phase = ARENA_MENU;
+static uint16_t peak[ARENA_PHASES];			// High-water mark per phase
+
+/**
+ * Start `newPhase` with an empty pool. Pointers from the old phase are dead.
+ */
+void arena_enter(ArenaPhase newPhase) {
+	phase = newPhase;
+	used = 0;
+}
+
+/**
+ * Hand out `size` bytes from the pool, or NULL if they don't fit.
+ */
+void *arena_alloc(uint16_t size) {
+	if (size > ARENA_SIZE - used)
+		return NULL;
+
+	void *p = &pool[used];
+	used += size;
+	if (used > peak[phase])
+		peak[phase] = used;
+	return p;
+}
+
+/**
+ * Current fill level, to hand scratch back with arena_release().
+ */
+uint16_t arena_mark(void) {
+	return used;
+}
+
+/**
+ * Free everything allocated since `mark` was taken.
+ */
+void arena_release(uint16_t mark) {
+	if (mark < used)
+		used = mark;
+}
+
+/**
+ * Highest fill level seen in `p` (bytes).
+ */
+uint16_t arena_peak(ArenaPhase p) {
+	return (p < ARENA_PHASES) ? peak[p] : 0;
+}
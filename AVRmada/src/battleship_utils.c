@@ -11,12 +11,16 @@
 #endif
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
+#include <avr/pgmspace.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "gfx.h"
+#include "anim.h"
+#include "arena.h"
 #include "eeprom.h"
 #include "battleship_utils.h"
 #include "strings.h"
@@ -27,23 +31,23 @@
 const uint8_t SHIP_LENGTHS[NUM_SHIPS] = {5, 4, 3, 3, 2};
 
 /* -------------------------------------------------------------------------
- *  BOARD BITMAPS
+ *  OVERLAYS (cursor frame and ghost segments drawn over grid cells)
  * ------------------------------------------------------------------------- */
-uint8_t playerOccupiedBitmap   [BITMAP_SIZE];		// Where all of the player's ships actually are, set from the start of the game
-uint8_t playerAttackedAtBitmap [BITMAP_SIZE];		// All of the squares the player has been attacked at, up to now	
-uint8_t enemyConfirmedHitBitmap[BITMAP_SIZE];		// All of the *confirmed* enemy ship squares that have been hit, up to now
-uint8_t enemyAttackedAtBitmap  [BITMAP_SIZE];		// All of the squares the enemy player has been attacked at, up to now	
+#define GHOST_SEGMENT_PX	(CELL_SIZE_PX - 2)			// A ghost segment fills the cell inside its outline
+
+static Overlay cursorOverlay;						// Selection cursor
+static Overlay ghostOverlays[MAX_SHIP_LENGTH];		// One filled overlay per ghost ship segment
+static bool	ghostValid;							// Placement validity the ghost segments are drawn with
 
 /* -------------------------------------------------------------------------
  *  PSEUDO-RANDOM GENERATOR (16-bit LFSR)
  * ------------------------------------------------------------------------- */
-static uint16_t lfsr; // LFSR internal state
 
 /**
  * Seed the LFSR with a nonzero value.
  */
 void srand16(uint16_t seed) {
-	lfsr = seed ? seed : 0xACE1u; // Default seed if 0 provided
+	game.lfsr = seed ? seed : 0xACE1u; // Default seed if 0 provided
 }
 
 /**
@@ -51,8 +55,8 @@ void srand16(uint16_t seed) {
  */
 uint16_t rand16(void) {
 	// Standard Galois 16-bit LFSR feedback polynomial
-	lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
-	return lfsr;
+	game.lfsr = (game.lfsr >> 1) ^ (-(game.lfsr & 1u) & 0xB400u);
+	return game.lfsr;
 }
 
 /**
@@ -122,6 +126,21 @@ bool button_is_pressed(void) {
 /* -------------------------------------------------------------------------
  *  DRAWING PRIMITIVES
  * ------------------------------------------------------------------------- */
+/**
+ * Forget any overlay sitting on the cell at pixel (x, y); the cell is about
+ * to be repainted, so the pixels saved under the overlay are stale.
+ * Ghost segments sit 1 px inside the cell.
+ */
+static void overlays_discard_at(int16_t x, int16_t y) {
+	if (cursorOverlay.shown && cursorOverlay.x == x && cursorOverlay.y == y)
+		overlay_discard(&cursorOverlay);
+
+	for (uint8_t k = 0; k < MAX_SHIP_LENGTH; ++k) {
+		if (ghostOverlays[k].shown && ghostOverlays[k].x == x + 1 && ghostOverlays[k].y == y + 1)
+			overlay_discard(&ghostOverlays[k]);
+	}
+}
+
 /**
  * Draw a single cell at (row, col) with given color and X origin.
  */
@@ -129,19 +148,221 @@ void draw_cell(uint8_t row, uint8_t col, uint16_t colour, uint16_t originX) {
 	int16_t x = originX + col * CELL_SIZE_PX;
 	int16_t y = GRID_Y_PX + row * CELL_SIZE_PX;
 
-	fillRect(x, y, CELL_SIZE_PX, CELL_SIZE_PX, colour);
+	gfx_capture_cell(originX == ENEMY_GRID_X_PX, row, col, colour);
+	gfx_capture_suspend();
+	overlays_discard_at(x, y);
+	fillRect(x + 1, y + 1, CELL_SIZE_PX - 2, CELL_SIZE_PX - 2, colour);	// Inside only: the outline covers the rest
 	drawRect(x, y, CELL_SIZE_PX, CELL_SIZE_PX, CLR_BLACK); // Outline
+	gfx_capture_resume();
+}
+
+/* Shot sprites: SHOT_FRAMES RLE frames of SHOT_SPRITE_PX square each (see
+ * SPRITE_RUN), made on a host from concentric rings. Each frame after the key
+ * frame writes only the pixels that changed, plus gaps too short to be worth
+ * a new address window; the last frame settles on the cell's final colour. */
+_Static_assert(SHOT_SPRITE_PX == 12, "Shot sprites are drawn for a 12 px box");
+
+static const uint16_t BOOM_PALETTE[] PROGMEM = {
+	CLR_HIT, RGB565(255,255,160), CLR_YELLOW, CLR_ORANGE, RGB565(128,0,0), CLR_DARK_GRAY
+};
+static const uint8_t BOOM_RUNS[] PROGMEM = {
+	// Frame 0 (key)
+	0x1C, 0x61, 0x07, 0x61, 0x41, 0x61, 0x05, 0x60, 0x40, 0x21, 0x40, 0x60, 0x04, 0x60, 0x40, 0x23,
+	0x40, 0x60, 0x03, 0x60, 0x40, 0x23, 0x40, 0x60, 0x04, 0x60, 0x40, 0x21, 0x40, 0x60, 0x05, 0x61,
+	0x41, 0x61, 0x07, 0x61, 0x1C,
+	// Frame 1
+	0xF0, 0x61, 0xE6, 0x62, 0x41, 0x62, 0x03, 0x60, 0x45, 0x60, 0x03, 0x60, 0x40, 0x23, 0x40, 0x60,
+	0x02, 0x60, 0x41, 0x23, 0x41, 0x60, 0x01, 0x60, 0x41, 0x23, 0x41, 0x60, 0x02, 0x60, 0x40, 0x23,
+	0x40, 0x60, 0x03, 0x60, 0x45, 0x60, 0x03, 0x62, 0x41, 0x62, 0xE6, 0x61, 0xFF,
+	// Frame 2
+	0xE4, 0x81, 0x05, 0x83, 0x61, 0x83, 0x01, 0x81, 0x65, 0x81, 0x01, 0x80, 0x62, 0x41, 0x62, 0x80,
+	0x01, 0x80, 0x61, 0x43, 0x61, 0x80, 0x00, 0x80, 0x61, 0x45, 0x61, 0x81, 0x61, 0x45, 0x61, 0x80,
+	0x00, 0x80, 0x61, 0x43, 0x61, 0x80, 0x01, 0x80, 0x62, 0x41, 0x62, 0x80, 0x01, 0x81, 0x65, 0x81,
+	0x01, 0x83, 0x61, 0x83, 0x05, 0x81, 0xFF,
+	// Frame 3
+	0xE2, 0xA0, 0x03, 0xA0, 0x04, 0xA7, 0x03, 0xA2, 0x81, 0xA2, 0x03, 0xA0, 0x85, 0xA0, 0x02, 0xA1,
+	0x81, 0x61, 0x81, 0xA1, 0x00, 0xA1, 0x81, 0x63, 0x81, 0xA3, 0x81, 0x63, 0x81, 0xA1, 0x00, 0xA1,
+	0x81, 0x61, 0x81, 0xA1, 0x02, 0xA0, 0x85, 0xA0, 0x03, 0xA2, 0x81, 0xA2, 0x03, 0xA7, 0x04, 0xA0,
+	0x03, 0xA0, 0xFF,
+	// Frame 4
+	0xE2, 0x0D, 0x81, 0x1F, 0x00, 0xA3, 0x04, 0x80, 0x01, 0xA3, 0x01, 0x80, 0x01, 0x80, 0x01, 0xA3,
+	0x01, 0x80, 0x04, 0xA3, 0x1F, 0x00, 0x81, 0x0D, 0xFF,
+	// Frame 5
+	0xF0, 0x01, 0xFE, 0xE1, 0x0C, 0xA1, 0x09, 0xA1, 0x0C, 0xFE, 0xE1, 0x01, 0xFF,
+	// Frame 6
+	0xFE, 0xFE, 0xE2, 0x01, 0xE9, 0x01, 0xFF,
+};
+
+static const uint16_t SPLASH_PALETTE[] PROGMEM = {
+	CLR_MISS, CLR_NAVY, RGB565(0,48,160), RGB565(64,128,255), RGB565(192,224,255)
+};
+static const uint8_t SPLASH_RUNS[] PROGMEM = {
+	// Frame 0 (key)
+	0x3F, 0x33, 0x63, 0x27, 0x60, 0x81, 0x60, 0x27, 0x60, 0x81, 0x60, 0x27, 0x63, 0x3F, 0x33,
+	// Frame 1
+	0xFC, 0x41, 0xE7, 0x41, 0x81, 0x41, 0x25, 0x40, 0x80, 0x61, 0x80, 0x40, 0x24, 0x40, 0x80, 0x63,
+	0x80, 0x40, 0x23, 0x40, 0x80, 0x63, 0x80, 0x40, 0x24, 0x40, 0x80, 0x61, 0x80, 0x40, 0x25, 0x41,
+	0x81, 0x41, 0xE7, 0x41, 0xFF,
+	// Frame 2
+	0xEF, 0x63, 0x25, 0x61, 0x83, 0x61, 0x23, 0x60, 0x80, 0x43, 0x80, 0x60, 0x22, 0x60, 0x80, 0x45,
+	0x80, 0x60, 0x21, 0x60, 0x80, 0x41, 0x81, 0x41, 0x80, 0x60, 0x21, 0x60, 0x80, 0x41, 0x81, 0x41,
+	0x80, 0x60, 0x21, 0x60, 0x80, 0x45, 0x80, 0x60, 0x22, 0x60, 0x80, 0x43, 0x80, 0x60, 0x23, 0x61,
+	0x83, 0x61, 0x25, 0x63, 0xFF,
+	// Frame 3
+	0x44, 0x81, 0x47, 0x85, 0x44, 0x80, 0x65, 0x80, 0x42, 0x80, 0x67, 0x80, 0x41, 0x80, 0x62, 0x81,
+	0x62, 0x80, 0x40, 0x81, 0x61, 0x83, 0x61, 0x83, 0x61, 0x83, 0x61, 0x81, 0x40, 0x80, 0x62, 0x81,
+	0x62, 0x80, 0x41, 0x80, 0x67, 0x80, 0x42, 0x80, 0x65, 0x80, 0x44, 0x85, 0x47, 0x81, 0x44,
+	// Frame 4
+	0x6E, 0x85, 0x64, 0x87, 0x62, 0x83, 0x01, 0x83, 0x61, 0x82, 0x03, 0x82, 0x61, 0x81, 0x05, 0x81,
+	0x61, 0x81, 0x05, 0x81, 0x61, 0x82, 0x03, 0x82, 0x61, 0x83, 0x01, 0x83, 0x62, 0x87, 0x64, 0x85,
+	0x6E,
+	// Frame 5
+	0x8F, 0x03, 0x85, 0x07, 0x83, 0x07, 0x82, 0x09, 0x81, 0x09, 0x81, 0x09, 0x81, 0x09, 0x82, 0x07,
+	0x83, 0x07, 0x85, 0x03, 0x8F,
+	// Frame 6
+	0x1F, 0x1F, 0x1F, 0x1F, 0x0F,
+};
+
+/**
+ * Paint the outcome of a shot at (row, col) and play its explosion or splash
+ * inside the cursor frame. The cell is painted its final colour first, and
+ * the sprite ends on that colour, so a board redraw mid-animation agrees.
+ */
+void draw_shot_cell(uint8_t row, uint8_t col, bool hit, uint16_t originX) {
+	draw_cell(row, col, hit ? CLR_HIT : CLR_MISS, originX);
+	anim_sprite(originX + col * CELL_SIZE_PX + CURSOR_THICKNESS_PX,
+				GRID_Y_PX + row * CELL_SIZE_PX + CURSOR_THICKNESS_PX,
+				SHOT_SPRITE_PX, SHOT_SPRITE_PX,
+				hit ? BOOM_RUNS : SPLASH_RUNS, hit ? BOOM_PALETTE : SPLASH_PALETTE,
+				SHOT_FRAMES, SHOT_FRAME_MS);
+}
+
+/**
+ * Colour of an unshot enemy cell: what our radar scans say about it.
+ * An empty scan wins over one that found ships.
+ */
+static uint16_t radar_colour(uint8_t row, uint8_t col) {
+	uint16_t colour = CLR_NAVY;
+	for (uint8_t i = 0; i < RADAR_USES; ++i) {
+		const RadarScan *scan = &game.enemyScans[i];
+		if (scan->count == RADAR_NONE || !radar_covers(scan, row, col))
+			continue;
+		if (scan->count == 0)
+			return CLR_RADAR_CLEAR;
+		colour = CLR_RADAR;
+	}
+	return colour;
+}
+
+/**
+ * Base colour of a cell as drawn on the board, from the game bitmaps. A shot
+ * awaiting its result shows its blink phase over the unshot colour.
+ */
+uint16_t cell_colour(uint8_t row, uint8_t col, uint16_t originX) {
+	if (originX == ENEMY_GRID_X_PX) {
+		bool pending = !game.pendingScan && row == game.pendingRow && col == game.pendingCol;
+		if (pending && game.pendingLit)
+			return CLR_PENDING;
+		if (pending || !BITMAP_GET(game.enemyAttackedAtBitmap, row, col))
+			return radar_colour(row, col);
+		return BITMAP_GET(game.enemyConfirmedHitBitmap, row, col) ? CLR_HIT : CLR_MISS;
+	}
+
+	bool occupied = BITMAP_GET(game.playerOccupiedBitmap, row, col);
+	if (BITMAP_GET(game.playerAttackedAtBitmap, row, col))
+		return occupied ? CLR_HIT : CLR_MISS;
+	return occupied ? CLR_SHIP : CLR_CYAN;
+}
+
+/**
+ * Show a frame overlay on the cell at (row, col). Only the frame pixels are
+ * drawn; what they cover (the black outline ring, then the cell fill) is saved
+ * so the frame can be removed without repainting the cell.
+ *
+ * The saved fill is cell_colour(), not a readback of the screen, so it is only
+ * right while every whole-cell paint agrees with cell_colour() (the pending
+ * blink included) or goes through draw_cell(), which drops the overlay. Shot
+ * sprites are drawn inside the frame and never touch the saved pixels.
+ */
+static void cell_overlay_show(Overlay *o, uint8_t row, uint8_t col, uint16_t originX, uint16_t colour) {
+	int16_t x = originX + col * CELL_SIZE_PX;
+	int16_t y = GRID_Y_PX + row * CELL_SIZE_PX;
+	uint16_t outline = overlay_frame_pixels(CELL_SIZE_PX, CELL_SIZE_PX, 1);
+
+	OverlayRun under[2] = {
+		{ CLR_BLACK, outline },
+		{ cell_colour(row, col, originX),
+		  overlay_frame_pixels(CELL_SIZE_PX, CELL_SIZE_PX, CURSOR_THICKNESS_PX) - outline }
+	};
+	overlay_show(o, x, y, CELL_SIZE_PX, CELL_SIZE_PX, CURSOR_THICKNESS_PX, colour, under, 2);
 }
 
 /**
  * Draw a highlight cursor box around a cell at (row, col).
+ * If the cursor is already shown elsewhere, that cell is restored first.
  */
 void draw_cursor(uint8_t row, uint8_t col, uint16_t originX) {
-	int16_t x = originX + col * CELL_SIZE_PX;
-	int16_t y = GRID_Y_PX  + row * CELL_SIZE_PX;
+	overlay_hide(&cursorOverlay);
+	cell_overlay_show(&cursorOverlay, row, col, originX, CLR_CURSOR);
+}
+
+/* -------------------------------------------------------------------------
+ *  RADAR
+ * ------------------------------------------------------------------------- */
+/**
+ * Whether (row, col) lies in the area `scan` covers.
+ */
+bool radar_covers(const RadarScan *scan, uint8_t row, uint8_t col) {
+	return (uint8_t)(row - scan->row + RADAR_RADIUS) < RADAR_SPAN
+		&& (uint8_t)(col - scan->col + RADAR_RADIUS) < RADAR_SPAN;
+}
+
+/**
+ * First and last row (or column) of the area around `centre`, clipped to the board.
+ */
+static void radar_span(uint8_t centre, uint8_t last, uint8_t *lo, uint8_t *hi) {
+	*lo = centre > RADAR_RADIUS ? centre - RADAR_RADIUS : 0;
+	*hi = centre + RADAR_RADIUS < last ? centre + RADAR_RADIUS : last;
+}
+
+/**
+ * Number of ship cells in the area around (row, col).
+ */
+uint8_t radar_count(const uint8_t *occupiedBitmap, uint8_t row, uint8_t col) {
+	uint8_t r0, r1, c0, c1, count = 0;
+	radar_span(row, GRID_ROWS - 1, &r0, &r1);
+	radar_span(col, GRID_COLS - 1, &c0, &c1);
+	for (uint8_t r = r0; r <= r1; ++r) {
+		for (uint8_t c = c0; c <= c1; ++c) {
+			if (BITMAP_GET(occupiedBitmap, r, c)) count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * Repaint the cells of the radar area around (row, col) on the enemy board.
+ * They go out as one block (one address window), not one draw_cell each.
+ */
+void draw_radar_area(uint8_t row, uint8_t col) {
+	uint8_t r0, r1, c0, c1;
+	radar_span(row, GRID_ROWS - 1, &r0, &r1);
+	radar_span(col, GRID_COLS - 1, &c0, &c1);
+
+	uint16_t colours[RADAR_SPAN * RADAR_SPAN];
+	uint8_t n = 0;
+	for (uint8_t r = r0; r <= r1; ++r) {
+		for (uint8_t c = c0; c <= c1; ++c, ++n) {
+			colours[n] = cell_colour(r, c, ENEMY_GRID_X_PX);
+			gfx_capture_cell(1, r, c, colours[n]);
+			overlays_discard_at(ENEMY_GRID_X_PX + c * CELL_SIZE_PX, GRID_Y_PX + r * CELL_SIZE_PX);
+		}
+	}
 
-	drawRect(x,	y, CELL_SIZE_PX, CELL_SIZE_PX, CLR_CURSOR);
-	drawRect(x+1,  y+1, CELL_SIZE_PX - 2, CELL_SIZE_PX - 2, CLR_CURSOR);
+	gfx_capture_suspend();
+	fillCellBlock(ENEMY_GRID_X_PX + c0 * CELL_SIZE_PX, GRID_Y_PX + r0 * CELL_SIZE_PX,
+				  r1 - r0 + 1, c1 - c0 + 1, CELL_SIZE_PX, colours, CLR_BLACK);
+	gfx_capture_resume();
 }
 
 /* -------------------------------------------------------------------------
@@ -176,15 +397,22 @@ void status_msg(const char *msg) {
  *  BOARD UTILITY ROUTINES
  * ------------------------------------------------------------------------- */
 /**
- * Reset both player and enemy grids to empty.
+ * Reset both player and enemy grids to empty, the radar and any pending shot.
  */
 void board_reset(void) {
-	memset(playerOccupiedBitmap,     0, BITMAP_SIZE);
-	memset(playerAttackedAtBitmap,   0, BITMAP_SIZE);
-	memset(enemyConfirmedHitBitmap,  0, BITMAP_SIZE);
-	memset(enemyAttackedAtBitmap,	 0, BITMAP_SIZE);
-	playerRemaining = 0;
-	enemyRemaining  = 0;
+	memset(game.playerOccupiedBitmap,     0, BITMAP_SIZE);
+	memset(game.playerAttackedAtBitmap,   0, BITMAP_SIZE);
+	memset(game.enemyConfirmedHitBitmap,  0, BITMAP_SIZE);
+	memset(game.enemyAttackedAtBitmap,	 0, BITMAP_SIZE);
+	game.playerRemaining = 0;
+	game.enemyRemaining  = 0;
+
+	for (uint8_t i = 0; i < RADAR_USES; ++i)
+		game.enemyScans[i].count = RADAR_NONE;
+	game.radarLeft	 = RADAR_USES;
+	game.peerScans	 = 0;
+	game.pendingScan = false;
+	game.pendingRow	 = game.pendingCol = -1;
 }
 
 /**
@@ -205,30 +433,103 @@ bool ship_can_fit(const uint8_t *occupiedBitmap, uint8_t row, uint8_t col, uint8
 	return true;
 }
 
+_Static_assert(GRID_COLS <= 16, "Row-word boards hold a row in 16 bits");
+
+/**
+ * Unpack a bitmap into one word per row (bit c = column c).
+ */
+void bitmap_to_rows(const uint8_t *bitmap, uint16_t *rows) {
+	uint8_t i = 0;		// Flat bit index, walked in storage order
+	for (uint8_t r = 0; r < GRID_ROWS; ++r) {
+		uint16_t w = 0;
+		for (uint8_t c = 0; c < GRID_COLS; ++c, ++i) {
+			if (bitmap[i >> 3] & (1u << (i & 7))) w |= 1u << c;
+		}
+		rows[r] = w;
+	}
+}
+
+/**
+ * Every column of `row` where a ship of length len fits, as a mask.
+ * Horizontal: smear each occupied cell left over the len-1 starts it blocks.
+ * Vertical: OR the len rows the ship would cover.
+ */
+uint16_t ship_fit_row(const uint16_t *rows, uint8_t row, uint8_t len, bool horizontal) {
+	uint16_t blocked = 0;
+	if (horizontal) {
+		if (len > GRID_COLS) return 0;
+		for (uint8_t k = 0; k < len; ++k) blocked |= rows[row] >> k;
+		return ~blocked & (GRID_ROW_MASK >> (len - 1));
+	}
+	if (row + len > GRID_ROWS) return 0;
+	for (uint8_t k = 0; k < len; ++k) blocked |= rows[row + k];
+	return ~blocked & GRID_ROW_MASK;
+}
+
 /* -------------------------------------------------------------------------
  *  SHIP PLACEMENT HELPERS
  * ------------------------------------------------------------------------- */
 /**
- * Draw or erase ghost preview of ship placement at (row, col).
+ * Index of the footprint segment that overlay `o` sits on, or -1 if the
+ * overlay is outside the footprint of a ship at (row, col).
+ */
+static int8_t ghost_segment_at(const Overlay *o, uint8_t row, uint8_t col, bool horizontal, uint8_t len) {
+	uint8_t r = (o->y - GRID_Y_PX) / CELL_SIZE_PX;
+	uint8_t c = (o->x - PLAYER_GRID_X_PX) / CELL_SIZE_PX;
+
+	if (horizontal && r == row && c >= col && c < col + len)
+		return c - col;
+	if (!horizontal && c == col && r >= row && r < row + len)
+		return r - row;
+	return -1;
+}
+
+/**
+ * Move the ghost preview of the current ship to (row, col).
+ *
+ * Each ghost segment is an overlay filling the inside of its cell, so it looks
+ * like a cell painted in the ghost colour. Only the difference between the
+ * shown and the new footprint is drawn: leaving cells get their fill back,
+ * entering cells get a new segment, and cells in both are recoloured only if
+ * placement validity changed. Segments dropped by draw_cell() (e.g. after
+ * placing a ship) count as not shown.
  */
-void ghost_update(uint8_t row, uint8_t col, bool horizontal, bool draw) {
-	uint8_t len = SHIP_LENGTHS[ghostShipIdx];
-	bool valid = ship_can_fit(playerOccupiedBitmap, row, col, len, horizontal);
+void ghost_update(uint8_t row, uint8_t col, bool horizontal) {
+	uint8_t len = SHIP_LENGTHS[game.ghostShipIdx];
+	bool valid = ship_can_fit(game.playerOccupiedBitmap, row, col, len, horizontal);
 	uint16_t colour = valid ? CLR_GHOST_OK : CLR_GHOST_BAD;
+	uint8_t covered = 0;	// Bit k set = segment k is already shown
 
-	for (uint8_t k = 0; k < len; ++k) {
+	for (uint8_t i = 0; i < MAX_SHIP_LENGTH; ++i) {
+		Overlay *o = &ghostOverlays[i];
+		if (!o->shown)
+			continue;
+
+		int8_t k = ghost_segment_at(o, row, col, horizontal, len);
+		if (k < 0) {
+			overlay_hide(o);
+		} else {
+			covered |= 1 << k;
+			if (valid != ghostValid)
+				overlay_recolor(o, colour);
+		}
+	}
+	ghostValid = valid;
+
+	for (uint8_t k = 0, slot = 0; k < len; ++k) {
 		uint8_t r = row + (horizontal ? 0 : k);
 		uint8_t c = col + (horizontal ? k : 0);
 
-		if (r >= GRID_ROWS || c >= GRID_COLS)
+		if ((covered & (1 << k)) || r >= GRID_ROWS || c >= GRID_COLS)
 			continue;
 
-		if (draw) {
-			draw_cell(r, c, colour, PLAYER_GRID_X_PX);
-		} else {
-			uint16_t base = BITMAP_GET(playerOccupiedBitmap, r, c) ? CLR_SHIP : CLR_CYAN;
-			draw_cell(r, c, base, PLAYER_GRID_X_PX);
-		}
+		while (ghostOverlays[slot].shown)
+			++slot;
+
+		// Inside the black outline; the segment is as thick as half its width
+		OverlayRun under = { cell_colour(r, c, PLAYER_GRID_X_PX), GHOST_SEGMENT_PX * GHOST_SEGMENT_PX };
+		overlay_show(&ghostOverlays[slot], PLAYER_GRID_X_PX + c * CELL_SIZE_PX + 1, GRID_Y_PX + r * CELL_SIZE_PX + 1,
+					 GHOST_SEGMENT_PX, GHOST_SEGMENT_PX, GHOST_SEGMENT_PX / 2, colour, &under, 1);
 	}
 }
 
@@ -236,187 +537,317 @@ void ghost_update(uint8_t row, uint8_t col, bool horizontal, bool draw) {
  * Finalize placing the current ship onto the player's grid.
  */
 void player_place_current_ship(uint8_t row, uint8_t col, bool horizontal, uint8_t len) {
-	playerFleet[ghostShipIdx] = (Ship){row, col, len, horizontal};
+	game.playerFleet[game.ghostShipIdx] = (Ship){row, col, len, horizontal};
 
 	for (uint8_t k = 0; k < len; ++k) {
 		uint8_t r = row + (horizontal ? 0 : k);
 		uint8_t c = col + (horizontal ? k : 0);
 
-		BITMAP_SET(playerOccupiedBitmap, r, c);
-		++playerRemaining;
+		BITMAP_SET(game.playerOccupiedBitmap, r, c);
+		++game.playerRemaining;
 		draw_cell(r, c, CLR_SHIP, PLAYER_GRID_X_PX);
 	}
 }
 
 /* -------------------------------------------------------------------------
- *  STATIC GUI BUILDERS
+ *  MENU WIDGETS
  * ------------------------------------------------------------------------- */
+#define WIDGET_BORDER_PX	5		// Button border thickness
+#define WIDGET_FOCUSED		0x80	// Focus bit of a widget's drawn state (low bits = value)
+
+// Settings gear, 24x24 (rows padded to 3 bytes)
+static const uint8_t ICON_GEAR[] PROGMEM = {
+	0x00, 0x1C, 0x00,	0x00, 0x1C, 0x00,	0x00, 0x1C, 0x00,	0x04, 0x1C, 0x08,
+	0x1E, 0x3E, 0x1E,	0x0F, 0xFF, 0xBC,	0x07, 0xFF, 0xF8,	0x03, 0xFF, 0xF0,
+	0x07, 0xE3, 0xF0,	0x07, 0x80, 0xF0,	0x0F, 0x80, 0xF8,	0xFF, 0x00, 0x7F,
+	0xFF, 0x00, 0x7F,	0xFF, 0x00, 0x7F,	0x0F, 0x80, 0xF8,	0x07, 0x80, 0xF0,
+	0x07, 0xE3, 0xF0,	0x03, 0xFF, 0xF0,	0x07, 0xFF, 0xF8,	0x0F, 0xFF, 0xBC,
+	0x1E, 0x3E, 0x1E,	0x04, 0x1C, 0x08,	0x00, 0x1C, 0x00,	0x00, 0x1C, 0x00
+};
+
+// Settings back arrow, 18x21 (rows padded to 3 bytes)
+static const uint8_t ICON_BACK[] PROGMEM = {
+	0x00, 0x20, 0x00,	0x00, 0x60, 0x00,	0x00, 0xE0, 0x00,	0x01, 0xE0, 0x00,
+	0x03, 0xFF, 0xC0,	0x07, 0xFF, 0xC0,	0x0F, 0xFF, 0xC0,	0x1F, 0xFF, 0xC0,
+	0x3F, 0xFF, 0xC0,	0x7F, 0xFF, 0xC0,	0xFF, 0xFF, 0xC0,	0x7F, 0xFF, 0xC0,
+	0x3F, 0xFF, 0xC0,	0x1F, 0xFF, 0xC0,	0x0F, 0xFF, 0xC0,	0x07, 0xFF, 0xC0,
+	0x03, 0xE0, 0x00,	0x01, 0xE0, 0x00,	0x00, 0xE0, 0x00,	0x00, 0x60, 0x00,
+	0x00, 0x20, 0x00
+};
+
+// Choices, indexed by soundsEnabled and AIDifficulty
+static const WidgetChoice SOUND_CHOICES[] PROGMEM = {
+	{ SOUNDS_OFF,	CLR_RED },
+	{ SOUNDS_ON,	CLR_GREEN }
+};
+
+static const WidgetChoice DIFFICULTY_CHOICES[] PROGMEM = {
+	[AI_EASY]	= { LIEUTENANT,	CLR_GREEN },
+	[AI_MEDIUM]	= { CAPTAIN,	CLR_YELLOW },
+	[AI_HARD]	= { ADMIRAL,	CLR_RED }
+};
+
+static const Widget MAIN_MENU_WIDGETS[] PROGMEM = {
+	[WID_MULTIPLAYER] = {
+		.kind = WIDGET_BUTTON, .x = 60, .y = 95, .w = 200, .h = 50, .focusColour = CLR_CYAN,
+		.label = MULTIPLAYER, .labelDx = 14, .labelDy = 14,
+		.nav = { WIDGET_NONE, WID_VERSUS_AI, WIDGET_NONE, WIDGET_NONE }
+	},
+	[WID_VERSUS_AI] = {
+		.kind = WIDGET_BUTTON, .x = 60, .y = 168, .w = 200, .h = 50, .focusColour = CLR_GREEN,
+		.label = VERSUS_AI, .labelDx = 29, .labelDy = 14,
+		.nav = { WID_MULTIPLAYER, WIDGET_NONE, WIDGET_NONE, WID_GEAR }
+	},
+	[WID_GEAR] = {
+		.kind = WIDGET_ICON, .x = 291, .y = 211, .w = 24, .h = 24, .focusColour = CLR_WHITE,
+		.bitmap = ICON_GEAR,
+		.nav = { WIDGET_NONE, WIDGET_NONE, WID_VERSUS_AI, WIDGET_NONE }
+	}
+};
+
+static const WidgetScreen MAIN_MENU_SCREEN PROGMEM = {
+	MAIN_MENU_WIDGETS, 3, { WID_MULTIPLAYER, WID_VERSUS_AI, WIDGET_NONE, WIDGET_NONE }
+};
+
+static const Widget SETTINGS_WIDGETS[] PROGMEM = {
+	[WID_SOUNDS] = {
+		.kind = WIDGET_BUTTON, .x = 60, .y = 95, .w = 200, .h = 50, .focusColour = CLR_CYAN,
+		.choices = SOUND_CHOICES, .choiceDx = 14, .choiceDy = 14, .choiceSize = 3,
+		.nav = { WIDGET_NONE, WID_DIFFICULTY, WIDGET_NONE, WIDGET_NONE }
+	},
+	[WID_DIFFICULTY] = {
+		.kind = WIDGET_BUTTON, .x = 60, .y = 168, .w = 200, .h = 50, .focusColour = CLR_ORANGE,
+		.label = AI, .labelDx = 14, .labelDy = 14,
+		.choices = DIFFICULTY_CHOICES, .choiceDx = 72, .choiceDy = 17, .choiceSize = 2,
+		.nav = { WID_SOUNDS, WIDGET_NONE, WID_BACK, WIDGET_NONE }
+	},
+	[WID_BACK] = {
+		.kind = WIDGET_ICON, .x = 7, .y = 213, .w = 18, .h = 21, .focusColour = CLR_WHITE,
+		.bitmap = ICON_BACK,
+		.nav = { WIDGET_NONE, WIDGET_NONE, WIDGET_NONE, WID_DIFFICULTY }
+	}
+};
 
-/*
- * Draw the initial main menu screen.
- */
-void gui_draw_main_menu(void) {
-	fillScreen(CLR_MM_BG);
+static const WidgetScreen SETTINGS_SCREEN PROGMEM = {
+	SETTINGS_WIDGETS, 3, { WID_SOUNDS, WID_DIFFICULTY, WIDGET_NONE, WIDGET_NONE }
+};
 
-	// Title
-	drawString_P(67, 15, A_RMADA,  CLR_WHITE, CLR_MM_BG, 5, &font5x7, 0);
-	drawString_P(162,55, COURSE_NUM, CLR_WHITE, CLR_MM_BG, 2, &font5x7, 0);
+static WidgetState *ws;					// Borrowed from the arena while a menu screen is open (NULL if it didn't fit)
 
-	// Buttons & gear
-	gui_draw_multiplayer_button(CLR_LIGHT_GRAY, CLR_DARK_GRAY);
-	gui_draw_singleplayer_button(CLR_LIGHT_GRAY, CLR_DARK_GRAY);
+_Static_assert(ARENA_MENU_BYTES <= ARENA_SIZE, "Menu phase does not fit in the arena");
 
-	// Draw the gear icon in the bottom-right corner
-	gui_draw_settings_gear(CLR_LIGHT_GRAY);
+/**
+ * Make `screen` the open widget screen. Nothing is focused and every widget
+ * is marked as not drawn, so the next widgets_render() paints all of them.
+ * Call after arena_enter() for the screen's phase. If the state doesn't fit,
+ * the widget calls below do nothing.
+ */
+static void widgets_open(const WidgetScreen *screen) {
+	ws = arena_alloc(sizeof(*ws));
+	if (!ws)
+		return;
+	memcpy_P(&ws->screen, screen, sizeof(ws->screen));
+	ws->focus = WIDGET_NONE;
+	memset(ws->value, 0, sizeof(ws->value));
+	memset(ws->drawn, WIDGET_NONE, sizeof(ws->drawn));
+}
 
-	// Animate 'V'
-	gui_animate_title_letter_v();
+/**
+ * Forget the open widget screen. Call before arena_enter(): the state lives in
+ * the old phase's arena memory, which the new phase will reuse.
+ */
+void widgets_close(void) {
+	ws = NULL;
 }
 
-/*
- * Draw or redraw the multiplayer button on the main menu screen.
+/**
+ * Return the focused widget ID, or WIDGET_NONE.
  */
-void gui_draw_multiplayer_button(uint16_t text_color, uint16_t border_color) {
-	fillRectBorder(60, 95, 200, 50, 5, border_color);
-	drawString_P(74, 109, MULTIPLAYER, text_color, CLR_MM_BG, 3, &font5x7, 0);
+uint8_t widgets_focus(void) {
+	return ws ? ws->focus : WIDGET_NONE;
 }
 
-/*
- * Draw or redraw the singleplayer button on the main menu screen.
+/**
+ * Move the focus to the neighbour in direction `dir`. Returns true if it moved.
  */
-void gui_draw_singleplayer_button(uint16_t text_color, uint16_t border_color) {
-	fillRectBorder(60, 168, 200, 50, 5, border_color);
-	drawString_P(89, 182, VERSUS_AI, text_color, CLR_MM_BG, 3, &font5x7, 0);
+bool widgets_navigate(NavDir dir) {
+	if (!ws)
+		return false;
+
+	uint8_t next = (ws->focus == WIDGET_NONE)
+		? ws->screen.entry[dir]
+		: pgm_read_byte(&ws->screen.widgets[ws->focus].nav[dir]);
+
+	if (next == WIDGET_NONE || next == ws->focus)
+		return false;
+	ws->focus = next;
+	return true;
 }
 
-/*
- * Draw or redraw the gear icon on the main menu screen.
+/**
+ * Set the value (choice index) shown by widget `id`.
  */
-void gui_draw_settings_gear(uint16_t color) {
+void widgets_set_value(uint8_t id, uint8_t value) {
+	if (ws && id < ws->screen.count)
+		ws->value[id] = value & ~WIDGET_FOCUSED;
+}
 
-	// Center of the gear
-	uint16_t x_center = 303;
-	uint16_t y_center = 223;
+/**
+ * Draw the label and choice text of a button in its state.
+ * Text is opaque, so it replaces whatever label was there before.
+ */
+static void widget_draw_text(const Widget *w, uint8_t state) {
+	uint16_t colour = (state & WIDGET_FOCUSED) ? CLR_WHITE : CLR_LIGHT_GRAY;
+	WidgetChoice choice;
+
+	// A widget with choices draws all of its text in the choice colour
+	if (w->choices) {
+		memcpy_P(&choice, &w->choices[state & ~WIDGET_FOCUSED], sizeof(choice));
+		colour = choice.colour;
+	}
+	if (w->label)
+		drawString_P(w->x + w->labelDx, w->y + w->labelDy, w->label, colour, CLR_MM_BG, 3, &font5x7, 0);
+	if (w->choices)
+		drawString_P(w->x + w->choiceDx, w->y + w->choiceDy, choice.text, colour, CLR_MM_BG, w->choiceSize, &font5x7, 0);
+}
 
-	// Larger circle
-	fillCircle(x_center, y_center, 8, color);
+/**
+ * Repaint what changed since the last render:
+ * - Icons are redrawn when their focus changes
+ * - Button borders are redrawn when their focus changes
+ * - Button text is redrawn when its colour or choice changes
+ */
+void widgets_render(void) {
+	if (!ws)
+		return;
+
+	for (uint8_t id = 0; id < ws->screen.count; id++) {
+		uint8_t state = ws->value[id] | ((id == ws->focus) ? WIDGET_FOCUSED : 0);
+		uint8_t drawn = ws->drawn[id];
+		if (state == drawn)
+			continue;
 
-	// Bottom and top spokes; left and right spokes
-	fillRect(x_center-1, y_center-12, 3, 24, color);
-	fillRect(x_center-12, y_center-1, 24, 3, color);
+		Widget w;
+		memcpy_P(&w, &ws->screen.widgets[id], sizeof(w));
 
-	// Top-left and bottom-right spokes
-	fillTriangle(x_center-9, y_center-8, x_center+10, y_center+8, x_center+8, y_center+9, color);
-	fillTriangle(x_center-9, y_center-8, x_center+10, y_center+8, x_center-7, y_center-9, color);
+		bool focused      = state & WIDGET_FOCUSED;
+		bool focusChanged = (drawn == WIDGET_NONE) || ((state ^ drawn) & WIDGET_FOCUSED);
+		bool valueChanged = (drawn == WIDGET_NONE) || ((state ^ drawn) & ~WIDGET_FOCUSED);
 
-	// Top-right and bottom-left spokes
-	fillTriangle(x_center+10, y_center-8, x_center-9, y_center+8, x_center-7, y_center+9, color);
-	fillTriangle(x_center+10, y_center-8, x_center-9, y_center+8, x_center+8, y_center-9, color);
+		if (w.kind == WIDGET_ICON) {
+			drawBitmap_P(w.x, w.y, w.w, w.h, w.bitmap, focused ? w.focusColour : CLR_LIGHT_GRAY, CLR_MM_BG);
+		} else {
+			if (focusChanged)
+				fillRectBorder(w.x, w.y, w.w, w.h, WIDGET_BORDER_PX, focused ? w.focusColour : CLR_DARK_GRAY);
+			if (w.choices ? valueChanged : focusChanged)
+				widget_draw_text(&w, state);
+		}
+		ws->drawn[id] = state;
+	}
+}
 
-	// Hollow out the middle (to the background color)
-	fillCircle(x_center, y_center, 4, CLR_MM_BG);
+/* -------------------------------------------------------------------------
+ *  STATIC GUI BUILDERS
+ * ------------------------------------------------------------------------- */
+#define FADE_FRAME_MS		40		// Title fade: ms per ramp colour
+#define END_FADE_FRAME_MS	30		// Win/lose headline fade: ms per ramp colour
+#define END_FADE_STAGGER_MS	250		// Delay between win/lose headline lines
+#define END_BLINK_MS		500		// "Press 2x" blink period (half cycle)
+#define END_PROMPT_PX		((sizeof(PRESS_2X) + sizeof(TO_CONTINUE) - 2) * (5 * 3) * (7 * 3))	// Pixels in one blink frame
+#define END_IMAGE_X			140		// Win/lose splash image: top-left corner and scale
+#define END_IMAGE_Y			60
+#define END_IMAGE_SCALE		4
+
+_Static_assert(END_IMAGE_X + IMG_WIDTH * END_IMAGE_SCALE == SCREEN_X && END_IMAGE_Y + IMG_HEIGHT * END_IMAGE_SCALE == SCREEN_Y,
+			   "End screen background only clears around an image in the bottom-right corner");
+
+// Per-screen display cost ("SPI <screen> bytes= us="), build with -DGFX_SPI_STATS.
+// Only the synchronous draw is counted; animation frames that follow are not.
+#ifdef GFX_SPI_STATS
+static void gui_report_cost(const char *screen) {
+	uint32_t bytes = gfx_spi_take();
+	printf("SPI %s bytes=%lu us=%lu\n", screen, bytes, bytes * SPI_BYTE_US_X2 / 2);
 }
+#define GUI_COST_START()	((void)gfx_spi_take())
+#define GUI_COST(screen)	gui_report_cost(screen)
+#else
+#define GUI_COST_START()	((void)0)
+#define GUI_COST(screen)	((void)0)
+#endif
 
 /*
- * Animate the title screen's letter 'V' to fade in slowly.
+ * Stop every animation before a screen is repainted. The pending-shot blink
+ * goes with them, so its track ID must not outlive them.
  */
-void gui_animate_title_letter_v(void) {
-	for (uint8_t i = 0; i < 255; i += 3) {
-		drawString_P(93, 15, V_CHAR, rgb(i, i, i), CLR_MM_BG, 5, &font5x7, 0);
-	}
+static void gui_stop_anims(void) {
+	anim_stop_all();
+	game.pendingBlink = ANIM_NONE;
 }
 
-// Settings Menu
+// Fade-in ramps (black to the final text colour)
+static const uint16_t RAMP_WHITE[ANIM_RAMP_LEN] PROGMEM = { ANIM_RAMP(255, 255, 255) };
+static const uint16_t RAMP_GREEN[ANIM_RAMP_LEN] PROGMEM = { ANIM_RAMP(0, 255, 0) };
+static const uint16_t RAMP_RED[ANIM_RAMP_LEN]	PROGMEM = { ANIM_RAMP(255, 0, 0) };
+
 
 /*
- * Draw the Settings screen.
+ * Draw the initial main menu screen.
  */
-void gui_draw_settings_screen(const bool *sounds, const AIDifficulty *difficulty) {
-
-	// Black background (main menu's background color in header file)
+void gui_draw_main_menu(void) {
+	gui_stop_anims();
+	GUI_COST_START();
 	fillScreen(CLR_MM_BG);
 
-	// Start the title text "Settings"
-	drawString_P(59, 28, SETTINGS,   CLR_WHITE, CLR_MM_BG, 5, &font5x7, 0);
+	// Title
+	drawString_P(67, 15, A_RMADA,  CLR_WHITE, CLR_MM_BG, 5, &font5x7, 0);
+	drawString_P(162,55, COURSE_NUM, CLR_WHITE, CLR_MM_BG, 2, &font5x7, 0);
 
-	// Draw button textures
-	gui_draw_sound_toggle_button(CLR_NONE, CLR_DARK_GRAY, sounds);
-	gui_draw_difficulty_button(CLR_NONE, CLR_DARK_GRAY, difficulty);
-	gui_draw_settings_back(CLR_LIGHT_GRAY);
+	// Buttons & gear
+	widgets_open(&MAIN_MENU_SCREEN);
+	widgets_render();
+	GUI_COST("menu");
 
+	// Animate 'V'
+	gui_animate_title_letter_v();
 }
 
 /*
- * Draw or redraw the sound toggle button on the main menu screen.
+ * Start fading in the title screen's letter 'V'. The fade runs on the
+ * animation timeline, so the menu takes input straight away.
  */
-void gui_draw_sound_toggle_button(uint16_t text_color, uint16_t border_color, const bool *sound) {
-	fillRectBorder(60, 95, 200, 50, 5, border_color);
-	if (sound && *sound) {
-		if (text_color != CLR_NONE) drawString_P(74, 109, SOUNDS_ON, text_color, CLR_MM_BG, 3, &font5x7, 0);
-		drawString_P(74, 109, SOUNDS_ON, CLR_GREEN, CLR_MM_BG, 3, &font5x7, 0);
-	} else {
-		if (text_color != CLR_NONE) drawString_P(74, 109, SOUNDS_OFF, text_color, CLR_MM_BG, 3, &font5x7, 0);
-		drawString_P(74, 109, SOUNDS_OFF, CLR_RED, CLR_MM_BG, 3, &font5x7, 0);
-	}
-
+void gui_animate_title_letter_v(void) {
+	anim_fade_text(93, 15, V_CHAR, 5, CLR_MM_BG, RAMP_WHITE, ANIM_RAMP_LEN, FADE_FRAME_MS, 0);
 }
 
-/*
- * Draw or redraw the difficulty button on the settings screen.
- */
-void gui_draw_difficulty_button(uint16_t text_color, uint16_t border_color, const AIDifficulty *difficulty) {
-	fillRectBorder(60, 168, 200, 50, 5, border_color);
-	if (difficulty) {
-		switch (*difficulty) {
-			case AI_EASY:
-				if (text_color != CLR_NONE) {
-					drawString_P(74, 182, AI, text_color, CLR_MM_BG, 3, &font5x7, 0);
-					drawString_P(132, 185, LIEUTENANT, text_color, CLR_MM_BG, 2, &font5x7, 0);
-				}
-				drawString_P(74, 182, AI, CLR_GREEN, CLR_MM_BG, 3, &font5x7, 0);
-				drawString_P(132, 185, LIEUTENANT, CLR_GREEN, CLR_MM_BG, 2, &font5x7, 0);
-				break;
-			case AI_MEDIUM:
-				if (text_color != CLR_NONE) {
-					drawString_P(74, 182, AI, text_color, CLR_MM_BG, 3, &font5x7, 0);
-					drawString_P(132, 185, CAPTAIN, text_color, CLR_MM_BG, 2, &font5x7, 0);
-				}
-				drawString_P(74, 182, AI, CLR_YELLOW, CLR_MM_BG, 3, &font5x7, 0);
-				drawString_P(132, 185, CAPTAIN, CLR_YELLOW, CLR_MM_BG, 2, &font5x7, 0);
-				break;
-			case AI_HARD:
-				if (text_color != CLR_NONE) {
-					drawString_P(74, 182, AI, text_color, CLR_MM_BG, 3, &font5x7, 0);
-					drawString_P(132, 185, ADMIRAL, text_color, CLR_MM_BG, 2, &font5x7, 0);
-				}
-				drawString_P(74, 182, AI, CLR_RED, CLR_MM_BG, 3, &font5x7, 0);
-				drawString_P(132, 185, ADMIRAL, CLR_RED, CLR_MM_BG, 2, &font5x7, 0);
-				break;
-		}
-	}
-}
+// Settings Menu
 
 /*
- * Draw or redraw the back icon on the settings screen.
+ * Draw the Settings screen.
  */
-void gui_draw_settings_back(uint16_t color) {
+void gui_draw_settings_screen(bool sounds, AIDifficulty difficulty) {
 
-	// Center of the gear
-	uint16_t x_center = 17;
-	uint16_t y_center = 223;
+	// Black background (main menu's background color in header file)
+	gui_stop_anims();
+	GUI_COST_START();
+	fillScreen(CLR_MM_BG);
 
-	// Bottom and top spokes; left and right spokes
-	fillRect(x_center, y_center-6, 8, 12, color);
+	// Start the title text "Settings"
+	drawString_P(59, 28, SETTINGS,   CLR_WHITE, CLR_MM_BG, 5, &font5x7, 0);
 
-	// Top-left and bottom-right spokes
-	fillTriangle(x_center-10, y_center, x_center, y_center+10, x_center, y_center-10, color);
-	//fillTriangle(x_center-9, y_center-8, x_center+10, y_center+8, x_center-7, y_center-9, color);
+	// Buttons & back arrow
+	widgets_open(&SETTINGS_SCREEN);
+	widgets_set_value(WID_SOUNDS, sounds);
+	widgets_set_value(WID_DIFFICULTY, difficulty);
+	widgets_render();
+	GUI_COST("settings");
 }
 
 /**
  * Draw the initial ship placement screen.
  */
 void gui_draw_placement(void) {
+	gui_stop_anims();
+	GUI_COST_START();
 	header_place();
 	status_msg("Use stick to place");
 
@@ -431,8 +862,8 @@ void gui_draw_placement(void) {
 	}
 
 	// Redraw placed ships
-	for (uint8_t i = 0; i < ghostShipIdx; ++i) {
-		Ship *s = &playerFleet[i];
+	for (uint8_t i = 0; i < game.ghostShipIdx; ++i) {
+		Ship *s = &game.playerFleet[i];
 		for (uint8_t k = 0; k < s->length; ++k) {
 			draw_cell(
 				s->row + (s->horizontal ? 0 : k),
@@ -444,63 +875,91 @@ void gui_draw_placement(void) {
 	}
 
 	// Ghost preview
-	ghost_update(selRow, selCol, ghostHorizontal, true);
+	ghost_update(game.selRow, game.selCol, game.ghostHorizontal);
+	GUI_COST("placement");
 }
 
 /**
  * Draw the full play screen showing both grids.
  */
 void gui_draw_play_screen(void) {
+	gui_stop_anims();
+	GUI_COST_START();
 	for (uint8_t r = 0; r < GRID_ROWS; ++r) {
 		for (uint8_t c = 0; c < GRID_COLS; ++c) {
-			/* --- Player board --- */
-			uint16_t pcol = BITMAP_GET(playerOccupiedBitmap, r, c)
-						  ? CLR_SHIP : CLR_CYAN;
-			if (BITMAP_GET(playerAttackedAtBitmap, r, c))
-				pcol = BITMAP_GET(playerOccupiedBitmap, r, c) ? CLR_HIT : CLR_MISS;
-			draw_cell(r, c, pcol, PLAYER_GRID_X_PX);
-
-			/* --- Enemy board --- */
-			uint16_t ecol = !BITMAP_GET(enemyAttackedAtBitmap, r, c)
-							? CLR_NAVY
-							: (BITMAP_GET(enemyConfirmedHitBitmap, r, c)
-							? CLR_HIT : CLR_MISS);
-
-			draw_cell(r, c, ecol, ENEMY_GRID_X_PX);
+			draw_cell(r, c, cell_colour(r, c, PLAYER_GRID_X_PX), PLAYER_GRID_X_PX);	/* Player board */
+			draw_cell(r, c, cell_colour(r, c, ENEMY_GRID_X_PX), ENEMY_GRID_X_PX);		/* Enemy board */
 		}
 	}
 
 	header_play();
 	status_msg("Your Turn");
-	// draw_cursor(lastEnemyRow, lastEnemyCol, ENEMY_GRID_X_PX);
+	GUI_COST("play");
+}
+
+/*
+ * Draw the "Press 2x / To Continue!" prompt bright or dimmed (blink phase).
+ */
+static void gui_draw_continue_prompt(bool on) {
+	uint16_t colour = on ? CLR_WHITE : CLR_DARK_GRAY;
+	drawString_P(7, 150, PRESS_2X, colour, CLR_BLACK, 3, &font5x7, 0);
+	drawString_P(7, 180, TO_CONTINUE, colour, CLR_BLACK, 3, &font5x7, 0);
+}
+
+/*
+ * Fade in the three headline lines of the win/lose screen one after another
+ * and start blinking the continue prompt.
+ */
+static void gui_animate_end_screen(const char *l1, const char *l2, const char *l3, const uint16_t *ramp) {
+	anim_fade_text(7, 20, l1, 3, CLR_BLACK, ramp, ANIM_RAMP_LEN, END_FADE_FRAME_MS, 0);
+	anim_fade_text(7, 50, l2, 3, CLR_BLACK, ramp, ANIM_RAMP_LEN, END_FADE_FRAME_MS, END_FADE_STAGGER_MS);
+	anim_fade_text(7, 80, l3, 3, CLR_BLACK, ramp, ANIM_RAMP_LEN, END_FADE_FRAME_MS, 2 * END_FADE_STAGGER_MS);
+
+	gui_draw_continue_prompt(true);
+	anim_blink(gui_draw_continue_prompt, END_PROMPT_PX, END_BLINK_MS, ANIM_FOREVER);
+}
+
+/*
+ * Clear the win/lose screen around the splash image and draw the image;
+ * the image covers its own box, so clearing it first would write it twice.
+ */
+static void gui_draw_end_background(void) {
+	fillRect(0, 0, SCREEN_X, END_IMAGE_Y, CLR_BLACK);
+	fillRect(0, END_IMAGE_Y, END_IMAGE_X, SCREEN_Y - END_IMAGE_Y, CLR_BLACK);
+	displayImage(END_IMAGE_X, END_IMAGE_Y, END_IMAGE_SCALE);
 }
 
 void gui_draw_lose_screen() {
-	fillScreen(CLR_BLACK);
-	displayImage(140, 60, 4);
-	
-	drawString_P(7, 20, THIS_NOT_THIS, CLR_RED, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 50, NOT_VERY_GOOD, CLR_RED, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 80, YOU_LOSE, CLR_RED, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 150, PRESS_2X, CLR_WHITE, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 180, TO_CONTINUE, CLR_WHITE, CLR_BLACK, 3, &font5x7, 0);
+	gui_stop_anims();
+	GUI_COST_START();
+	gui_draw_end_background();
+
+	gui_animate_end_screen(THIS_NOT_THIS, NOT_VERY_GOOD, YOU_LOSE, RAMP_RED);
+	GUI_COST("lose");
 }
 
 void gui_draw_win_screen() {
-	fillScreen(CLR_BLACK);
-	displayImage(140, 60, 4);
-	
-	drawString_P(7, 20, THIS_IS_THIS, CLR_GREEN, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 50, VERY_GOOD, CLR_GREEN, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 80, YOU_WIN, CLR_GREEN, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 150, PRESS_2X, CLR_WHITE, CLR_BLACK, 3, &font5x7, 0);
-	drawString_P(7, 180, TO_CONTINUE, CLR_WHITE, CLR_BLACK, 3, &font5x7, 0);
+	gui_stop_anims();
+	GUI_COST_START();
+	gui_draw_end_background();
+
+	gui_animate_end_screen(THIS_IS_THIS, VERY_GOOD, YOU_WIN, RAMP_GREEN);
+	GUI_COST("win");
 }
 
 /* -------------------------------------------------------------------------
  *  UART HELPERS
  * ------------------------------------------------------------------------- */
 #define UART_BAUD 9600UL
+#define UART_RING_MASK (ARENA_UART_RING_BYTES - 1)
+
+_Static_assert((ARENA_UART_RING_BYTES & UART_RING_MASK) == 0, "UART ring size must be a power of two");
+_Static_assert(ARENA_UART_RING_BYTES <= 256, "UART ring indices are 8-bit");
+
+/* Receive ring, filled by the RX interrupt while a multiplayer game holds it.
+ * The 2-byte hardware buffer alone overruns during a screen redraw. */
+static volatile uint8_t *uartRing;
+static volatile uint8_t uartHead, uartTail;
 
 /**
  * Initialize UART for 9600 baud, 8N1 configuration.
@@ -510,13 +969,36 @@ void uart_init(void) {
 	UBRR0H = ubrr >> 8;
 	UBRR0L = ubrr & 0xFF;
 	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00); /* 8 data bits, no parity, 1 stop bit */
-	UCSR0B = (1 << RXEN0) | (1 << TXEN0);   /* Enable receiver and transmitter */
+	UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0); /* Receiver (interrupt driven) and transmitter */
+	sei();
+}
+
+/**
+ * Receive into `ring` (ARENA_UART_RING_BYTES, arena owned); NULL stops and
+ * drops whatever arrives.
+ */
+void uart_rx_ring(uint8_t *ring) {
+	cli();
+	uartRing = ring;
+	uartHead = uartTail = 0;
+	sei();
+}
+
+ISR(USART_RX_vect) {
+	uint8_t c = UDR0;
+	uint8_t next = (uartHead + 1) & UART_RING_MASK;
+	if (uartRing && next != uartTail) {		// Full ring: the byte is lost, as an overrun would
+		uartRing[uartHead] = c;
+		uartHead = next;
+	}
 }
 
 /**
  * Send a character over UART (supports '\n' translation to '\r\n').
  */
 int uart_putchar(char c, FILE *stream) {
+	gfx_capture_yield();	// End a capture line in flight first (no-op unless GFX_CAPTURE)
+
 	if (c == '\n')
 		uart_putchar('\r', stream);
 
@@ -529,12 +1011,14 @@ int uart_putchar(char c, FILE *stream) {
  * Return true if a character has been received (non-blocking).
  */
 uint8_t uart_char_available(void) {
-	return (UCSR0A & (1 << RXC0));
+	return uartHead != uartTail;
 }
 
 /**
- * Read a received character (blocking).
+ * Read a received character (only after uart_char_available()).
  */
 char uart_getchar(void) {
-	return UDR0;
+	char c = uartRing[uartTail];
+	uartTail = (uartTail + 1) & UART_RING_MASK;
+	return c;
 }
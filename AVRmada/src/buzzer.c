@@ -9,6 +9,8 @@
  * Copyright (c) 2025 Peter Kamp
  * --------------------------------------------------------------------------- */
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <string.h>
 #include "buzzer.h"
 #include <util/delay.h>
 
@@ -24,6 +26,8 @@ void play_hit_sound(void);
 void play_miss_sound(void);
 void play_enemy_hit_sound(void);
 void play_enemy_miss_sound(void);
+static void sequence_start(const Note *notes, uint8_t count);
+static void sequence_stop(void);
 
 /**
  * Play either the hit or miss sound effect depending on hit status, only if
@@ -31,6 +35,7 @@ void play_enemy_miss_sound(void);
  */
 void play_attack_sound(const bool *hit, const bool *soundsEnabled) {
 	if (!hit || !soundsEnabled || !*soundsEnabled) return;
+	sequence_stop();
 	*hit ? play_hit_sound() : play_miss_sound();
 }
 
@@ -59,25 +64,38 @@ void play_miss_sound() {
 	play_waveform((Note){287, 700, WAVEFORM_SQUARE});
 }
 
+/**
+ * Start the enemy hit or miss sound. It plays from buzzer_tick(), so the
+ * game keeps running (and the link keeps ticking) while it sounds.
+ */
 void play_enemy_attack_sound(const bool *hit, const bool *soundsEnabled) {
 	if (!hit || !soundsEnabled || !*soundsEnabled) return;
 	*hit ? play_enemy_hit_sound() : play_enemy_miss_sound();
 }
 
+static const Note ENEMY_HIT_NOTES[] PROGMEM = {
+	{523, 100, WAVEFORM_SQUARE}, // C5
+	{415, 100, WAVEFORM_SQUARE}, // G#4 (dissonance)
+	{370, 200, WAVEFORM_SQUARE}, // F#4 (falls)
+};
+
+static const Note ENEMY_MISS_NOTES[] PROGMEM = {
+	{659, 100, WAVEFORM_SQUARE}, // E5
+	{0,    60, WAVEFORM_SQUARE}, // short pause
+	{659, 100, WAVEFORM_SQUARE}, // E5 again
+};
+
 void play_enemy_hit_sound(void) {
-	play_waveform((Note){523, 100, WAVEFORM_SQUARE}); // C5
-	play_waveform((Note){415, 100, WAVEFORM_SQUARE}); // G#4 (dissonance)
-	play_waveform((Note){370, 200, WAVEFORM_SQUARE}); // F#4 (falls)
+	sequence_start(ENEMY_HIT_NOTES, sizeof(ENEMY_HIT_NOTES) / sizeof(Note));
 }
 
 void play_enemy_miss_sound(void) {
-	play_waveform((Note){659, 100, WAVEFORM_SQUARE}); // E5
-	_delay_ms(60); // short pause
-	play_waveform((Note){659, 100, WAVEFORM_SQUARE}); // E5 again
+	sequence_start(ENEMY_MISS_NOTES, sizeof(ENEMY_MISS_NOTES) / sizeof(Note));
 }
 
 void play_radar_sound(const bool *hit, const bool *soundsEnabled) {
 	if (!hit || !soundsEnabled || !*soundsEnabled) return;
+	sequence_stop();
 	// Radar sweep: rising tone over ~1 second
 	for (uint16_t f = 400; f <= 1000; f += 20) {
 		play_waveform((Note){f, 15, WAVEFORM_SQUARE});
@@ -115,6 +133,7 @@ void play_radar_sound(const bool *hit, const bool *soundsEnabled) {
 
 void play_win_sound(const bool *soundsEnabled) {
 	if (!soundsEnabled || !*soundsEnabled) return;
+	sequence_stop();
 	// Simple ascending major-like notes
 	play_waveform((Note){523, 150, WAVEFORM_SQUARE}); // C5
 	play_waveform((Note){587, 150, WAVEFORM_SQUARE}); // D5
@@ -129,6 +148,7 @@ void play_win_sound(const bool *soundsEnabled) {
 
 void play_lose_sound(const bool *soundsEnabled) {
 	if (!soundsEnabled || !*soundsEnabled) return;
+	sequence_stop();
 	
 	play_waveform((Note){293, 150, WAVEFORM_SQUARE});
 	play_waveform((Note){430, 150, WAVEFORM_SQUARE});
@@ -220,3 +240,49 @@ void play_waveform(Note note) {
 void delay_variable(uint16_t time) {
 	while (time--) _delay_ms(1);
 }
+
+/* -------------------------------------------------------------------------
+ *  Non-blocking playback
+ *
+ *  A PROGMEM list of square-wave notes (frequency 0 = rest) is stepped by
+ *  buzzer_tick() once per main loop tick. The blocking sounds above cut a
+ *  running sequence short, since they drive the same timer.
+ * ------------------------------------------------------------------------- */
+static const Note *seqNext;		// Next note to start (PROGMEM), NULL when idle
+static uint8_t seqLeft;			// Notes still to start
+static uint16_t seqMsLeft;		// ms left of the note that is playing
+
+static void sequence_start(const Note *notes, uint8_t count) {
+	seqNext = notes;
+	seqLeft = count;
+	seqMsLeft = 0;
+	buzzer_tick();				// First note starts now
+}
+
+static void sequence_stop(void) {
+	if (seqNext)
+		stop_tone();
+	seqNext = NULL;
+}
+
+/**
+ * Advance the non-blocking sound by 1 ms. Call once per main loop tick.
+ */
+void buzzer_tick(void) {
+	if (!seqNext || (seqMsLeft && --seqMsLeft))
+		return;
+
+	if (!seqLeft) {
+		sequence_stop();
+		return;
+	}
+
+	Note note;
+	memcpy_P(&note, seqNext++, sizeof(note));
+	seqLeft--;
+	seqMsLeft = note.duration;
+	if (note.frequency)
+		play_tone(note.frequency);
+	else
+		stop_tone();
+}
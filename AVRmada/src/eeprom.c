@@ -8,13 +8,19 @@
 #include "gfx.h"
 #include <avr/io.h>
 #include <avr/pgmspace.h>
+#include <util/crc16.h>
 
 #ifdef CLEAR_EEPROM
-// Wipe IMG_BYTES bytes to 0x00
+// Wipe IMG_BYTES bytes to 0x00 (and the stamp, so the image is rewritten),
+// and erase the opponent habits
 static void clearEepromImage(void) {
 	for (uint16_t i = 0; i < IMG_BYTES; i++) {
 		eeprom_write_byte((uint8_t*)(EEPROM_IMAGE_ADDR + i), 0x00);
 	}
+	eeprom_update_word((uint16_t*)EEPROM_STAMP_ADDR, 0xFFFF);
+	for (uint8_t i = 0; i < EEPROM_HABIT_BYTES; i++) {
+		eeprom_update_byte((uint8_t*)(EEPROM_HABIT_ADDR + i), 0xFF);
+	}
 }
 #else
 static inline void clearEepromImage(void) { }
@@ -112,17 +118,34 @@ const uint8_t PROGMEM imageData[IMG_BYTES] = {
 
 _Static_assert(sizeof(imageData) == IMG_BYTES, "Bad image size");
 
-// Copy PROGMEM to EEPROM_IMAGE_ADDR
+// CRC-16 of the flash image, seeded with the image version
+static uint16_t imageStamp(void) {
+	uint16_t crc = EEPROM_IMAGE_VERSION;
+	for (uint16_t i = 0; i < IMG_BYTES; i++) {
+		crc = _crc16_update(crc, pgm_read_byte(&imageData[i]));
+	}
+	return crc;
+}
+
+// Copy PROGMEM to EEPROM_IMAGE_ADDR, unless the stamp says it is already there
 static void writeFlashToEeprom(void) {
+	uint16_t stamp = imageStamp();
+	if (eeprom_read_word((const uint16_t*)EEPROM_STAMP_ADDR) == stamp)
+		return;
+
 	for (uint16_t i = 0; i < IMG_BYTES; i++) {
 		uint8_t b = pgm_read_byte(&imageData[i]);
 		eeprom_update_byte((uint8_t*)(EEPROM_IMAGE_ADDR + i), b);
 	}
+	eeprom_update_word((uint16_t*)EEPROM_STAMP_ADDR, stamp);
 }
 #else
 static inline void writeFlashToEeprom(void) { }
 #endif
 
+_Static_assert(EEPROM_STAMP_ADDR + sizeof(uint16_t) <= E2END + 1, "Image stamp does not fit in EEPROM");
+_Static_assert(EEPROM_HABIT_ADDR + EEPROM_HABIT_BYTES <= E2END + 1, "Opponent habits do not fit in EEPROM");
+
 static const uint8_t palette[16][3] = {
 	{  0,   0,   0},
 	{ 63,  57,  54},
@@ -147,7 +170,7 @@ void initEepromImage(void) {
 	writeFlashToEeprom();
 }
 
-void displayImage(int16_t dstX, int16_t dstY, uint8_t scale) {
+static void drawImage(int16_t dstX, int16_t dstY, uint8_t scale) {
 	uint32_t pix = 0;
 	const uint32_t total = (uint32_t)IMG_WIDTH * IMG_HEIGHT;
 	const uint32_t bys = (total + 1) >> 1;
@@ -198,3 +221,12 @@ void displayImage(int16_t dstX, int16_t dstY, uint8_t scale) {
 	}
 }
 
+/**
+ * Draw the EEPROM image at (dstX, dstY), each pixel a scale x scale block.
+ */
+void displayImage(int16_t dstX, int16_t dstY, uint8_t scale) {
+	gfx_capture_image(dstX, dstY, scale);
+	gfx_capture_suspend();		// One IMAGE record instead of a RECT per pixel
+	drawImage(dstX, dstY, scale);
+	gfx_capture_resume();
+}
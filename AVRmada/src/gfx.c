@@ -25,8 +25,17 @@
 #define MADCTL_MV	0x20  // Row/Column Exchange (X and Y swap)
 #define MADCTL_BGR	0x08  // BGR Color Order (instead of RGB)
 
-// Holds Strings from PRGMEM at Runtime
-char strbuffer[32];
+// Default memory access order (landscape, 320x240, origin top-left)
+#define MADCTL_LANDSCAPE	(MADCTL_MV | MADCTL_BGR)
+
+// Memory access orders used to stream rotated glyphs. With these set, a glyph
+// written row-major into the window lands on screen rotated by 0/90/180/270 deg.
+static const uint8_t textMadctl[4] = {
+	MADCTL_LANDSCAPE,								// 0 deg; a = x, b = y
+	MADCTL_MY | MADCTL_BGR,							// 90 deg CW; a = y, b = 319 - x
+	MADCTL_MY | MADCTL_MX | MADCTL_MV | MADCTL_BGR,	// 180 deg; a = 319 - x, b = 239 - y
+	MADCTL_MX | MADCTL_BGR							// 270 deg CW; a = 239 - y, b = x
+};
 
 // ---------------------------------------------------------------------------
 // Font Data Section
@@ -236,6 +245,19 @@ Font fontLarge = { font5x7_data, 5, 7, 0x20, 96 };
 // SPI Communication Setup
 // ---------------------------------------------------------------------------
 
+#ifdef GFX_SPI_STATS
+uint32_t gfxSpiBytes = 0;
+
+/**
+ * Bytes sent to the display since the last call; starts a new count.
+ */
+uint32_t gfx_spi_take(void) {
+	uint32_t n = gfxSpiBytes;
+	gfxSpiBytes = 0;
+	return n;
+}
+#endif
+
 /**
  * Initialize the SPI interface for communication with the ILI9341.
  * Sets up MOSI and SCK as outputs, MISO as input.
@@ -296,25 +318,24 @@ void ili9341_send_data16(uint16_t data) {
 // ILI9341 Display Initialization
 // ---------------------------------------------------------------------------
 
+// Datasheet wait times. The controller starts in Sleep In, where the SPI
+// interface and GRAM already work; only the panel is off. Registers and GRAM
+// can therefore be written during the long Sleep Out wait.
+
 /**
- * Initialize the ILI9341 display controller.
- * Performs hardware reset, followed by standard initialization commands.
+ * Pulse the hardware reset line. Afterwards wait ILI9341_RESET_WAIT_MS before
+ * sending commands and ILI9341_SLEEP_OUT_WAIT_MS before ili9341_sleep_out().
  */
-void ili9341_init(void) {
-	// Hardware Reset Sequence
+void ili9341_reset(void) {
 	RST_LOW();
-	_delay_ms(50);
+	_delay_us(20);		// Reset pulse (>= 10 us)
 	RST_HIGH();
-	_delay_ms(150);
-
-	// Software Reset
-	ili9341_send_command(0x01);  // Software reset
-	_delay_ms(150);
-
-	// Exit Sleep Mode
-	ili9341_send_command(0x11);  // Sleep out
-	_delay_ms(150);
+}
 
+/**
+ * Send the register setup. Allowed in Sleep In, ILI9341_RESET_WAIT_MS after reset.
+ */
+void ili9341_configure(void) {
 	// Initialization command sequence
 	ili9341_send_command_bytes(0xEF, (uint8_t[]){0x03, 0x80, 0x02}, 3);
 	ili9341_send_command_bytes(0xCF, (uint8_t[]){0x00, 0xC1, 0x30}, 3);
@@ -331,7 +352,7 @@ void ili9341_init(void) {
 	ili9341_send_command_bytes(0xC7, (uint8_t[]){0x86}, 1);			// VCOM control 2
 
 	// Memory Access Control and Pixel Format
-	ili9341_send_command_bytes(0x36, (uint8_t[]){MADCTL_MV | MADCTL_BGR}, 1);	// Memory Access Control
+	ili9341_send_command_bytes(0x36, (uint8_t[]){MADCTL_LANDSCAPE}, 1);			// Memory Access Control
 	ili9341_send_command_bytes(0x3A, (uint8_t[]){0x55}, 1);						// Pixel format = 16-bit color
 
 	// Frame Rate and Display Function Control
@@ -349,10 +370,35 @@ void ili9341_init(void) {
 		0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1,
 		0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F
 	}, 15);
+}
+
+/**
+ * Leave Sleep In (ILI9341_SLEEP_OUT_WAIT_MS after reset). Wait
+ * ILI9341_CMD_WAIT_MS before ili9341_display_on().
+ */
+void ili9341_sleep_out(void) {
+	ili9341_send_command(0x11);  // Sleep out
+}
+
+/**
+ * Turn the panel on, showing what is already in GRAM.
+ */
+void ili9341_display_on(void) {
+	ili9341_send_command(0x29);  // Display ON
+}
 
-	// Display ON
-	ili9341_send_command(0x29); // Display ON
-	_delay_ms(150);
+/**
+ * Initialize the ILI9341 display controller, blocking for the datasheet waits.
+ * main() uses the separate steps instead to overlap the waits with other work.
+ */
+void ili9341_init(void) {
+	ili9341_reset();
+	_delay_ms(ILI9341_RESET_WAIT_MS);
+	ili9341_configure();
+	_delay_ms(ILI9341_SLEEP_OUT_WAIT_MS - ILI9341_RESET_WAIT_MS);
+	ili9341_sleep_out();
+	_delay_ms(ILI9341_CMD_WAIT_MS);
+	ili9341_display_on();
 }
 
 /*-----------------------------------------------------------
@@ -393,6 +439,7 @@ void drawPixel(uint16_t x, uint16_t y, uint16_t color) {
 	if (x >= SCREEN_X || y >= SCREEN_Y)
 		return;  // Ignore pixels outside the screen
 
+	gfx_capture_rect(x, y, 1, 1, color);
 	ili9341_set_addr_window(x, y, x, y); // Set address window to a single pixel
 
 	DC_DATA();
@@ -400,6 +447,26 @@ void drawPixel(uint16_t x, uint16_t y, uint16_t color) {
 	SPI_TRANSFER(color & 0xFF); // Send low byte
 }
 
+/**
+ * Stream `count` pixels of a single color into the current address window.
+ * The per-pixel loop counts in 16 bits; only a fill larger than that (up to
+ * the whole screen) is split into chunks.
+ */
+void ili9341_push_color(uint16_t color, uint32_t count) {
+	uint8_t hi = color >> 8;
+	uint8_t lo = color & 0xFF;
+
+	DC_DATA();
+	while (count) {
+		uint16_t n = (count > UINT16_MAX) ? UINT16_MAX : (uint16_t)count;
+		count -= n;
+		while (n--) {
+			SPI_TRANSFER(hi);
+			SPI_TRANSFER(lo);
+		}
+	}
+}
+
 /**
  * Fill the entire screen with a single color.
  */
@@ -410,6 +477,7 @@ void fillScreen(uint16_t color) {
 	uint32_t blocks = totalPixels / 8;  // Send 8 pixels at a time for efficiency
 	uint32_t remainder = totalPixels % 8;
 
+	gfx_capture_screen(color);
 	ili9341_set_addr_window(0, 0, SCREEN_X - 1, SCREEN_Y - 1);
 
 	DC_DATA();
@@ -441,6 +509,7 @@ void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
 	if (w <= 0)
 		return;
 
+	gfx_capture_rect(x, y, w, 1, color);
 	ili9341_set_addr_window(x, y, x + w - 1, y);
 
 	DC_DATA();
@@ -468,6 +537,7 @@ void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
 	if (h <= 0)
 		return;
 
+	gfx_capture_rect(x, y, 1, h, color);
 	ili9341_set_addr_window(x, y, x, y + h - 1);
 
 	DC_DATA();
@@ -479,6 +549,89 @@ void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
 	}
 }
 
+// ---------------------------------------------------------------------------
+// Span-Based Line Rasterizer
+// ---------------------------------------------------------------------------
+//
+// Lines are rasterized into runs of consecutive pixels that share a row
+// (x-major lines) or a column (y-major lines). Each run is sent as a single
+// address window instead of one window per pixel. Plain, thick and
+// anti-aliased lines all go through emitSpan().
+//
+
+// Number of coverage levels used by drawLineAA (fewer levels = longer spans)
+#define LINE_AA_LEVELS	4
+
+/**
+ * Draw one run of `len` pixels starting at (x, y), stroked `thickness` pixels
+ * wide across the run direction.
+ */
+static void emitSpan(int16_t x, int16_t y, int16_t len, bool vertical,
+					 uint8_t thickness, uint16_t color) {
+	int16_t offset = thickness / 2;
+
+	if (thickness <= 1) {
+		if (vertical)
+			drawFastVLine(x, y, len, color);
+		else
+			drawFastHLine(x, y, len, color);
+	} else if (vertical) {
+		fillRect(x - offset, y, thickness, len, color);
+	} else {
+		fillRect(x, y - offset, len, thickness, color);
+	}
+}
+
+/**
+ * Walk the Bresenham line from (x0, y0) to (x1, y1) and emit it as runs.
+ * The pixel set is the same as a per-pixel Bresenham walk.
+ */
+static void lineSpans(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+					  uint8_t thickness, uint16_t color) {
+	int16_t dx = abs(x1 - x0), sx = (x0 < x1) ? 1 : -1;
+	int16_t dy = -abs(y1 - y0), sy = (y0 < y1) ? 1 : -1;
+	int16_t err = dx + dy, e2;
+	bool vertical = (-dy > dx);		// y-major lines coalesce into column runs
+
+	int16_t runX = x0, runY = y0, runLen = 1;
+
+	while (x0 != x1 || y0 != y1) {
+		bool stepX = false, stepY = false;
+
+		e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+			stepX = true;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+			stepY = true;
+		}
+
+		// The next pixel extends the run if it only moved along the run axis
+		if (vertical ? !stepX : !stepY) {
+			runLen++;
+			continue;
+		}
+
+		if (vertical)
+			emitSpan(runX, (sy > 0) ? runY : runY - runLen + 1, runLen, true, thickness, color);
+		else
+			emitSpan((sx > 0) ? runX : runX - runLen + 1, runY, runLen, false, thickness, color);
+
+		runX = x0;
+		runY = y0;
+		runLen = 1;
+	}
+
+	if (vertical)
+		emitSpan(runX, (sy > 0) ? runY : runY - runLen + 1, runLen, true, thickness, color);
+	else
+		emitSpan((sx > 0) ? runX : runX - runLen + 1, runY, runLen, false, thickness, color);
+}
+
 /**
  * Draw a general line from (x0, y0) to (x1, y1) using Bresenham's algorithm.
  */
@@ -498,25 +651,106 @@ void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
 		return;
 	}
 
-	// General Bresenham line algorithm
-	int16_t dx = abs(x1 - x0), sx = (x0 < x1) ? 1 : -1;
-	int16_t dy = -abs(y1 - y0), sy = (y0 < y1) ? 1 : -1;
-	int16_t err = dx + dy, e2;
+	lineSpans(x0, y0, x1, y1, 1, color);
+}
 
-	while (1) {
-		drawPixel(x0, y0, color);
-		if (x0 == x1 && y0 == y1)
-			break;
-		e2 = 2 * err;
-		if (e2 >= dy) {
-			err += dy;
-			x0 += sx;
+/**
+ * Draw a line `thickness` pixels wide (measured across the major axis).
+ */
+void drawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+				   uint8_t thickness, uint16_t color) {
+	if (thickness == 0)
+		return;
+	lineSpans(x0, y0, x1, y1, thickness, color);
+}
+
+/**
+ * Blend `fg` over `bg` with coverage level/LINE_AA_LEVELS (RGB565).
+ */
+static uint16_t blendLevel(uint16_t fg, uint16_t bg, uint8_t level) {
+	uint8_t inv = LINE_AA_LEVELS - level;
+	uint16_t r = (((fg >> 11) & 0x1F) * level + ((bg >> 11) & 0x1F) * inv) / LINE_AA_LEVELS;
+	uint16_t g = (((fg >> 5) & 0x3F) * level + ((bg >> 5) & 0x3F) * inv) / LINE_AA_LEVELS;
+	uint16_t b = ((fg & 0x1F) * level + (bg & 0x1F) * inv) / LINE_AA_LEVELS;
+	return (r << 11) | (g << 5) | b;
+}
+
+/**
+ * Emit one anti-aliased run: the pixel pair (near, far) across the minor axis
+ * with coverage LINE_AA_LEVELS - level and level respectively.
+ */
+static void emitSpanAA(int16_t major, int16_t minor, int16_t len, bool vertical,
+					   uint8_t level, uint16_t color, uint16_t bg) {
+	if (level < LINE_AA_LEVELS) {
+		uint16_t c = blendLevel(color, bg, LINE_AA_LEVELS - level);
+		if (vertical)
+			emitSpan(minor, major, len, true, 1, c);
+		else
+			emitSpan(major, minor, len, false, 1, c);
+	}
+	if (level > 0) {
+		uint16_t c = blendLevel(color, bg, level);
+		if (vertical)
+			emitSpan(minor + 1, major, len, true, 1, c);
+		else
+			emitSpan(major, minor + 1, len, false, 1, c);
+	}
+}
+
+/**
+ * Draw an anti-aliased line (Wu's algorithm) over a known background color.
+ * Coverage is quantized to LINE_AA_LEVELS so neighbouring pixels with the same
+ * row/column and coverage merge into one span.
+ */
+void drawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+				uint16_t color, uint16_t bg) {
+	if (x0 == x1 || y0 == y1) {
+		drawLine(x0, y0, x1, y1, color);
+		return;
+	}
+
+	bool vertical = abs(y1 - y0) > abs(x1 - x0);
+
+	// Work along the major axis: (major, minor) = (x, y) or (y, x)
+	if (vertical) {
+		int16_t t;
+		t = x0; x0 = y0; y0 = t;
+		t = x1; x1 = y1; y1 = t;
+	}
+	if (x0 > x1) {
+		int16_t t;
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+
+	int32_t minorFix = (int32_t)y0 << 16;					// 16.16 fixed point
+	int32_t grad = ((int32_t)(y1 - y0) << 16) / (x1 - x0);
+
+	int16_t runStart = x0;
+	int16_t runMinor = y0;
+	uint8_t runLevel = 0;
+
+	for (int16_t m = x0; m <= x1; m++) {
+		int16_t minor = (int16_t)(minorFix >> 16);
+		uint8_t frac = (uint8_t)(minorFix >> 8);
+		uint8_t level = ((uint16_t)frac * LINE_AA_LEVELS + 128) >> 8;
+		if (level == LINE_AA_LEVELS) {
+			minor++;
+			level = 0;
 		}
-		if (e2 <= dx) {
-			err += dx;
-			y0 += sy;
+
+		if (m == x0) {
+			runMinor = minor;
+			runLevel = level;
+		} else if (minor != runMinor || level != runLevel) {
+			emitSpanAA(runStart, runMinor, m - runStart, vertical, runLevel, color, bg);
+			runStart = m;
+			runMinor = minor;
+			runLevel = level;
 		}
+		minorFix += grad;
 	}
+	emitSpanAA(runStart, runMinor, x1 - runStart + 1, vertical, runLevel, color, bg);
 }
 
 /**
@@ -544,20 +778,67 @@ void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
 	if (w <= 0 || h <= 0)
 		return;
 	drawFastHLine(x, y, w, color);				 // Top edge
-	drawFastHLine(x, y + h - 1, w, color);		  // Bottom edge
-	drawFastVLine(x, y, h, color);				  // Left edge
-	drawFastVLine(x + w - 1, y, h, color);		  // Right edge
+	if (h > 1)
+		drawFastHLine(x, y + h - 1, w, color);	  // Bottom edge
+	drawFastVLine(x, y + 1, h - 2, color);		  // Left edge (between the corners)
+	if (w > 1)
+		drawFastVLine(x + w - 1, y + 1, h - 2, color);	// Right edge
 }
 
 /**
- * Fill a rectangle with a solid color.
+ * Fill a rectangle with a solid color (clipped, one address window).
  */
 void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		y = 0;
+	}
+	if (x + w > SCREEN_X)
+		w = SCREEN_X - x;
+	if (y + h > SCREEN_Y)
+		h = SCREEN_Y - y;
 	if (w <= 0 || h <= 0)
 		return;
-	for (int16_t i = 0; i < h; i++) {
-		drawFastHLine(x, y + i, w, color);
+
+	gfx_capture_rect(x, y, w, h, color);
+	ili9341_set_addr_window(x, y, x + w - 1, y + h - 1);
+	ili9341_push_color(color, (uint32_t)w * h);
+}
+
+/**
+ * Fill a rows x cols block of square cells at (x, y) through one address
+ * window. Each cell is `size` px: colors[] (row-major) inside a 1 px `outline`
+ * ring. The pixels match a fillRect + drawRect per cell, without the window
+ * setup for each of them. The block must lie on screen.
+ */
+void fillCellBlock(int16_t x, int16_t y, uint8_t rows, uint8_t cols, uint8_t size, const uint16_t *colors, uint16_t outline) {
+	int16_t w = (int16_t)cols * size, h = (int16_t)rows * size;
+	if (x < 0 || y < 0 || x + w > SCREEN_X || y + h > SCREEN_Y || size < 2)
+		return;
+
+	gfx_capture_rect(x, y, w, h, outline);
+	for (uint8_t i = 0; i < rows * cols; ++i)
+		gfx_capture_rect(x + (i % cols) * size + 1, y + (i / cols) * size + 1, size - 2, size - 2, colors[i]);
+	gfx_capture_suspend();
+
+	ili9341_set_addr_window(x, y, x + w - 1, y + h - 1);
+	for (uint8_t r = 0; r < rows; ++r, colors += cols) {
+		ili9341_push_color(outline, w);				// Top edges
+		for (uint8_t py = 2; py < size; ++py) {
+			ili9341_push_color(outline, 1);
+			for (uint8_t c = 0; c < cols; ++c) {
+				ili9341_push_color(colors[c], size - 2);
+				ili9341_push_color(outline, c + 1 < cols ? 2 : 1);	// This cell's right edge and the next one's left
+			}
+		}
+		ili9341_push_color(outline, w);				// Bottom edges
 	}
+
+	gfx_capture_resume();
 }
 
 /**
@@ -574,11 +855,13 @@ void fillRectBorder(int16_t rect_x, int16_t rect_y, int16_t rect_w, int16_t rect
 	int16_t bigger_w = rect_w + border_size;
 	int16_t bigger_h = rect_h + border_size;
 
-	// Fill the 4 strokes
+	// Fill the 4 strokes; the side strokes stop short of the corners so no pixel is written twice
+	int16_t side_y = y_top + border_size;
+	int16_t side_h = bigger_h - 2 * border_size;
 	fillRect(x_left, y_top, bigger_w, border_size, color);		// Top stroke
-	fillRect(x_right, y_top, border_size, bigger_h, color);		// Right stroke
+	fillRect(x_right, side_y, border_size, side_h, color);		// Right stroke
 	fillRect(x_left, y_bottom, bigger_w, border_size, color);	// Bottom stroke
-	fillRect(x_left, y_top, border_size, bigger_h, color);		// Left stroke
+	fillRect(x_left, side_y, border_size, side_h, color);		// Left stroke
 }
 
 // ---------------------------------------------------------------------------
@@ -815,12 +1098,357 @@ void fillCircleHelper(int16_t x0, int16_t y0, int16_t r,
 	}
 }
 
+// ---------------------------------------------------------------------------
+// Bitmap Functions
+// ---------------------------------------------------------------------------
+
+/**
+ * Draw a 1-bit bitmap stored in PROGMEM (rows padded to whole bytes, MSB = leftmost pixel).
+ * The whole box is one address window: set bits get `color`, clear bits get `bg`.
+ */
+void drawBitmap_P(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *bits,
+				  uint16_t color, uint16_t bg) {
+	if (x < 0 || y < 0 || x + w > SCREEN_X || y + h > SCREEN_Y)
+		return;
+
+	uint8_t fgHi = color >> 8, fgLo = color & 0xFF;
+	uint8_t bgHi = bg >> 8,	bgLo = bg & 0xFF;
+	uint8_t stride = (w + 7) / 8;
+
+	ili9341_set_addr_window(x, y, x + w - 1, y + h - 1);
+	DC_DATA();
+	for (uint8_t j = 0; j < h; j++) {
+		const uint8_t *row = bits + (uint16_t)j * stride;
+		uint8_t byte = 0;
+		for (uint8_t i = 0; i < w; i++) {
+			if ((i & 7) == 0)
+				byte = pgm_read_byte(row + (i >> 3));
+			if (byte & 0x80) {
+				SPI_TRANSFER(fgHi);
+				SPI_TRANSFER(fgLo);
+			} else {
+				SPI_TRANSFER(bgHi);
+				SPI_TRANSFER(bgLo);
+			}
+			byte <<= 1;
+		}
+	}
+}
+
+/**
+ * Draw one frame of an RLE sprite stored in PROGMEM (see SPRITE_RUN) and
+ * return where the next frame starts. Skipped pixels are left alone, so a
+ * frame only writes what changed since the one before it. A window opened at
+ * the left edge spans the rest of the box, so runs that follow each other
+ * share it across rows; one opened mid-row ends with that row. The box must
+ * lie on screen.
+ */
+const uint8_t *drawSpriteFrame_P(int16_t x, int16_t y, uint8_t w, uint8_t h,
+								 const uint8_t *runs, const uint16_t *palette) {
+	uint16_t area = (uint16_t)w * h;
+	uint16_t pos = 0;
+	uint16_t open = UINT16_MAX;		// Pixel the open window writes next (none yet)
+	bool toEnd = false;				// Open window spans the rest of the box
+
+	while (pos < area) {
+		uint8_t run = pgm_read_byte(runs++);
+		if (run == SPRITE_END)
+			break;
+
+		uint8_t index = run >> 5, len = (run & 0x1F) + 1;
+		if (index == SPRITE_SKIP) {
+			pos += len;
+			continue;
+		}
+
+		uint16_t color = pgm_read_word(&palette[index]);
+		while (len) {
+			uint8_t row = pos / w, col = pos % w;
+			uint8_t n = (len < w - col) ? len : w - col;
+			if (pos != open) {
+				toEnd = (col == 0);
+				ili9341_set_addr_window(x + col, y + row, x + w - 1, toEnd ? y + h - 1 : y + row);
+			}
+			ili9341_push_color(color, n);
+			pos += n;
+			len -= n;
+			open = (!toEnd && pos % w == 0) ? UINT16_MAX : pos;
+		}
+	}
+	return runs;
+}
+
+// ---------------------------------------------------------------------------
+// Overlay (Save-Under) Functions
+// ---------------------------------------------------------------------------
+//
+// An overlay is a rectangular frame drawn over existing content. The frame is
+// made of `thickness` nested 1px rings, walked from the outside in, each ring
+// as its top, bottom, left and right edge (corners belong to top/bottom).
+// The pixels under the frame are kept as RLE runs in that same order, so
+// removing the overlay only rewrites the frame pixels.
+//
+
+/**
+ * Number of pixels covered by a w x h frame of the given thickness.
+ */
+uint16_t overlay_frame_pixels(uint8_t w, uint8_t h, uint8_t thickness) {
+	uint16_t count = 0;
+
+	for (uint8_t k = 0; k < thickness; k++) {
+		int16_t rw = w - 2 * k;
+		int16_t rh = h - 2 * k;
+		if (rw <= 0 || rh <= 0)
+			break;
+
+		if (rh == 1)
+			count += rw;
+		else if (rw == 1)
+			count += rh;
+		else
+			count += 2 * rw + 2 * (rh - 2);
+	}
+	return count;
+}
+
+/**
+ * Stroke every edge of the overlay frame, either with a single color
+ * (runs == NULL) or with the saved RLE runs.
+ */
+static void overlayStroke(const Overlay *o, uint16_t color, const OverlayRun *runs) {
+	uint8_t run = 0;
+	uint16_t left = runs ? runs[0].len : 0;
+
+	// A frame thick enough to reach its centre is a solid block, so one color
+	// goes out in a single window instead of one per edge
+	if (2 * o->thickness >= ((o->w < o->h) ? o->w : o->h) && (!runs || o->runCount == 1)) {
+		ili9341_set_addr_window(o->x, o->y, o->x + o->w - 1, o->y + o->h - 1);
+		ili9341_push_color(runs ? runs[0].color : color, (uint16_t)o->w * o->h);
+		return;
+	}
+
+	for (uint8_t k = 0; k < o->thickness; k++) {
+		int16_t x = o->x + k;
+		int16_t y = o->y + k;
+		int16_t w = o->w - 2 * k;
+		int16_t h = o->h - 2 * k;
+		if (w <= 0 || h <= 0)
+			break;
+
+		// Top, bottom, left, right
+		int16_t ex[4] = { x, x,			x,		x + w - 1 };
+		int16_t ey[4] = { y, y + h - 1,	y + 1,	y + 1 };
+		int16_t ew[4] = { w, (h > 1) ? w : 0, 1, (w > 1) ? 1 : 0 };
+		int16_t eh[4] = { 1, 1, h - 2, h - 2 };
+
+		for (uint8_t e = 0; e < 4; e++) {
+			if (ew[e] <= 0 || eh[e] <= 0)
+				continue;
+
+			uint16_t n = ew[e] * eh[e];
+			ili9341_set_addr_window(ex[e], ey[e], ex[e] + ew[e] - 1, ey[e] + eh[e] - 1);
+
+			if (!runs) {
+				ili9341_push_color(color, n);
+				continue;
+			}
+			while (n && left) {
+				uint16_t take = (left < n) ? left : n;
+				ili9341_push_color(runs[run].color, take);
+				n -= take;
+				left -= take;
+				if (!left && ++run < o->runCount)
+					left = runs[run].len;
+			}
+		}
+	}
+}
+
+/**
+ * Draw an overlay frame at (x, y) and remember what is under it.
+ *
+ * under    - RLE runs describing the pixels under the frame, in frame order
+ * runCount - Number of runs (at most OVERLAY_MAX_RUNS)
+ */
+void overlay_show(Overlay *o, int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t thickness,
+				  uint16_t color, const OverlayRun *under, uint8_t runCount) {
+	if (runCount > OVERLAY_MAX_RUNS)
+		runCount = OVERLAY_MAX_RUNS;
+
+	o->x = x;
+	o->y = y;
+	o->w = w;
+	o->h = h;
+	o->thickness = thickness;
+	o->runCount = runCount;
+	for (uint8_t i = 0; i < runCount; i++)
+		o->runs[i] = under[i];
+	o->shown = true;
+
+	overlayStroke(o, color, NULL);
+}
+
+/**
+ * Redraw a shown overlay frame in a new color (the saved pixels are unchanged).
+ */
+void overlay_recolor(Overlay *o, uint16_t color) {
+	if (o->shown)
+		overlayStroke(o, color, NULL);
+}
+
+/**
+ * Remove an overlay by restoring the saved pixels under its frame.
+ */
+void overlay_hide(Overlay *o) {
+	if (!o->shown)
+		return;
+	if (o->runCount)
+		overlayStroke(o, 0, o->runs);
+	o->shown = false;
+}
+
+/**
+ * Forget an overlay without touching the screen (its area was redrawn).
+ */
+void overlay_discard(Overlay *o) {
+	o->shown = false;
+}
+
 // ---------------------------------------------------------------------------
 // Text Rendering Functions
 // ---------------------------------------------------------------------------
 
+/**
+ * Switch the GRAM write order so that glyphs streamed row-major come out
+ * rotated by `rotation` (see textMadctl). Rotation 0 needs no command.
+ */
+static void beginTextRotation(uint8_t rotation) {
+	if (rotation & 3)
+		ili9341_send_command_bytes(0x36, &textMadctl[rotation & 3], 1);
+}
+
+/**
+ * Restore the default landscape write order after beginTextRotation().
+ */
+static void endTextRotation(uint8_t rotation) {
+	if (rotation & 3)
+		ili9341_send_command_bytes(0x36, &textMadctl[0], 1);
+}
+
+/**
+ * Draw one glyph with the write order already set by beginTextRotation().
+ *
+ * The glyph box is mapped into the rotated memory frame (a = column, b = page)
+ * once, clipped to that frame, and then streamed exactly as if unrotated:
+ * - Opaque text (bg != color) is a single window covering the whole glyph
+ * - Transparent text (bg == color) is one window per horizontal run of set pixels
+ */
+static void drawGlyph(int16_t x, int16_t y, char c,
+					  uint16_t color, uint16_t bg,
+					  uint8_t size, const Font *font,
+					  uint8_t rotation)
+{
+	if (c < font->first || c >= font->first + font->count)
+		return;  // Skip unsupported characters
+
+	const uint8_t *glyph = font->bitmap + (c - font->first) * font->width;
+	int16_t gw = font->width  * size;	// Glyph box width in the glyph's own frame
+	int16_t gh = font->height * size;	// Glyph box height in the glyph's own frame
+	int16_t a0, b0, frameW, frameH;
+
+	// Glyph origin in the rotated memory frame
+	switch (rotation & 3) {
+		case 1:  // 90 Degrees CW
+			a0 = y;					b0 = SCREEN_X - x - gh;
+			frameW = SCREEN_Y;		frameH = SCREEN_X;
+			break;
+		case 2:  // 180 Degrees
+			a0 = SCREEN_X - x - gw;	b0 = SCREEN_Y - y - gh;
+			frameW = SCREEN_X;		frameH = SCREEN_Y;
+			break;
+		case 3:  // 270 Degrees CW
+			a0 = SCREEN_Y - y - gw;	b0 = x;
+			frameW = SCREEN_Y;		frameH = SCREEN_X;
+			break;
+		default: // 0 Degrees
+			a0 = x;					b0 = y;
+			frameW = SCREEN_X;		frameH = SCREEN_Y;
+	}
+
+	// Clip the glyph box to the frame
+	int16_t aLo = a0 < 0 ? 0 : a0;
+	int16_t bLo = b0 < 0 ? 0 : b0;
+	int16_t aHi = (a0 + gw > frameW) ? frameW - 1 : a0 + gw - 1;
+	int16_t bHi = (b0 + gh > frameH) ? frameH - 1 : b0 + gh - 1;
+	if (aLo > aHi || bLo > bHi)
+		return;
+
+	if (bg != color) {
+		// Opaque: one window, every pixel written exactly once
+		uint8_t fgHi = color >> 8, fgLo = color & 0xFF;
+		uint8_t bgHi = bg >> 8,	bgLo = bg & 0xFF;
+		uint8_t iStart = (aLo - a0) / size;
+		uint8_t subStart = (aLo - a0) % size;
+
+		ili9341_set_addr_window(aLo, bLo, aHi, bHi);
+		DC_DATA();
+		for (int16_t b = bLo; b <= bHi; b++) {
+			uint8_t mask = 1 << ((b - b0) / size);
+			uint8_t i = iStart, sub = subStart;
+
+			for (int16_t a = aLo; a <= aHi; a++) {
+				if (glyph[i] & mask) {
+					SPI_TRANSFER(fgHi);
+					SPI_TRANSFER(fgLo);
+				} else {
+					SPI_TRANSFER(bgHi);
+					SPI_TRANSFER(bgLo);
+				}
+				if (++sub == size) {
+					sub = 0;
+					i++;
+				}
+			}
+		}
+		return;
+	}
+
+	// Transparent: fill each run of set pixels in a glyph row
+	for (uint8_t j = 0; j < font->height; j++) {
+		int16_t rowLo = b0 + j * size;
+		int16_t rowHi = rowLo + size - 1;
+		if (rowLo < bLo) rowLo = bLo;
+		if (rowHi > bHi) rowHi = bHi;
+		if (rowLo > rowHi)
+			continue;
+
+		uint8_t mask = 1 << j;
+		uint8_t i = 0;
+		while (i < font->width) {
+			if (!(glyph[i] & mask)) {
+				i++;
+				continue;
+			}
+			uint8_t runStart = i;
+			while (i < font->width && (glyph[i] & mask))
+				i++;
+
+			int16_t runLo = a0 + runStart * size;
+			int16_t runHi = a0 + i * size - 1;
+			if (runLo < aLo) runLo = aLo;
+			if (runHi > aHi) runHi = aHi;
+			if (runLo > runHi)
+				continue;
+
+			ili9341_set_addr_window(runLo, rowLo, runHi, rowHi);
+			ili9341_push_color(color, (uint32_t)(runHi - runLo + 1) * (rowHi - rowLo + 1));
+		}
+	}
+}
+
 /**
  * Draw a single character at (x, y) with specified color, background, size, font, and rotation.
+ * If bg == color the background is left untouched (transparent text).
  *
  * Rotation options:
  *   0 = 0 deg; normal
@@ -833,68 +1461,19 @@ void drawChar(int16_t x, int16_t y, char c,
 			  uint8_t size, const Font *font,
 			  uint8_t rotation)
 {
-	if (c < font->first || c >= font->first + font->count)
-		return;  // Skip unsupported characters
-
-	uint16_t idx = (c - font->first) * font->width;  // Index into font bitmap
-	uint8_t w = font->width;
-	uint8_t h = font->height;
-
-	for (uint8_t i = 0; i < w; i++) {
-		uint8_t line = font->bitmap[idx + i];
-
-		for (uint8_t j = 0; j < h; j++, line >>= 1) {
-			bool pixelOn = (line & 0x01);
-			int16_t dx, dy;
-
-			// Determine pixel offset based on rotation
-			switch (rotation & 3) {
-				case 1:  // 90 Degrees CW
-					dx = h - 1 - j;
-					dy = i;
-					break;
-				case 2:  // 180 Degrees
-					dx = w - 1 - i;
-					dy = h - 1 - j;
-					break;
-				case 3:  // 270 Degrees CW
-					dx = j;
-					dy = w - 1 - i;
-					break;
-				default: // 0 Degrees
-					dx = i;
-					dy = j;
-			}
-
-			int16_t px = x + dx * size;
-			int16_t py = y + dy * size;
-
-			if (pixelOn) {
-				if (size == 1)
-					drawPixel(px, py, color);
-				else
-					fillRect(px, py, size, size, color);
-			} else if (bg != color) {
-				if (size == 1)
-					drawPixel(px, py, bg);
-				else
-					fillRect(px, py, size, size, bg);
-			}
-		}
-	}
+	gfx_capture_text(x, y, ((char[]){ c, '\0' }), false, color, bg, size, rotation);
+	beginTextRotation(rotation);
+	drawGlyph(x, y, c, color, bg, size, font, rotation);
+	endTextRotation(rotation);
 }
 
 /**
- * Draw a string at (x, y) using the specified font, with support for newline and rotation.
- *
- * Newline behavior depends on rotation:
- *   0 = move downward on newline
- *   1 = move left on newline
- *   2 = move upward on newline
- *   3 = move right on newline
+ * Lay out and draw a string from SRAM or, if `progmem`, straight from flash.
+ * The memory access order is switched once for the whole string.
  */
-void drawString(int16_t x, int16_t y, const char *s, uint16_t color, uint16_t bg,
-				uint8_t size, const Font *font, uint8_t rotation)
+static void drawText(int16_t x, int16_t y, const char *s, bool progmem,
+					 uint16_t color, uint16_t bg,
+					 uint8_t size, const Font *font, uint8_t rotation)
 {
 	int16_t deltaX = font->width  * size + 1;	// Character width (scaled) + 1px spacing
 	int16_t deltaY = font->height * size + 1;	// Character height (scaled) + 1px spacing
@@ -904,10 +1483,6 @@ void drawString(int16_t x, int16_t y, const char *s, uint16_t color, uint16_t bg
 	int16_t stepX, stepY, nlX, nlY;
 
 	switch (rotation & 3) {
-		case 0: // 0 Degrees
-			stepX = deltaX; stepY = 0;
-			nlX = 0; nlY = deltaY + gap;
-			break;
 		case 1: // 90 Degrees CW
 			stepX = 0; stepY = deltaX;
 			nlX = -(deltaY + gap); nlY = 0;
@@ -920,79 +1495,359 @@ void drawString(int16_t x, int16_t y, const char *s, uint16_t color, uint16_t bg
 			stepX = 0; stepY = -deltaX;
 			nlX = deltaY + gap; nlY = 0;
 			break;
+		default: // 0 Degrees
+			stepX = deltaX; stepY = 0;
+			nlX = 0; nlY = deltaY + gap;
 	}
 
 	int16_t startX = x, startY = y;
 	int line = 0;
 	int16_t cx = startX, cy = startY;
 
-	while (*s) {
-		if (*s == '\n') {
+	gfx_capture_text(x, y, s, progmem, color, bg, size, rotation);
+	beginTextRotation(rotation);
+	for (char c; (c = progmem ? pgm_read_byte(s) : *s); s++) {
+		if (c == '\n') {
 			// Newline: move start position
 			line++;
 			cx = startX + nlX * line;
 			cy = startY + nlY * line;
 		} else {
-			drawChar(cx, cy, *s, color, bg, size, font, rotation);
+			drawGlyph(cx, cy, c, color, bg, size, font, rotation);
 			cx += stepX;
 			cy += stepY;
 		}
-		s++;
 	}
+	endTextRotation(rotation);
 }
 
-#include <avr/pgmspace.h>
-#include <string.h>
+/**
+ * Draw a string at (x, y) using the specified font, with support for newline and rotation.
+ *
+ * Newline behavior depends on rotation:
+ *   0 = move downward on newline
+ *   1 = move left on newline
+ *   2 = move upward on newline
+ *   3 = move right on newline
+ */
+void drawString(int16_t x, int16_t y, const char *s, uint16_t color, uint16_t bg,
+				uint8_t size, const Font *font, uint8_t rotation)
+{
+	drawText(x, y, s, false, color, bg, size, font, rotation);
+}
 
+/**
+ * Draw a string stored in PROGMEM, read byte by byte (no SRAM copy).
+ */
 void drawString_P(int16_t x, int16_t y, const char *s_progmem, uint16_t color, uint16_t bg,
-uint8_t size, const Font *font, uint8_t rotation)
+				  uint8_t size, const Font *font, uint8_t rotation)
 {
-	// Copy from PROGMEM to RAM buffer
-	strncpy_P(strbuffer, s_progmem, sizeof(strbuffer) - 1);
-	strbuffer[sizeof(strbuffer) - 1] = '\0';  // Null-terminate
+	drawText(x, y, s_progmem, true, color, bg, size, font, rotation);
+}
+
+#ifdef GFX_CAPTURE
+// ---------------------------------------------------------------------------
+// Draw-Call Capture
+// ---------------------------------------------------------------------------
+//
+// Records are packed into lines of at most CAP_LINE_BYTES, and every line
+// starts from a fresh delta state (position 0,0, no colours), so a viewer that
+// misses a line only loses the records in it. A line goes out as
+//
+//	'G' <tag> <len> <payload> '\n'
+//
+// tag = '0' + (sequence & 31), plus 32 if records were dropped just before
+// this line; len = '0' + payload bytes, so a cut-off line is recognised. The
+// payload packs 3 bytes into 4 characters of 6 bits ('0' + v).
+// Characters are written one per tick and only while the UART is idle, so
+// capturing never stalls the loop; a game frame cuts a line in flight short
+// (gfx_capture_yield()) and that line is sent again from its start.
+//
+// Not captured: bitmaps, overlays and the other shapes that write SPI
+// directly (circles and rounded rects arrive as RECT strips). Lines of every
+// kind arrive as the RECT spans emitSpan() draws them with.
 
-	const char *s = strbuffer;
+#define CAP_LINE_BYTES		24		// Record bytes per line (32 payload characters)
+#ifndef CAP_QUEUE_LINES
+#define CAP_QUEUE_LINES		6		// Closed lines waiting to be sent (26 B each; ~35 hold a full board redraw)
+#endif
+#define CAP_TEXT_MAX		12		// SRAM text characters kept per record (longer text is cut)
+#define CAP_RECORD_MAX		23		// Longest record: TEXT with CAP_TEXT_MAX characters
+#define CAP_LINE_GAP_MS		8		// Idle ticks after each line, left for game frames
+#define CAP_FLUSH_MS		40		// A partly filled line is closed after this long without records
+
+_Static_assert(CAP_RECORD_MAX <= CAP_LINE_BYTES, "Longest capture record does not fit in a line");
+
+typedef struct {
+	uint8_t tag;					// Sequence character (set when queued)
+	uint8_t len;
+	uint8_t bytes[CAP_LINE_BYTES];
+} CapLine;
+
+static CapLine capOpen;							// Line being filled
+static CapLine capQueue[CAP_QUEUE_LINES];		// Closed lines, oldest at capHead
+static uint8_t capHead = 0, capQueued = 0;
+static uint8_t capSeq = 0;
+static bool    capLost = false;					// Records dropped since the last queued line
+static uint8_t capHold = 0;						// gfx_capture_suspend() depth
+static uint8_t capTxPos = 0;					// Next character of the head line (0 = not started)
+static uint8_t capGap = 0;						// Ticks to wait before starting the next line
+static uint8_t capIdle = 0;						// Ticks since the open line last grew
+static uint8_t *capHeader;						// Header byte of the record being written
+
+// Delta state of the open line
+static int16_t  capX, capY;
+static uint16_t capFg, capBg;
+static bool     capFgKnown, capBgKnown;
 
-	int16_t deltaX = font->width  * size + 1;
-	int16_t deltaY = font->height * size + 1;
-	int16_t gap    = size;
+/**
+ * Queue the open line (or drop it if the queue is full) and start a new one.
+ */
+static void cap_close(void) {
+	if (capOpen.len == 0)
+		return;
 
-	int16_t stepX, stepY, nlX, nlY;
+	if (capQueued < CAP_QUEUE_LINES) {
+		capOpen.tag = '0' + (capSeq++ & 31) + (capLost ? 32 : 0);
+		capQueue[(capHead + capQueued) % CAP_QUEUE_LINES] = capOpen;
+		capQueued++;
+		capLost = false;
+	} else {
+		capLost = true;
+	}
 
-	switch (rotation & 3) {
-		case 0:
-		stepX = deltaX; stepY = 0;
-		nlX = 0; nlY = deltaY + gap;
-		break;
-		case 1:
-		stepX = 0; stepY = deltaX;
-		nlX = -(deltaY + gap); nlY = 0;
-		break;
-		case 2:
-		stepX = -deltaX; stepY = 0;
-		nlX = 0; nlY = -(deltaY + gap);
-		break;
-		case 3:
-		stepX = 0; stepY = -deltaX;
-		nlX = deltaY + gap; nlY = 0;
-		break;
+	capOpen.len = 0;
+	capX = capY = 0;
+	capFgKnown = capBgKnown = false;
+}
+
+/**
+ * Start a record of at most `maxLen` bytes, closing the open line if it
+ * doesn't fit. False while capture is suspended.
+ */
+static bool cap_begin(uint8_t op, uint8_t maxLen) {
+	if (capHold)
+		return false;
+	if (capOpen.len + maxLen > CAP_LINE_BYTES)
+		cap_close();
+
+	capHeader = &capOpen.bytes[capOpen.len++];
+	*capHeader = op;
+	capIdle = 0;
+	return true;
+}
+
+static void cap_byte(uint8_t v) {
+	capOpen.bytes[capOpen.len++] = v;
+}
+
+static void cap_word(uint16_t v) {
+	cap_byte(v & 0xFF);
+	cap_byte(v >> 8);
+}
+
+/**
+ * Size up to 32767: one byte below 128, else two with the top bit set.
+ */
+static void cap_size(int16_t v) {
+	if (v >= 0x80)
+		cap_byte(0x80 | (v >> 8));
+	cap_byte(v & 0xFF);
+}
+
+static void cap_pos(int16_t x, int16_t y) {
+	int16_t dx = x - capX, dy = y - capY;
+	if (dx >= -128 && dx <= 127 && dy >= -128 && dy <= 127) {
+		*capHeader |= CAP_F_NEAR;
+		cap_byte((uint8_t)dx);
+		cap_byte((uint8_t)dy);
+	} else {
+		cap_word(x);
+		cap_word(y);
 	}
+	capX = x;
+	capY = y;
+}
 
-	int16_t startX = x, startY = y;
-	int line = 0;
-	int16_t cx = startX, cy = startY;
+static void cap_fg(uint16_t color) {
+	if (capFgKnown && color == capFg) {
+		*capHeader |= CAP_F_SAME_FG;
+	} else {
+		cap_word(color);
+		capFg = color;
+		capFgKnown = true;
+	}
+}
 
-	while (*s) {
-		if (*s == '\n') {
-			line++;
-			cx = startX + nlX * line;
-			cy = startY + nlY * line;
-			} else {
-			drawChar(cx, cy, *s, color, bg, size, font, rotation);
-			cx += stepX;
-			cy += stepY;
+static void cap_bg(uint16_t color) {
+	if (capBgKnown && color == capBg) {
+		*capHeader |= CAP_F_SAME_BG;
+	} else {
+		cap_word(color);
+		capBg = color;
+		capBgKnown = true;
+	}
+}
+
+/**
+ * Log a full-screen fill.
+ */
+void gfx_capture_screen(uint16_t color) {
+	if (cap_begin(CAP_SCREEN, 3))
+		cap_fg(color);
+}
+
+/**
+ * Log a solid rectangle (already clipped to the screen).
+ */
+void gfx_capture_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+	if (!cap_begin(CAP_RECT, 11))
+		return;
+	cap_pos(x, y);
+	cap_size(w);
+	cap_size(h);
+	cap_fg(color);
+}
+
+/**
+ * Log a string: flash strings by address (the viewer looks them up in the
+ * firmware image), SRAM strings by their first CAP_TEXT_MAX characters.
+ */
+void gfx_capture_text(int16_t x, int16_t y, const char *s, bool progmem,
+					  uint16_t color, uint16_t bg, uint8_t size, uint8_t rotation) {
+	uint8_t len = 0;
+	if (!progmem) {
+		while (len < CAP_TEXT_MAX && s[len])
+			len++;
+	}
+
+	if (!cap_begin(progmem ? CAP_TEXT_P : CAP_TEXT, progmem ? 12 : 12 + len - 1))
+		return;
+	cap_pos(x, y);
+	cap_byte((rotation & 3) << 6 | (size & 0x3F));
+	cap_fg(color);
+	cap_bg(bg);
+	if (progmem) {
+		cap_word((uint16_t)(uintptr_t)s);
+	} else {
+		cap_byte(len);
+		for (uint8_t i = 0; i < len; i++)
+			cap_byte(s[i]);
+	}
+}
+
+/**
+ * Log one board cell: `grid` 0 = player, 1 = enemy.
+ */
+void gfx_capture_cell(uint8_t grid, uint8_t row, uint8_t col, uint16_t color) {
+	if (!cap_begin(CAP_CELL, 4))
+		return;
+	if (grid)
+		*capHeader |= CAP_F_NEAR;		// Cells have no pixel position: the flag picks the grid
+	cap_byte(row << 4 | col);
+
+	// Boards are drawn alternating two colours, so cells keep the last two in
+	// fg and bg: a new colour pushes fg into bg, a bg hit swaps them
+	if (capFgKnown && color == capFg) {
+		*capHeader |= CAP_F_SAME_FG;
+		return;
+	}
+	if (capBgKnown && color == capBg)
+		*capHeader |= CAP_F_SAME_BG;
+	else
+		cap_word(color);
+	capBg = capFg;
+	capBgKnown = capFgKnown;
+	capFg = color;
+	capFgKnown = true;
+}
+
+/**
+ * Log the EEPROM splash image.
+ */
+void gfx_capture_image(int16_t x, int16_t y, uint8_t scale) {
+	if (!cap_begin(CAP_IMAGE, 6))
+		return;
+	cap_pos(x, y);
+	cap_byte(scale);
+}
+
+/**
+ * Stop logging the primitives a captured high-level call is made of.
+ * Calls nest; each needs a matching gfx_capture_resume().
+ */
+void gfx_capture_suspend(void) {
+	capHold++;
+}
+
+void gfx_capture_resume(void) {
+	if (capHold)
+		capHold--;
+}
+
+/**
+ * Character `i` of a queued line (after the 'G'), or 0 past its end.
+ */
+static char cap_char(const CapLine *l, uint8_t i) {
+	uint8_t chars = (l->len * 4 + 2) / 3;
+	if (i == 0)
+		return l->tag;
+	if (i == 1)
+		return '0' + l->len;
+	i -= 2;
+	if (i >= chars)
+		return (i == chars) ? '\n' : 0;
+
+	// 3 bytes -> 4 characters, most significant bits first
+	uint8_t g = (i / 4) * 3, k = i % 4;
+	uint32_t v = (uint32_t)l->bytes[g] << 16;
+	if (g + 1 < l->len) v |= (uint16_t)l->bytes[g + 1] << 8;
+	if (g + 2 < l->len) v |= l->bytes[g + 2];
+	return '0' + ((v >> (18 - 6 * k)) & 0x3F);
+}
+
+/**
+ * Send at most one capture character. Call every 1 ms.
+ */
+void gfx_capture_tick(void) {
+	if (capTxPos == 0) {
+		if (capGap) {
+			capGap--;
+			return;
 		}
-		s++;
+		if (capQueued == 0) {
+			if (capOpen.len && ++capIdle >= CAP_FLUSH_MS)
+				cap_close();
+			return;
+		}
+	}
+
+	if (!(UCSR0A & (1 << UDRE0)))
+		return;
+
+	const CapLine *l = &capQueue[capHead];
+	char c = (capTxPos == 0) ? 'G' : cap_char(l, capTxPos - 1);
+	UDR0 = c;
+	capTxPos++;
+
+	if (c == '\n') {
+		capHead = (capHead + 1) % CAP_QUEUE_LINES;
+		capQueued--;
+		capTxPos = 0;
+		capGap = CAP_LINE_GAP_MS;
 	}
 }
 
+/**
+ * Called before a game frame is written: end a capture line in flight so
+ * the frame starts on a line of its own. The cut line is sent again later.
+ */
+void gfx_capture_yield(void) {
+	if (capTxPos == 0)
+		return;
+
+	while (!(UCSR0A & (1 << UDRE0)));
+	UDR0 = '\n';
+	capTxPos = 0;
+}
+#endif  // GFX_CAPTURE
@@ -8,6 +8,7 @@
 #define F_CPU 16000000UL
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -15,6 +16,8 @@
 #include <stdlib.h>
 
 #include "gfx.h"
+#include "anim.h"
+#include "arena.h"
 #include "battleship_utils.h"
 #include "buzzer.h"
 #include "singleplayer.h"
@@ -29,28 +32,16 @@ AIDifficulty aiDifficulty = AI_MEDIUM;
 /* -------------------------------------------------------------------------
  *  GLOBAL GAME STATE
  * ------------------------------------------------------------------------- */
-Ship	playerFleet[NUM_SHIPS];
-
 uint8_t lastEnemyRow = 0;
 uint8_t lastEnemyCol = 0;
 
-uint8_t selRow, selCol;						// Current selection cursor
-uint8_t ghostShipIdx;						// Ship being placed
-bool	ghostHorizontal;					// Ship placement orientation (horizontal/vertical)
-uint8_t playerRemaining, enemyRemaining;	// Number of remaining ships
+GameContext game = {
+	.pendingRow	  = -1,
+	.pendingCol	  = -1,
+	.pendingBlink = ANIM_NONE
+};
 
-static int8_t pendingRow = -1;				// Row of pending outgoing shot
-static int8_t pendingCol = -1;				// Col of pending outgoing shot
-
-/* -------------------------------------------------------------------------
- *  LOCAL STATE
- * ------------------------------------------------------------------------- */
-static uint32_t systemTime	    = 0;		// System milliseconds ticker
-static uint32_t nextMoveAllowed = 0;		// Joystick move repeat throttle
-
-static bool	buttonLatch			= false;	// Prevent multiple button presses
-static bool	overButtonLatch		= false;
-static uint8_t overTapCount		= 0;
+#define PENDING_BLINK_MS	250				// Pending shot blink period (half cycle)
 
 /* -------------------------------------------------------------------------
  *  UART (printf redirected)
@@ -60,86 +51,101 @@ static FILE uart_stdout = FDEV_SETUP_STREAM(uart_putchar, NULL, _FDEV_SETUP_WRIT
 /* -------------------------------------------------------------------------
  *  NETWORK PROTOCOL CONSTANTS
  * ------------------------------------------------------------------------- */
-#define RX_MAX 32
-
-static char	rxBuf[RX_MAX];			// RX buffer
-static uint8_t rxIdx          = 0;	// Current RX buffer index
-
-static uint16_t selfToken	  = 0;	// Local token (based on finish time)
-static uint16_t peerToken	  = 0;	// Remote peer token
-
-static uint16_t resendTick    = 0;	// ms since last packet sent
-static uint16_t postReadyLeft = 0;	// How long to keep sending READY after sync
-
-/* -------------------------------------------------------------------------
- *  GAME STATES
- * ------------------------------------------------------------------------- */
-
-// Game mode: determined by button selection in the main menu
-static enum {
-	GM_NONE,			// Default gMode is GM_NONE
-	GM_MULTIPLAYER,
-	GM_SINGLEPLAYER,
-	GM_SETTINGS_GEAR	// Hovering over setting gear in main menu
-} gMode;
-
-// Settings state: determined by button selection on the Settings screen
-static enum {
-	SETTINGS_NONE,			// Default sState is SETTINGS_NONE
-	SETTINGS_SOUNDS,
-	SETTINGS_DIFFICULTY,
-	SETTINGS_BACK	// Hovering over back button on Settings screen
-} sState;
-
-// Game states: initially GS_RESET and is determined throughout the game loop
-static enum {
-	GS_RESET,
-	GS_MAINMENU,
-	GS_SETTINGS,
-	GS_NEWGAME,
-	GS_PLACING,
-	GS_WAIT,
-	GS_MYTURN,
-	GS_WAITRES,
-	GS_ENEMYTURN,
-	GS_OVER
-} gState;
-
-// Network states
-static enum {
-	NS_IDLE,
-	NS_WAIT_READY,
-	NS_DECIDE,
-	NS_MY_TURN,
-	NS_PEER_TURN,
-	NS_WAIT_RES,
-	NS_GAME_OVER
-} nState;
+#define RX_MAX ARENA_RX_BYTES
+
+// Retransmission timing; override with -D for slower links (e.g. relayed over TCP)
+#ifndef ATTACK_RESEND_MS
+#define ATTACK_RESEND_MS		100		// First resend of an unanswered attack
+#endif
+#ifndef ATTACK_RESEND_MAX_MS
+#define ATTACK_RESEND_MAX_MS	1600	// Each further resend waits twice as long, up to this
+#endif
+#ifndef READY_RESEND_MS
+#define READY_RESEND_MS			500		// READY repeat while searching for the peer
+#endif
+#ifndef READY_LINGER_MS
+#define READY_LINGER_MS			2000	// Keep repeating READY this long after sync (0 = stop at once)
+#endif
+#ifndef PEER_TIMEOUT_MS
+#define PEER_TIMEOUT_MS			120000UL	// Give up on a peer that hasn't moved in this long
+#endif
+
+// Piggybacking: the result of the peer's shot rides on our next attack ("P" frame)
+#ifndef RESULT_HOLD_MS
+#define RESULT_HOLD_MS			80		// Longest a result waits for our attack before going alone (0 = never hold)
+#endif
+
+_Static_assert(RESULT_HOLD_MS < ATTACK_RESEND_MS, "A held result must go out before the peer resends its attack");
+_Static_assert(RESULT_HOLD_MS <= 255, "Result hold does not fit its 8-bit countdown");
+_Static_assert(ATTACK_RESEND_MS <= ATTACK_RESEND_MAX_MS, "Attack resend backoff starts above its cap");
+
+// Link statistics for soak tests (-DNET_STATS); reported in a "STATS" line at game over
+#ifdef NET_STATS
+static struct {
+	uint16_t txFrames;		// Frames sent (resends included)
+	uint16_t txResends;		// READY and attack resends
+	uint16_t rxFrames;		// Lines received
+	uint16_t rxBad;			// Lines dropped: unknown, malformed or overlong
+	uint16_t rxDup;			// Duplicate attacks and stale results
+	uint16_t shots;			// Our shots answered
+	uint32_t rttSum;		// ms from our attack to its result, summed
+	uint16_t rttMax;
+} netStats;
+static uint32_t attackSentAt = 0;
+#define NET_STAT(field)		(netStats.field++)
+#else
+#define NET_STAT(field)		((void)0)
+#endif
 
 void handle_reset(void);
 
+/* --- Input-to-photon latency (build with -DLATENCY_REPORT) --- */
+typedef enum {
+	LAT_CURSOR,				// Enemy-grid cursor move
+	LAT_GHOST,				// Placement ghost move
+	LAT_FIRE,				// Shot fired (pending cell and status line)
+	LAT_FOCUS,				// Menu/settings focus change
+	LAT_KINDS
+} LatKind;
+
+#ifdef LATENCY_REPORT
+static void lat_done(LatKind kind);
+static void lat_report(void);
+#define LAT_DONE(kind)		lat_done(kind)
+#else
+#define LAT_DONE(kind)		((void)0)
+#endif
+
 /* -------------------------------------------------------------------------
  *  PROTOCOL TRANSMISSION HELPERS
  * ------------------------------------------------------------------------- */
 /**
- * Transmit a READY packet.
+ * Transmit a READY packet. The trailing flags tell the peer we read "P"
+ * frames and answer radar "S" frames; older firmware stops parsing after the
+ * token, or reads only the first flag.
  */
 static inline void tx_ready(void) {
-	if (gMode == GM_SINGLEPLAYER) {
-		sp_on_tx_ready(selfToken);
+	if (game.gMode == GM_SINGLEPLAYER) {
+		sp_on_tx_ready(game.selfToken);
 	} else {
-		 printf("READY %u\n", selfToken);
+		 printf("READY %u PS\n", game.selfToken);
+		 NET_STAT(txFrames);
 	}
 }
 
 /**
- * Transmit an ATTACK on the enemy at row, col.
+ * Transmit an ATTACK on the enemy at row, col. A carried result goes in the
+ * same frame: "P <row> <col> <H|M> <attack row> <attack col>".
  */
 static inline void tx_attack(uint8_t r, uint8_t c) {
-	if (gMode == GM_SINGLEPLAYER) {
+	if (game.gMode == GM_SINGLEPLAYER) {
 		sp_on_tx_attack(r, c);
 	} else {
-		printf("A %u %u\n", r, c);
+		if (game.carrying)
+			printf("P %u %u %c %u %u\n", game.carryRow, game.carryCol, game.carryHit ? 'H' : 'M', r, c);
+		else
+			printf("A %u %u\n", r, c);
+		NET_STAT(txFrames);
 	}
 }
 
@@ -147,13 +153,69 @@ static inline void tx_attack(uint8_t r, uint8_t c) {
  * Transmit the RESULT of an enemy attack on row, col.
  */
 static inline void tx_result(uint8_t r, uint8_t c, bool hit) {
-	if (gMode == GM_SINGLEPLAYER) {
+	if (game.gMode == GM_SINGLEPLAYER) {
 		sp_on_tx_result(r, c, hit);
 	} else {
 		printf("R %u %u %c\n", r, c, hit ? 'H' : 'M');
+		NET_STAT(txFrames);
+	}
+}
+
+/**
+ * Transmit a radar SCAN around row, col; seq numbers our scans from 0.
+ */
+static inline void tx_scan(uint8_t seq, uint8_t r, uint8_t c) {
+	if (game.gMode == GM_SINGLEPLAYER) {
+		sp_on_tx_scan(seq, r, c);
+	} else {
+		printf("S %u %u %u\n", seq, r, c);
+		NET_STAT(txFrames);
+	}
+}
+
+/**
+ * Transmit the answer to a peer's SCAN: the ship cells around row, col.
+ */
+static inline void tx_scan_result(uint8_t r, uint8_t c, uint8_t count) {
+	if (game.gMode == GM_SINGLEPLAYER) {
+		sp_on_tx_scan_result(r, c, count);
+	} else {
+		printf("Q %u %u %u\n", r, c, count);
+		NET_STAT(txFrames);
 	}
 }
 
+/**
+ * Answer the peer's shot. If the peer reads "P" frames, hold the result for
+ * up to RESULT_HOLD_MS so it can ride on our next attack. The enemy-attack
+ * sound that follows plays from buzzer_tick(), so net_tick() keeps counting
+ * the hold down while it sounds.
+ */
+static void send_or_hold_result(uint8_t r, uint8_t c, bool hit) {
+	if (game.gMode == GM_MULTIPLAYER && game.peerPiggyback && RESULT_HOLD_MS > 0) {
+		game.carrying = true;
+		game.carryRow = r;
+		game.carryCol = c;
+		game.carryHit = hit;
+		game.holdLeft = RESULT_HOLD_MS;
+	} else {
+		tx_result(r, c, hit);
+	}
+}
+
+/**
+ * Print the link statistics for the game that just ended (-DNET_STATS).
+ * Peers ignore lines they don't know.
+ */
+static void net_report(void) {
+#ifdef NET_STATS
+	printf("STATS tx=%u rs=%u rx=%u bad=%u dup=%u rtt=%u/%u\n",
+		   netStats.txFrames, netStats.txResends, netStats.rxFrames, netStats.rxBad, netStats.rxDup,
+		   netStats.shots ? (uint16_t)(netStats.rttSum / netStats.shots) : 0, netStats.rttMax);
+	memset(&netStats, 0, sizeof(netStats));
+#endif
+}
+
 // Singleplayer Override
 void net_inject_line(const char *line);
 
@@ -161,13 +223,35 @@ void net_inject_line(const char *line);
  *  INCOMING LINE HANDLERS
  * ------------------------------------------------------------------------- */
 
+/**
+ * Abandon a game the peer is no longer playing and return to the menu.
+ */
+static void peer_lost(void) {
+	status_msg("Peer lost ? reset");
+	_delay_ms(2000);
+	handle_reset();
+}
+
 /**
  * Handle a READY packet received from peer.
  */
-static void on_ready(uint16_t tok) {
-	peerToken = tok;
-	if (nState == NS_WAIT_READY)
-		nState = NS_DECIDE;
+static void on_ready(uint16_t tok, bool piggyback, bool radar) {
+	// Frames carry no checksum, so a token is only believed once heard
+	// twice running (a dropped digit still parses as a number)
+	if (tok != game.peerNewToken) {
+		game.peerNewToken = tok;
+		return;
+	}
+	if (game.nState >= NS_MY_TURN && game.nState != NS_GAME_OVER) {
+		if (tok != game.peerToken)
+			peer_lost();	// Started over mid-game: it missed our winning result, or gave up on us
+		return;
+	}
+	game.peerToken = tok;
+	game.peerPiggyback = piggyback;
+	game.peerRadar = radar;
+	if (game.nState == NS_WAIT_READY)
+		game.nState = NS_DECIDE;
 }
 
 /**
@@ -178,37 +262,43 @@ static void on_attack(uint8_t r, uint8_t c) {
 		return; // Ignore invalid coordinates
 
 	// Was this cell already attacked?
-	bool first_time = !BITMAP_GET(playerAttackedAtBitmap, r, c);
-	BITMAP_SET(playerAttackedAtBitmap, r, c);
+	bool first_time = !BITMAP_GET(game.playerAttackedAtBitmap, r, c);
+	if (first_time && game.nState != NS_PEER_TURN)
+		return; // Not the peer's move (e.g. a resend from a game we already left)
+	BITMAP_SET(game.playerAttackedAtBitmap, r, c);
 
-	bool hit = BITMAP_GET(playerOccupiedBitmap, r, c);
+	bool hit = BITMAP_GET(game.playerOccupiedBitmap, r, c);
 
 	if (first_time) {
 		// First time being attacked here; update grid visually
-		draw_cell(r, c, hit ? CLR_HIT : CLR_MISS, PLAYER_GRID_X_PX);
+		draw_shot_cell(r, c, hit, PLAYER_GRID_X_PX);
 
-		if (hit && --playerRemaining == 0) {
+		if (hit && --game.playerRemaining == 0) {
 			// Game over (you lose)
 			tx_result(r, c, hit);
-			nState = NS_GAME_OVER;
-			gState = GS_OVER;
+			game.nState = NS_GAME_OVER;
+			game.gState = GS_OVER;
+			net_report();
+			if (game.gMode == GM_SINGLEPLAYER) sp_on_game_over();
 			status_msg("You lose ? tap twice");
 			gui_draw_lose_screen();
 			play_lose_sound(&soundsEnabled);
 		} else {
-			// Otherwise, send result and hand turn to you
-			tx_result(r, c, hit);
-			nState = NS_MY_TURN;
-			gState = GS_MYTURN;
+			// Otherwise, send (or hold) the result and hand turn to you
+			send_or_hold_result(r, c, hit);
+			game.nState = NS_MY_TURN;
+			game.gState = GS_MYTURN;
 			status_msg("Your turn");
-			nextMoveAllowed = systemTime;
-			gui_draw_play_screen();
-			draw_cursor(selRow, selCol, ENEMY_GRID_X_PX);
+			game.nextMoveAllowed = game.systemTime;
+			draw_cursor(game.selRow, game.selCol, ENEMY_GRID_X_PX);
 			play_enemy_attack_sound(&hit, &soundsEnabled);
 		}
 	} else {
-		// Duplicate attack (already attacked here); peer still must reply
-		tx_result(r, c, hit);
+		// Duplicate attack (already attacked here); peer still must reply,
+		// unless the result is still being held for our attack
+		NET_STAT(rxDup);
+		if (!(game.holdLeft && r == game.carryRow && c == game.carryCol))
+			tx_result(r, c, hit);
 	}
 }
 
@@ -216,57 +306,166 @@ static void on_attack(uint8_t r, uint8_t c) {
  * Handle a RESULT packet received from peer (outcome of our shot).
  */
 static void on_result(uint8_t r, uint8_t c, bool hit) {
-	if (pendingRow < 0)
-		return; // Ignore stray result if we don't have a pending shot
+	if (game.pendingScan || game.pendingRow != r || game.pendingCol != c) {
+		NET_STAT(rxDup);
+		return; // Ignore stray or stale results (none pending, or for an earlier shot)
+	}
+
+#ifdef NET_STATS
+	uint16_t rtt = game.systemTime - attackSentAt;
+	netStats.shots++;
+	netStats.rttSum += rtt;
+	if (rtt > netStats.rttMax)
+		netStats.rttMax = rtt;
+#endif
+
+	// The peer has our shot and its result, so a result we carried got through
+	game.carrying = false;
 
 	// 1 - If sounds enabled, play hit or miss sound depending on outcome
 	play_attack_sound(&hit, &soundsEnabled);
 
-	// 2 - Erase pending cyan cell
-	draw_cell(pendingRow, pendingCol, CLR_NAVY, ENEMY_GRID_X_PX);
-	pendingRow = pendingCol = -1;
+	// 2 - Stop blinking (step 3 repaints the pending cell)
+	anim_stop(game.pendingBlink);
+	game.pendingBlink = ANIM_NONE;
+	game.pendingRow = game.pendingCol = -1;
 
-	// 3 - Paint final outcome
-	draw_cell(r, c, hit ? CLR_HIT : CLR_MISS, ENEMY_GRID_X_PX);
+	// 3 - Paint final outcome (the explosion or splash plays on from anim_tick)
+	draw_shot_cell(r, c, hit, ENEMY_GRID_X_PX);
 
 	// 4 - Mark in our enemy bitmaps
-	if (hit) BITMAP_SET(enemyConfirmedHitBitmap, r, c);
+	if (hit) BITMAP_SET(game.enemyConfirmedHitBitmap, r, c);
 
 	// 5 - Redraw selection cursor
-	draw_cursor(selRow, selCol, ENEMY_GRID_X_PX);
+	draw_cursor(game.selRow, game.selCol, ENEMY_GRID_X_PX);
 
 	// 6 - Check for game end or enemy turn
-	if (hit && --enemyRemaining == 0) {
-		nState = NS_GAME_OVER;
-		gState = GS_OVER;
+	if (hit && --game.enemyRemaining == 0) {
+		game.nState = NS_GAME_OVER;
+		game.gState = GS_OVER;
+		net_report();
+		if (game.gMode == GM_SINGLEPLAYER) sp_on_game_over();
 		status_msg("You win! ? tap twice");
 		gui_draw_win_screen();
 		play_win_sound(&soundsEnabled);
 	} else {
-		nState = NS_PEER_TURN;
-		gState = GS_ENEMYTURN;
+		game.nState = NS_PEER_TURN;
+		game.gState = GS_ENEMYTURN;
 		status_msg("Enemy turn");
 	}
 }
 
 /**
- * Parse a full incoming line from UART.
+ * Handle a SCAN packet: tell the peer how many of our ship cells lie around
+ * (r, c). The first copy of each scan also ends the peer's turn, so a new scan
+ * is only taken on the peer's turn and within its RADAR_USES budget.
  */
-static void parse_line(char *l) {
+static void on_scan(uint8_t seq, uint8_t r, uint8_t c) {
+	if (r >= GRID_ROWS || c >= GRID_COLS || seq >= RADAR_USES)
+		return; // Ignore invalid coordinates and scans past the budget
+
+	if (seq < game.peerScans) {
+		// A resend: answered again, but the turn has already passed
+		NET_STAT(rxDup);
+		tx_scan_result(r, c, radar_count(game.playerOccupiedBitmap, r, c));
+		return;
+	}
+	if (game.nState != NS_PEER_TURN)
+		return; // Not the peer's move
+
+	tx_scan_result(r, c, radar_count(game.playerOccupiedBitmap, r, c));
+	game.peerScans = seq + 1;
+	game.nState = NS_MY_TURN;
+	game.gState = GS_MYTURN;
+	game.nextMoveAllowed = game.systemTime;
+	status_msg("Radar ping! Your turn");
+	draw_cursor(game.selRow, game.selCol, ENEMY_GRID_X_PX);
+}
+
+/**
+ * Handle a SCAN answer from the peer (outcome of our scan).
+ */
+static void on_scan_result(uint8_t r, uint8_t c, uint8_t count) {
+	if (!game.pendingScan || game.pendingRow != r || game.pendingCol != c) {
+		NET_STAT(rxDup);
+		return; // Ignore stray or stale answers
+	}
+
+	game.pendingScan = false;
+	game.pendingRow = game.pendingCol = -1;
+	game.enemyScans[RADAR_USES - 1 - game.radarLeft] = (RadarScan){ r, c, count };
+
+	// 1 - Reveal the area, then put the cursor back over it
+	draw_radar_area(r, c);
+	draw_cursor(game.selRow, game.selCol, ENEMY_GRID_X_PX);
+
+	// 2 - Report the count
+	char msg[24];
+	snprintf(msg, sizeof(msg), "Radar: %u ship cells", count);
+	status_msg(msg);
+	bool found = count > 0;
+	play_radar_sound(&found, &soundsEnabled);
+
+	// 3 - The scan used our turn
+	game.nState = NS_PEER_TURN;
+	game.gState = GS_ENEMYTURN;
+
+	if (!button_is_pressed()) game.buttonLatch = false;
+}
+
+/**
+ * Parse a full incoming line from UART. Returns false if the line was not
+ * a well-formed frame. Frames carry no checksum, so anything left over after
+ * the last field (two lines run together by a dropped byte) rejects the line
+ * rather than letting "R 6 7 " + "READY..." pass as a miss.
+ */
+#define IS_OUTCOME(h)	((h) == 'H' || (h) == 'M')
+
+static bool parse_line(const char *l) {
+	char x;
 	if (!strncmp(l, "READY", 5)) {
 		uint16_t t;
-		if (sscanf(l + 5, "%u", &t) == 1)
-			on_ready(t);
+		char flags[4] = "";
+		uint8_t n = sscanf(l + 5, "%u %3s %c", &t, flags, &x);
+		if (n == 1 || n == 2) {
+			on_ready(t, strchr(flags, 'P') != NULL, strchr(flags, 'S') != NULL);
+			return true;
+		}
 	} else if (l[0] == 'A') {
 		uint8_t r, c;
-		if (sscanf(l + 1, "%hhu %hhu", &r, &c) == 2)
+		if (sscanf(l + 1, "%hhu %hhu %c", &r, &c, &x) == 2) {
 			on_attack(r, c);
+			return true;
+		}
 	} else if (l[0] == 'R') {
 		uint8_t r, c;
 		char h;
-		if (sscanf(l + 1, "%hhu %hhu %c", &r, &c, &h) == 3)
+		if (sscanf(l + 1, "%hhu %hhu %c %c", &r, &c, &h, &x) == 3 && IS_OUTCOME(h)) {
+			on_result(r, c, h == 'H');
+			return true;
+		}
+	} else if (l[0] == 'P') {
+		uint8_t r, c, ar, ac;
+		char h;
+		if (sscanf(l + 1, "%hhu %hhu %c %hhu %hhu %c", &r, &c, &h, &ar, &ac, &x) == 5 && IS_OUTCOME(h)) {
 			on_result(r, c, h == 'H');
+			on_attack(ar, ac);			// Ignored if that result won us the game
+			return true;
+		}
+	} else if (l[0] == 'S') {
+		uint8_t seq, r, c;
+		if (sscanf(l + 1, "%hhu %hhu %hhu %c", &seq, &r, &c, &x) == 3) {
+			on_scan(seq, r, c);
+			return true;
+		}
+	} else if (l[0] == 'Q') {
+		uint8_t r, c, n;
+		if (sscanf(l + 1, "%hhu %hhu %hhu %c", &r, &c, &n, &x) == 3) {
+			on_scan_result(r, c, n);
+			return true;
+		}
 	}
+	return false;
 }
 
 /* -------------------------------------------------------------------------
@@ -281,42 +480,60 @@ static void net_tick(void) {
 	/* --- UART Receiving --- */
 	while (uart_char_available()) {
 		char c = uart_getchar();
+		if (!game.rxBuf)
+			continue;				// No multiplayer game: drop the byte
 		if (c == '\n' || c == '\r') {
-			if (rxIdx) {
-				rxBuf[rxIdx] = '\0';
-				parse_line(rxBuf);
-				rxIdx = 0;
+			if (game.rxIdx == RX_MAX) {
+				NET_STAT(rxBad);	// Overlong: not a frame, don't parse the truncated part
+			} else if (game.rxIdx) {
+				game.rxBuf[game.rxIdx] = '\0';
+				NET_STAT(rxFrames);
+				if (!parse_line(game.rxBuf))
+					NET_STAT(rxBad);
 			}
-		} else if (rxIdx < RX_MAX - 1) {
-			rxBuf[rxIdx++] = c;
+			game.rxIdx = 0;
+		} else if (game.rxIdx < RX_MAX - 1) {
+			game.rxBuf[game.rxIdx++] = c;
+		} else {
+			game.rxIdx = RX_MAX;			// Line overflowed; dropped at its end
 		}
 	}
 
 	/* --- READY packet retransmission logic --- */
-	bool needReady = (nState == NS_WAIT_READY) || (postReadyLeft > 0);
-	if (needReady && ++resendTick >= 500) {
-		resendTick = 0;
+	bool needReady = (game.nState == NS_WAIT_READY) || (game.postReadyLeft > 0);
+	if (needReady && ++game.resendTick >= READY_RESEND_MS) {
+		game.resendTick = 0;
 		tx_ready();
+		NET_STAT(txResends);
+	}
+
+	/* --- Held result: send it alone if we didn't attack in time --- */
+	if (game.holdLeft && --game.holdLeft == 0) {
+		tx_result(game.carryRow, game.carryCol, game.carryHit);
+		game.carrying = false;
 	}
 
 	/* --- Attack retransmission logic --- */
-	if (nState == NS_WAIT_RES && ++resendTick >= 100) {
-		tx_attack(pendingRow, pendingCol);
-		resendTick = 0;
+	if (game.nState == NS_WAIT_RES && ++game.resendTick >= game.resendWait) {
+		if (game.pendingScan)
+			tx_scan(RADAR_USES - 1 - game.radarLeft, game.pendingRow, game.pendingCol);
+		else
+			tx_attack(game.pendingRow, game.pendingCol);
+		game.resendTick = 0;
+		game.resendWait = (game.resendWait < ATTACK_RESEND_MAX_MS / 2) ? game.resendWait * 2 : ATTACK_RESEND_MAX_MS;
+		NET_STAT(txResends);
 	}
 
-	/* --- Peer timeout while waiting for their move --- */
-	if (nState == NS_PEER_TURN) {
-		if (++resendTick >= 120000) { // 2 minutes timeout
-			status_msg("Peer lost ? reset");
-			_delay_ms(2000);
-			handle_reset();
-		}
+	/* --- Peer timeout while waiting for their move or answer --- */
+	if (game.nState != NS_PEER_TURN && game.nState != NS_WAIT_RES) {
+		game.peerWaitTick = 0;
+	} else if (++game.peerWaitTick >= PEER_TIMEOUT_MS) {
+		peer_lost();
 	}
 
 	/* --- Decrease post-ready extra countdown --- */
-	if (postReadyLeft)
-		postReadyLeft--;
+	if (game.postReadyLeft)
+		game.postReadyLeft--;
 }
 
 /* -------------------------------------------------------------------------
@@ -324,189 +541,268 @@ static void net_tick(void) {
  * ------------------------------------------------------------------------- */
 void handle_reset(void) {
 	board_reset();
-	ghostShipIdx	= 0;
-	ghostHorizontal = true;
-	selRow = selCol = GRID_ROWS / 2;
-	nState		    = NS_IDLE;
-	peerToken	    = 0;
-	resendTick	    = 0;
-	postReadyLeft   = 0;
-
+	game.ghostShipIdx	= 0;
+	game.ghostHorizontal = true;
+	game.selRow = game.selCol = GRID_ROWS / 2;
+	game.nState		    = NS_IDLE;
+	game.peerToken	    = 0;
+	game.peerNewToken    = 0;
+	game.resendTick	    = 0;
+	game.postReadyLeft   = 0;
+	game.peerPiggyback   = false;
+	game.peerRadar	    = false;
+	game.carrying	    = false;
+	game.holdLeft	    = 0;
+	game.pendingBlink    = ANIM_NONE;
+
+#ifdef LATENCY_REPORT
+	lat_report();
+#endif
+#ifdef ARENA_REPORT
+	printf("ARENA %u %u %u\n", arena_peak(ARENA_MENU), arena_peak(ARENA_SETTINGS), arena_peak(ARENA_GAME));
+#endif
+	widgets_close();
+	uart_rx_ring(NULL);					// Before the arena hands its ring out again
+	arena_enter(ARENA_MENU);			// Drops the game's buffers
+	game.rxBuf = NULL;
 	gui_draw_main_menu();
 
-	gState = GS_MAINMENU;
-	sState = SETTINGS_NONE;
-	gMode = GM_NONE;
+	game.gState = GS_MAINMENU;
+	game.gMode = GM_NONE;
 }
 
 /* -------------------------------------------------------------------------
- *  MAIN MENU SCREEN - USER SELECTS SINGLE OR MULTIPLAYER MODE, OR SETTINGS
+ *  MENU NAVIGATION
  * ------------------------------------------------------------------------- */
-static void handle_main_menu(void) {
-	/* --- Select single/multiplayer mode with the joystick, and update button textures --- */
+/**
+ * Read the joystick as a menu direction (vertical axis first).
+ * Returns false while the stick is centred.
+ */
+static bool joystick_nav(NavDir *dir) {
 	uint16_t x = adc_read(0);
 	uint16_t y = adc_read(1);
 
-	switch (gMode) {
-		// No button currently selected
-		case GM_NONE:
-			if (y < JOY_MIN_RAW) {			   // Joystick up, go to multiplayer button
-				gMode = GM_MULTIPLAYER;
-				gui_draw_multiplayer_button(CLR_WHITE, CLR_CYAN);
-			} else if (y > JOY_MAX_RAW) {		// Joystick down, go to singleplayer button
-				gMode = GM_SINGLEPLAYER;
-				gui_draw_singleplayer_button(CLR_WHITE, CLR_GREEN);
-			}
-			break;
+	if (y < JOY_MIN_RAW)		*dir = NAV_UP;
+	else if (y > JOY_MAX_RAW)	*dir = NAV_DOWN;
+	else if (x < JOY_MIN_RAW)	*dir = NAV_LEFT;
+	else if (x > JOY_MAX_RAW)	*dir = NAV_RIGHT;
+	else						return false;
+	return true;
+}
 
-		// Multiplayer button currently selected
-		case GM_MULTIPLAYER:
-			if (y > JOY_MAX_RAW) {			   // Joystick down, go to singleplayer button (and fade out multiplayer button)
-				gMode = GM_SINGLEPLAYER;
-				gui_draw_singleplayer_button(CLR_WHITE, CLR_GREEN);
-				gui_draw_multiplayer_button(CLR_LIGHT_GRAY, CLR_DARK_GRAY);
-			}
-			break;
+#ifdef LATENCY_REPORT
+/* -------------------------------------------------------------------------
+ *  LATENCY REPORT
+ * ------------------------------------------------------------------------- */
+// Time from an input change (stick leaves centre or changes direction, button
+// goes down) to the end of the redraw it causes, on Timer0 at F_CPU/64 (4 us).
+// The input is sampled at the top of every tick, so the real change may be up
+// to one tick earlier; the two extra ADC reads add ~0.2 ms per tick.
+#define LAT_US_PER_COUNT	4
+#define LAT_BUCKETS			16
+
+// Bucket upper bounds in units of 100 us; the last bucket is open
+static const uint16_t LAT_EDGES[LAT_BUCKETS - 1] = { 5, 10, 15, 20, 30, 40, 60, 80, 120, 160, 240, 320, 480, 640, 960 };
+static const char LAT_NAMES[LAT_KINDS][7] = { "cursor", "ghost", "fire", "focus" };
+
+static volatile uint32_t latOverflows = 0;
+static uint8_t  latInput = 0;				// Last sampled input: direction + 1, button in bit 7
+static bool     latPending = false;			// A change is waiting for its redraw
+static uint32_t latStamp;					// When it was seen (us)
+static struct {
+	uint16_t count[LAT_BUCKETS];
+	uint16_t n;
+	uint32_t max;							// us
+} latStats[LAT_KINDS];
+
+ISR(TIMER0_OVF_vect) {
+	latOverflows++;
+}
 
-		// Singleplayer button currently selected
-		case GM_SINGLEPLAYER:
-			if (y < JOY_MIN_RAW) {			   // Joystick up, go to multiplayer button (and fade out singleplayer button)
-				gMode = GM_MULTIPLAYER;
-				gui_draw_multiplayer_button(CLR_WHITE, CLR_CYAN);
-				gui_draw_singleplayer_button(CLR_LIGHT_GRAY, CLR_DARK_GRAY);
-			}
-			else if (x > JOY_MAX_RAW) {		 // Joystick right, go to settings gear icon (and fade out singleplayer button)
-				gMode = GM_SETTINGS_GEAR;
-				gui_draw_settings_gear(CLR_WHITE);
-				gui_draw_singleplayer_button(CLR_LIGHT_GRAY, CLR_DARK_GRAY);
-			}
-			break;
+static void lat_init(void) {
+	TCCR0A = 0;
+	TCCR0B = (1 << CS01) | (1 << CS00);		// Normal mode, clk/64
+	TIMSK0 = 1 << TOIE0;
+	sei();
+}
 
-		// Settings gear currently selected
-		case GM_SETTINGS_GEAR:
-			if (x < JOY_MIN_RAW) {			   // Joystick left, go to singleplayer button (and fade out settings gear)
-				gMode = GM_SINGLEPLAYER;
-				gui_draw_singleplayer_button(CLR_WHITE, CLR_GREEN);
-				gui_draw_settings_gear(CLR_LIGHT_GRAY);
-				_delay_ms(200);
-			}
-			break;
+static uint32_t lat_now_us(void) {
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t ovf = latOverflows;
+	uint8_t t = TCNT0;
+	if ((TIFR0 & (1 << TOV0)) && t < 255)
+		ovf++;								// Overflowed after cli(), not yet counted
+	SREG = sreg;
+	return (ovf * 256 + t) * LAT_US_PER_COUNT;
+}
+
+/**
+ * Sample the stick and button; stamp a change that could start an interaction.
+ */
+static void lat_poll(void) {
+	NavDir dir;
+	uint8_t in = joystick_nav(&dir) ? dir + 1 : 0;
+	if (button_is_pressed())
+		in |= 0x80;
+
+	bool pressed = (in & 0x80) && !(latInput & 0x80);
+	bool steered = (in & 0x7F) && (in & 0x7F) != (latInput & 0x7F);
+	if (pressed || steered) {
+		latPending = true;
+		latStamp = lat_now_us();
+	} else if (in == 0) {
+		latPending = false;		// Let go before anything was drawn: nothing to time
 	}
+	latInput = in;
+}
 
-	/* --- If user presses the joystick after selecting a gamemode, start a game --- */
-	if (button_is_pressed() && (gMode == GM_MULTIPLAYER || gMode == GM_SINGLEPLAYER)) {
-		gState = GS_NEWGAME;
+/**
+ * The redraw for an interaction of `kind` has sent its last SPI byte.
+ * Repeats of a held input have no pending change and are not counted.
+ */
+static void lat_done(LatKind kind) {
+	if (!latPending)
+		return;
+	latPending = false;
+
+	uint32_t us = lat_now_us() - latStamp;
+	uint8_t b = 0;
+	while (b < LAT_BUCKETS - 1 && us > LAT_EDGES[b] * 100UL)
+		b++;
+
+	latStats[kind].count[b]++;
+	latStats[kind].n++;
+	if (us > latStats[kind].max)
+		latStats[kind].max = us;
+}
+
+/**
+ * Upper bound (us) of the bucket holding the `pct` percentile, 0 if open-ended.
+ */
+static uint32_t lat_percentile(uint8_t kind, uint8_t pct) {
+	uint32_t need = ((uint32_t)latStats[kind].n * pct + 99) / 100, seen = 0;
+	for (uint8_t b = 0; b < LAT_BUCKETS - 1; b++) {
+		seen += latStats[kind].count[b];
+		if (seen >= need)
+			return LAT_EDGES[b] * 100UL;
 	}
-	/* --- If user presses the joystick after selecting the settings gear, go to settings --- */
-	else if (button_is_pressed() && (gMode == GM_SETTINGS_GEAR)) {
-		gui_draw_settings_screen(&soundsEnabled, &aiDifficulty);
-		gState = GS_SETTINGS;
+	return 0;
+}
+
+/**
+ * Print "LAT <kind> n= p50<= p99<= max=" (us) per interaction seen, then start over.
+ */
+static void lat_report(void) {
+	for (uint8_t k = 0; k < LAT_KINDS; k++) {
+		if (latStats[k].n == 0)
+			continue;
+		printf("LAT %s n=%u p50<=%lu p99<=%lu max=%lu\n", LAT_NAMES[k], latStats[k].n,
+			   lat_percentile(k, 50), lat_percentile(k, 99), latStats[k].max);
 	}
+	memset(latStats, 0, sizeof(latStats));
 }
+#endif
 
 /* -------------------------------------------------------------------------
- *  SETTINGS MENU SCREEN
+ *  MAIN MENU SCREEN - USER SELECTS SINGLE OR MULTIPLAYER MODE, OR SETTINGS
  * ------------------------------------------------------------------------- */
-static void handle_settings(void) {
-	/* --- Select settings to change with the joystick, and update button textures --- */
-	uint16_t x = adc_read(0);
-	uint16_t y = adc_read(1);
-
-	switch (sState) {
-
-		// No button currently selected
-		case SETTINGS_NONE:
-
-		if (y < JOY_MIN_RAW) {				// Joystick up, go to sound toggle button
-			sState = SETTINGS_SOUNDS;
-			gui_draw_sound_toggle_button(CLR_WHITE, CLR_CYAN, &soundsEnabled);
-			} else if (y > JOY_MAX_RAW) {		// Joystick down, go to Difficulty selector button
-			sState = SETTINGS_DIFFICULTY;
-			gui_draw_difficulty_button(CLR_WHITE, CLR_ORANGE, &aiDifficulty);
-		}
-		break;
-
-		// Sounds button currently selected
-		case SETTINGS_SOUNDS:
-
-		if (y > JOY_MAX_RAW) {				// Joystick down, go to Difficulty selector button (and fade out sounds button)
-			sState = SETTINGS_DIFFICULTY;
-			gui_draw_sound_toggle_button(CLR_NONE, CLR_DARK_GRAY, &soundsEnabled);
-			gui_draw_difficulty_button(CLR_WHITE, CLR_ORANGE, &aiDifficulty);
-		}
-		break;
+static void handle_main_menu(void) {
+	/* --- Move between the buttons and gear with the joystick; only the widgets that changed are repainted --- */
+	NavDir dir;
+	bool nav = joystick_nav(&dir);
+
+	// Any input cuts the title fade short
+	if ((nav || button_is_pressed()) && anim_active()) {
+		anim_finish_all();
+		game.pendingBlink = ANIM_NONE;
+	}
 
-		// Difficulty button currently selected
-		case SETTINGS_DIFFICULTY:
+	if (nav && widgets_navigate(dir)) {
+		widgets_render();
+		LAT_DONE(LAT_FOCUS);
+	}
 
-		if (y < JOY_MIN_RAW) {				// Joystick up, go to sounds button (and fade out difficulty button)
-			sState = SETTINGS_SOUNDS;
-			gui_draw_difficulty_button(CLR_NONE, CLR_DARK_GRAY, &aiDifficulty);
-			gui_draw_sound_toggle_button(CLR_WHITE, CLR_CYAN, &soundsEnabled);
-		}
-		else if (x < JOY_MIN_RAW) {			// Joystick left, go to back button (and fade out difficulty button)
-			sState = SETTINGS_BACK;
-			gui_draw_settings_back(CLR_WHITE);
-			gui_draw_difficulty_button(CLR_NONE, CLR_DARK_GRAY, &aiDifficulty);
-		}
-		break;
+	uint8_t focus = widgets_focus();
 
-		// Back button currently selected
-		case SETTINGS_BACK:
+	/* --- If user presses the joystick after selecting a gamemode, start a game --- */
+	if (button_is_pressed() && (focus == WID_MULTIPLAYER || focus == WID_VERSUS_AI)) {
+		game.gMode = (focus == WID_MULTIPLAYER) ? GM_MULTIPLAYER : GM_SINGLEPLAYER;
+		game.gState = GS_NEWGAME;
+	}
+	/* --- If user presses the joystick after selecting the settings gear, go to settings --- */
+	else if (button_is_pressed() && (focus == WID_GEAR)) {
+		widgets_close();
+		arena_enter(ARENA_SETTINGS);
+		gui_draw_settings_screen(soundsEnabled, aiDifficulty);
+		game.gState = GS_SETTINGS;
+	}
+}
 
-		if (x > JOY_MAX_RAW) {				// Joystick right, go to difficulty button (and fade out settings back)
-			sState = SETTINGS_DIFFICULTY;
-			gui_draw_difficulty_button(CLR_WHITE, CLR_ORANGE, &aiDifficulty);
-			gui_draw_settings_back(CLR_LIGHT_GRAY);
-			_delay_ms(200);
-		}
-		break;
+/* -------------------------------------------------------------------------
+ *  SETTINGS MENU SCREEN
+ * ------------------------------------------------------------------------- */
+static void handle_settings(void) {
+	/* --- Select settings to change with the joystick; only the widgets that changed are repainted --- */
+	NavDir dir;
+	if (joystick_nav(&dir) && widgets_navigate(dir)) {
+		widgets_render();
+		LAT_DONE(LAT_FOCUS);
 	}
 
+	uint8_t focus = widgets_focus();
+
 	/* --- If user presses the joystick after on sound button, toggle sounds enabled --- */
-	if (button_is_pressed() && (sState == SETTINGS_SOUNDS) && !buttonLatch) {
-		buttonLatch = true;
+	if (button_is_pressed() && (focus == WID_SOUNDS) && !game.buttonLatch) {
+		game.buttonLatch = true;
 		soundsEnabled = !soundsEnabled;
-		gui_draw_sound_toggle_button(CLR_WHITE, CLR_CYAN, &soundsEnabled);
+		widgets_set_value(WID_SOUNDS, soundsEnabled);
+		widgets_render();
 	}
 
 	/* --- If user presses the joystick on difficulty button, increment AI difficulty --- */
-	if (button_is_pressed() && (sState == SETTINGS_DIFFICULTY) && !buttonLatch) {
-		buttonLatch = true;
+	if (button_is_pressed() && (focus == WID_DIFFICULTY) && !game.buttonLatch) {
+		game.buttonLatch = true;
 		// Advance through AI_EASY -> AI_MEDIUM -> AI_HARD -> back to AI_EASY
 		aiDifficulty = (AIDifficulty)((aiDifficulty + 1) % 3);
-		// Redraw the button to show the new label/color
-		gui_draw_difficulty_button(CLR_WHITE, CLR_ORANGE, &aiDifficulty);
+		// Only the label changes; the border stays as drawn
+		widgets_set_value(WID_DIFFICULTY, aiDifficulty);
+		widgets_render();
 	}
 
 	/* --- If user presses the joystick after selecting the back button, go to Main Menu --- */
-	else if (button_is_pressed() && (sState == SETTINGS_BACK) && !buttonLatch) {
-		buttonLatch = true;
+	else if (button_is_pressed() && (focus == WID_BACK) && !game.buttonLatch) {
+		game.buttonLatch = true;
 		handle_reset();
 	}
 
-	if (!button_is_pressed()) buttonLatch = false;
+	if (!button_is_pressed()) game.buttonLatch = false;
 }
 
 /* -------------------------------------------------------------------------
  *  START A NEW GAME - DRAW THE BOARD
  * ------------------------------------------------------------------------- */
 static void handle_new_game(void) {
-	if (gMode == GM_SINGLEPLAYER) sp_reset();
+	widgets_close();					// The menu's widget state is in the arena
+	arena_enter(ARENA_GAME);
+	if (game.gMode == GM_SINGLEPLAYER) {
+		sp_reset();
+	} else {
+		game.rxBuf = arena_alloc(RX_MAX);
+		game.rxIdx = 0;
+		uart_rx_ring(arena_alloc(ARENA_UART_RING_BYTES));
+	}
 	gui_draw_placement();
-	gState = GS_PLACING;
+	game.gState = GS_PLACING;
 }
 
 /* -------------------------------------------------------------------------
  *  FLEET PLACEMENT SCREEN
  * ------------------------------------------------------------------------- */
 static void handle_placing(void) {
-	static uint32_t invalidTimer = 0;
-	static bool showInvalid	  = false;
-
-	if (showInvalid) {
-		if (systemTime - invalidTimer >= 500) {
-			showInvalid = false;
+	if (game.showInvalid) {
+		if (game.systemTime - game.invalidTimer >= 500) {
+			game.showInvalid = false;
 			status_msg("Use stick to place");
 		} else {
 			return;
@@ -517,86 +813,85 @@ static void handle_placing(void) {
 	uint16_t x = adc_read(0);
 	uint16_t y = adc_read(1);
 	bool moved = false;
-	uint8_t oldR = selRow, oldC = selCol;
 
-	if (systemTime >= nextMoveAllowed) {
-		if		(y < JOY_MIN_RAW && selRow > 0)				{ --selRow; moved = true; }
-		else if (y > JOY_MAX_RAW && selRow < GRID_ROWS - 1)	{ ++selRow; moved = true; }
-		else if (x < JOY_MIN_RAW && selCol > 0)				{ --selCol; moved = true; }
-		else if (x > JOY_MAX_RAW && selCol < GRID_COLS - 1)	{ ++selCol; moved = true; }
+	if (game.systemTime >= game.nextMoveAllowed) {
+		if		(y < JOY_MIN_RAW && game.selRow > 0)				{ --game.selRow; moved = true; }
+		else if (y > JOY_MAX_RAW && game.selRow < GRID_ROWS - 1)	{ ++game.selRow; moved = true; }
+		else if (x < JOY_MIN_RAW && game.selCol > 0)				{ --game.selCol; moved = true; }
+		else if (x > JOY_MAX_RAW && game.selCol < GRID_COLS - 1)	{ ++game.selCol; moved = true; }
 
 		if (moved) {
-			uint8_t len = SHIP_LENGTHS[ghostShipIdx];
-			if (ghostHorizontal && selCol > GRID_COLS - len) selCol = GRID_COLS - len;
-			if (!ghostHorizontal && selRow > GRID_ROWS - len) selRow = GRID_ROWS - len;
-			ghost_update(oldR, oldC, ghostHorizontal, false);
-			ghost_update(selRow, selCol, ghostHorizontal, true);
-			nextMoveAllowed = systemTime + JOY_REPEAT_DELAY_MS;
+			uint8_t len = SHIP_LENGTHS[game.ghostShipIdx];
+			if (game.ghostHorizontal && game.selCol > GRID_COLS - len) game.selCol = GRID_COLS - len;
+			if (!game.ghostHorizontal && game.selRow > GRID_ROWS - len) game.selRow = GRID_ROWS - len;
+			ghost_update(game.selRow, game.selCol, game.ghostHorizontal);
+			LAT_DONE(LAT_GHOST);
+			game.nextMoveAllowed = game.systemTime + JOY_REPEAT_DELAY_MS;
 		}
 	}
 
 	/* --- Button handling for placement/rotation --- */
 	bool pressed = button_is_pressed();
-	if (pressed && !buttonLatch) {
-		buttonLatch = true;
-		uint32_t holdStart = systemTime;
+	if (pressed && !game.buttonLatch) {
+		game.buttonLatch = true;
+		uint32_t holdStart = game.systemTime;
 
 		// Check for long hold vs short press
-		while (button_is_pressed() && (systemTime - holdStart) < 1000) {
+		while (button_is_pressed() && (game.systemTime - holdStart) < 1000) {
 			_delay_ms(1);
-			systemTime++;
+			game.systemTime++;
 			net_tick(); // Keep network responsive while holding
+			buzzer_tick();
 		}
 
-		if ((systemTime - holdStart) >= 500) {
+		if ((game.systemTime - holdStart) >= 500) {
 			/* Long hold = rotate ship */
-			ghost_update(selRow, selCol, ghostHorizontal, false);
-			ghostHorizontal = !ghostHorizontal;
+			game.ghostHorizontal = !game.ghostHorizontal;
 
-			uint8_t len = SHIP_LENGTHS[ghostShipIdx];
-			if (ghostHorizontal && selCol > GRID_COLS - len) selCol = GRID_COLS - len;
-			if (!ghostHorizontal && selRow > GRID_ROWS - len) selRow = GRID_ROWS - len;
+			uint8_t len = SHIP_LENGTHS[game.ghostShipIdx];
+			if (game.ghostHorizontal && game.selCol > GRID_COLS - len) game.selCol = GRID_COLS - len;
+			if (!game.ghostHorizontal && game.selRow > GRID_ROWS - len) game.selRow = GRID_ROWS - len;
 
-			ghost_update(selRow, selCol, ghostHorizontal, true);
+			ghost_update(game.selRow, game.selCol, game.ghostHorizontal);
 		} else {
 			/* Short press = attempt to place ship */
-			uint8_t len = SHIP_LENGTHS[ghostShipIdx];
-			if (ship_can_fit(playerOccupiedBitmap, selRow, selCol, len, ghostHorizontal)) {
-				ghost_update(selRow, selCol, ghostHorizontal, false);
-				player_place_current_ship(selRow, selCol, ghostHorizontal, len);
+			uint8_t len = SHIP_LENGTHS[game.ghostShipIdx];
+			if (ship_can_fit(game.playerOccupiedBitmap, game.selRow, game.selCol, len, game.ghostHorizontal)) {
+				// Painting the ship cells also replaces the ghost on them
+				player_place_current_ship(game.selRow, game.selCol, game.ghostHorizontal, len);
 
-				ghostShipIdx++;
+				game.ghostShipIdx++;
 
-				if (ghostShipIdx < NUM_SHIPS) {
-					uint8_t nextLen = SHIP_LENGTHS[ghostShipIdx];
+				if (game.ghostShipIdx < NUM_SHIPS) {
+					uint8_t nextLen = SHIP_LENGTHS[game.ghostShipIdx];
 
 					/* Keep the cursor inside the grid */
-					if (ghostHorizontal && selCol > GRID_COLS - nextLen)  selCol = GRID_COLS - nextLen;
-					if (!ghostHorizontal && selRow > GRID_ROWS - nextLen) selRow = GRID_ROWS - nextLen;
+					if (game.ghostHorizontal && game.selCol > GRID_COLS - nextLen)  game.selCol = GRID_COLS - nextLen;
+					if (!game.ghostHorizontal && game.selRow > GRID_ROWS - nextLen) game.selRow = GRID_ROWS - nextLen;
 
-					ghost_update(selRow, selCol, ghostHorizontal, true);   // Will show gray or red immediately
-				} else if (ghostShipIdx == NUM_SHIPS) {
+					ghost_update(game.selRow, game.selCol, game.ghostHorizontal);   // Will show green or red immediately
+				} else if (game.ghostShipIdx == NUM_SHIPS) {
 					// All ships placed; ready to connect
-					selfToken = (uint16_t)systemTime; // Use finishing time as token
+					game.selfToken = (uint16_t)game.systemTime; // Use finishing time as token
 					tx_ready();
-					nState = NS_WAIT_READY;
-					gState = GS_WAIT;
-					resendTick = 0;
-					peerToken = 0;
-					postReadyLeft = 0;
+					game.nState = NS_WAIT_READY;
+					game.gState = GS_WAIT;
+					game.resendTick = 0;
+					game.peerToken = 0;
+					game.postReadyLeft = 0;
 					status_msg("Searching peer...");
 				}
 			} else {
 				// Immediately update ghost for next ship to prevent stale display
-				ghost_update(selRow, selCol, ghostHorizontal, true);
+				ghost_update(game.selRow, game.selCol, game.ghostHorizontal);
 				// Invalid placement (overlapping/invalid)
 				status_msg("Invalid placement!");
-				showInvalid = true;
-				invalidTimer = systemTime;
+				game.showInvalid = true;
+				game.invalidTimer = game.systemTime;
 			}
 		}
 	}
-	if (!pressed) buttonLatch = false;
+	if (!pressed) game.buttonLatch = false;
 }
 
 /* -------------------------------------------------------------------------
@@ -606,37 +901,37 @@ static void handle_placing(void) {
  * Handles deciding who goes first after both players place ships.
  */
 static void handle_wait_peer(void) {
-	if (nState == NS_DECIDE && peerToken) {
+	if (game.nState == NS_DECIDE && game.peerToken) {
 		/* Decide turn order based on token */
-		bool iStart = (selfToken > peerToken);
+		bool iStart = (game.selfToken > game.peerToken);
 
 		/* Calculate total enemy ship cells */
 		{
 			uint8_t total_cells = 0;
 			for (uint8_t i = 0; i < NUM_SHIPS; ++i)
 				total_cells += SHIP_LENGTHS[i];
-			enemyRemaining = total_cells;
+			game.enemyRemaining = total_cells;
 		}
 
 		/* First turn assignment */
 		if (iStart) {
-			nState = NS_MY_TURN;
-			gState = GS_MYTURN;
+			game.nState = NS_MY_TURN;
+			game.gState = GS_MYTURN;
 		} else {
-			nState = NS_PEER_TURN;
-			gState = GS_ENEMYTURN;
+			game.nState = NS_PEER_TURN;
+			game.gState = GS_ENEMYTURN;
 		}
 
-		selRow = GRID_ROWS / 2;
-		selCol = GRID_COLS / 2;
+		game.selRow = GRID_ROWS / 2;
+		game.selCol = GRID_COLS / 2;
 
 		/* Prepare to flood READY for a short time still */
-		postReadyLeft	= 2000;
-		resendTick		= 0;
-		nextMoveAllowed = systemTime;
+		game.postReadyLeft	= READY_LINGER_MS;
+		game.resendTick		= 0;
+		game.nextMoveAllowed = game.systemTime;
 
 		gui_draw_play_screen();
-		draw_cursor(selRow, selCol, ENEMY_GRID_X_PX);
+		draw_cursor(game.selRow, game.selCol, ENEMY_GRID_X_PX);
 		status_msg(iStart ? "Your turn" : "Enemy turn");
 	}
 }
@@ -645,57 +940,111 @@ static void handle_wait_peer(void) {
  *  PLAYER'S TURN: FIRING
  * ------------------------------------------------------------------------- */
 /**
- * Handles joystick navigation and firing at enemy grid.
+ * Draw the pending shot cell highlighted or plain (blink phase).
+ */
+static void draw_pending_cell(bool on) {
+	game.pendingLit = on;
+	draw_cell(game.pendingRow, game.pendingCol,
+			  cell_colour(game.pendingRow, game.pendingCol, ENEMY_GRID_X_PX), ENEMY_GRID_X_PX);
+
+	// draw_cell() dropped the cursor if it sits on the pending cell; put it back
+	if (game.selRow == game.pendingRow && game.selCol == game.pendingCol)
+		draw_cursor(game.selRow, game.selCol, ENEMY_GRID_X_PX);
+}
+
+/**
+ * Scan the radar area around the cursor instead of firing.
+ */
+static void start_scan(void) {
+	// A held result can't ride on a scan: send it alone first
+	if (game.holdLeft) {
+		tx_result(game.carryRow, game.carryCol, game.carryHit);
+		game.carrying = false;
+		game.holdLeft = 0;
+	}
+
+	game.radarLeft--;
+	game.pendingScan = true;
+	game.pendingRow = game.selRow;
+	game.pendingCol = game.selCol;
+	tx_scan(RADAR_USES - 1 - game.radarLeft, game.selRow, game.selCol);
+	game.resendTick = 0;
+	game.resendWait = ATTACK_RESEND_MS;
+
+	game.nState = NS_WAIT_RES;
+	game.gState = GS_WAITRES;
+	status_msg("Radar scanning...");
+}
+
+/**
+ * Handles joystick navigation and firing at enemy grid (holding the button
+ * scans with radar instead, while scans are left).
  */
 static void handle_my_turn(void) {
 	/* --- Cursor navigation --- */
 	uint16_t joyX = adc_read(0);
 	uint16_t joyY = adc_read(1);
 	bool moved = false;
-	uint8_t oldR = selRow, oldC = selCol;
 
-	if (systemTime >= nextMoveAllowed) {
-		if		(joyY < JOY_MIN_RAW && selRow > 0)				{ --selRow; moved = true; }
-		else if (joyY > JOY_MAX_RAW && selRow < GRID_ROWS-1)	{ ++selRow; moved = true; }
-		else if (joyX < JOY_MIN_RAW && selCol > 0)				{ --selCol; moved = true; }
-		else if (joyX > JOY_MAX_RAW && selCol < GRID_COLS-1)	{ ++selCol; moved = true; }
+	if (game.systemTime >= game.nextMoveAllowed) {
+		if		(joyY < JOY_MIN_RAW && game.selRow > 0)				{ --game.selRow; moved = true; }
+		else if (joyY > JOY_MAX_RAW && game.selRow < GRID_ROWS-1)	{ ++game.selRow; moved = true; }
+		else if (joyX < JOY_MIN_RAW && game.selCol > 0)				{ --game.selCol; moved = true; }
+		else if (joyX > JOY_MAX_RAW && game.selCol < GRID_COLS-1)	{ ++game.selCol; moved = true; }
 
 		if (moved) {
-			// Redraw previous cell background
-			bool oldAtt = BITMAP_GET(enemyAttackedAtBitmap, oldR, oldC);
-			bool oldOcc = BITMAP_GET(enemyConfirmedHitBitmap, oldR, oldC);
-			uint16_t bg = oldAtt ? (oldOcc ? CLR_HIT : CLR_MISS) : CLR_NAVY;
-			draw_cell(oldR, oldC, bg, ENEMY_GRID_X_PX);
-
-			// Draw new cursor
-			draw_cursor(selRow, selCol, ENEMY_GRID_X_PX);
+			// Restore the pixels under the old cursor frame and draw the new one
+			draw_cursor(game.selRow, game.selCol, ENEMY_GRID_X_PX);
+			LAT_DONE(LAT_CURSOR);
 
-			nextMoveAllowed = systemTime + JOY_REPEAT_DELAY_MS;
+			game.nextMoveAllowed = game.systemTime + JOY_REPEAT_DELAY_MS;
 		}
 	}
 
-	/* --- Fire weapon --- */
+	/* --- Fire weapon, or scan on a long hold --- */
 	bool pressed = button_is_pressed();
-	if (pressed && !buttonLatch) {
-		buttonLatch = true;
+	if (pressed && !game.buttonLatch) {
+		game.buttonLatch = true;
+
+		// Only wait to tell a hold from a press while a scan is possible
+		if (game.radarLeft && game.peerRadar) {
+			uint32_t holdStart = game.systemTime;
+			while (button_is_pressed() && (game.systemTime - holdStart) < RADAR_HOLD_MS) {
+				_delay_ms(1);
+				game.systemTime++;
+				net_tick(); // Keep network responsive while holding
+				buzzer_tick();
+			}
+			if (game.systemTime - holdStart >= RADAR_HOLD_MS) {
+				start_scan();
+				return;
+			}
+		}
 
-		if (!BITMAP_GET(enemyAttackedAtBitmap, selRow, selCol)) {
+		if (!BITMAP_GET(game.enemyAttackedAtBitmap, game.selRow, game.selCol)) {
 			// Fire at unshot square
-			BITMAP_SET(enemyAttackedAtBitmap, selRow, selCol);
-
-			draw_cell(selRow, selCol, CLR_PENDING, ENEMY_GRID_X_PX); // Pending color
-			pendingRow = selRow;
-			pendingCol = selCol;
-
-			tx_attack(selRow, selCol);
-			resendTick = 0;
-
-			nState = NS_WAIT_RES;
-			gState = GS_WAITRES;
+			BITMAP_SET(game.enemyAttackedAtBitmap, game.selRow, game.selCol);
+
+			game.pendingRow = game.selRow;
+			game.pendingCol = game.selCol;
+			draw_pending_cell(true);
+			game.pendingBlink = anim_blink(draw_pending_cell, CELL_SIZE_PX * CELL_SIZE_PX, PENDING_BLINK_MS, ANIM_FOREVER);
+
+			tx_attack(game.selRow, game.selCol);		// Carries a held result, if any
+			game.holdLeft = 0;
+#ifdef NET_STATS
+			attackSentAt = game.systemTime;
+#endif
+			game.resendTick = 0;
+			game.resendWait = ATTACK_RESEND_MS;
+
+			game.nState = NS_WAIT_RES;
+			game.gState = GS_WAITRES;
 			status_msg("Waiting for result...");
+			LAT_DONE(LAT_FIRE);
 		}
 	}
-	if (!pressed) buttonLatch = false;
+	if (!pressed) game.buttonLatch = false;
 }
 
 /* -------------------------------------------------------------------------
@@ -706,15 +1055,18 @@ static void handle_my_turn(void) {
  */
 static void handle_over(void) {
 	bool pressed = button_is_pressed();
-	if (pressed && !overButtonLatch) {
-		overButtonLatch = true;
-		if (++overTapCount >= 2) {
-			overTapCount = 0;
+	if (pressed && !game.overButtonLatch) {
+		game.overButtonLatch = true;
+		anim_finish_all();			// Show the end screen in full
+		game.pendingBlink = ANIM_NONE;
+
+		if (++game.overTapCount >= 2) {
+			game.overTapCount = 0;
 			handle_reset();
 		}
 	}
 	if (!pressed)
-		overButtonLatch = false;
+		game.overButtonLatch = false;
 }
 
 /* -------------------------------------------------------------------------
@@ -727,22 +1079,64 @@ static void handle_over(void) {
  * ------------------------------------------------------------------------- */
 void net_inject_line(const char *line)
 {
-	/* parse_line expects a writable buffer – make a local copy */
-	char tmp[RX_MAX];
-	strncpy(tmp, line, RX_MAX - 1);
-	tmp[RX_MAX - 1] = '\0';
-	parse_line(tmp);
+	/* parse_line only reads the line, so the queue slot is parsed in place */
+	parse_line(line);
 }
 
 /* -------------------------------------------------------------------------
- *  MAIN FUNCTION
+ *  BOOT SEQUENCE
  * ------------------------------------------------------------------------- */
+// Boot clock: Timer1 free-running at F_CPU/1024. Timer1 belongs to the buzzer,
+// which stays silent until boot is done.
+#define BOOT_CLOCK_US	64						// Microseconds per Timer1 count
+
+static uint32_t bootTicks  = 0;					// Timer1 counts before the last overflow
+static uint16_t bootTimeMs = 0;					// Reset to interactive menu, in ms
+
 /**
- * Program entry point.
- * Sets up peripherals, screen, and enters main game loop.
+ * Start the boot clock from zero.
  */
-int main(void) {
-	/* --- Initialize TFT / SPI (Display setup) --- */
+static void boot_clock_start(void) {
+	TCCR1A = 0;
+	TCNT1  = 0;
+	TIFR1  = 1 << TOV1;							// Clear a stale overflow
+	TCCR1B = (1 << CS12) | (1 << CS10);			// Normal mode, clk/1024
+}
+
+/**
+ * Milliseconds since boot_clock_start(). Must be polled at least every 4 s
+ * so no Timer1 overflow is missed.
+ */
+static uint32_t boot_clock_ms(void) {
+	uint16_t now = TCNT1;
+	if (TIFR1 & (1 << TOV1)) {
+		TIFR1 = 1 << TOV1;
+		bootTicks += 65536UL;
+		now = TCNT1;
+	}
+	return (bootTicks + now) * BOOT_CLOCK_US / 1000;
+}
+
+/**
+ * Busy-wait until the boot clock reaches `ms`.
+ */
+static void boot_wait_until(uint32_t ms) {
+	while (boot_clock_ms() < ms)
+		;
+}
+
+/**
+ * Bring the system up to an interactive main menu.
+ *
+ * The display's reset and Sleep Out waits are deadlines on the boot clock
+ * rather than fixed delays. Independent setup runs while they elapse, and the
+ * main menu is drawn into GRAM while the panel is still asleep (GRAM writes
+ * work in Sleep In), so the panel turns on with the finished menu.
+ */
+static void boot(void) {
+	boot_clock_start();
+
+	/* --- Start the display reset --- */
 	ILI9341_CS_DDR  |= 1 << ILI9341_CS_PIN;
 	ILI9341_DC_DDR  |= 1 << ILI9341_DC_PIN;
 	ILI9341_RST_DDR |= 1 << ILI9341_RST_PIN;
@@ -750,69 +1144,117 @@ int main(void) {
 	RST_HIGH();
 
 	spi_init();
-	ili9341_init();
+	ili9341_reset();
+	uint32_t resetAt = boot_clock_ms();
 
-	uint8_t madctl = 0x28;
-	ili9341_send_command_bytes(0x36, &madctl, 1);
-
-	/* --- Initialize Peripherals --- */
+	/* --- Initialize Peripherals (overlaps the reset wait) --- */
 	adc_init();
 	button_init();
 	uart_init();
 	stdout = &uart_stdout;					// Redirect printf to UART
 
-	initEepromImage();
+	initEepromImage();						// Skips programming when the stamp matches
 
 	srand16(adc_read(3) * adc_read(4));		// Initialize the RNG for `singleplayer.c` (with unused ADC inputs)
 
-	gState = GS_RESET;						// The initial game state is GS_RESET
-
-	/* ---------------------------------------------------------------------
-	 * Main game loop (runs forever)
-	 * --------------------------------------------------------------------- */
-	while (1) {
-		net_tick(); // Process network events (incoming messages, retries)
-
-		/* --- Handle game state --- */
-		switch (gState) {
-			case GS_RESET:
-				handle_reset();				// Reset full protocol and board state; draw the main menu screen; update gState (to GS_MAINMENU) and default gMode (to GM_MULTIPLAYER)
-				break;
-			case GS_MAINMENU:
-				handle_main_menu();			// Allow the user to select between gModes GM_MULTIPLAYER and GM_SINGLEPLAYER; goes to GS_NEWGAME or GS_SETTINGS
-				break;
-			case GS_SETTINGS:
-				handle_settings();
-				break;
-			case GS_NEWGAME:
-				handle_new_game();			// Draw initial game screen; goes to GS_PLACING
-				break;
-			case GS_PLACING:
-				handle_placing();
-				break;
-			case GS_WAIT:
-				handle_wait_peer();
-				break;
-			case GS_MYTURN:
-				handle_my_turn();
-				break;
-			case GS_WAITRES:
-				/* Passive – waiting for attack result */
-				break;
-			case GS_ENEMYTURN:
-				/* Passive – waiting for peer's move */
-				break;
-			case GS_OVER:
-				handle_over();
-				break;
-		}
+	/* --- Configure the controller and draw the menu (overlaps the Sleep Out wait) --- */
+	boot_wait_until(resetAt + ILI9341_RESET_WAIT_MS);
+	ili9341_configure();
+	handle_reset();							// Draws the main menu; gState = GS_MAINMENU
 
-		/* Flush one queued spoofed packet (single-player only) */
-		if (gMode == GM_SINGLEPLAYER) {
-			 sp_tick();
-		}
+	/* --- Wake the panel and show the menu --- */
+	boot_wait_until(resetAt + ILI9341_SLEEP_OUT_WAIT_MS);
+	ili9341_sleep_out();
+	boot_wait_until(boot_clock_ms() + ILI9341_CMD_WAIT_MS);
+	ili9341_display_on();
+
+	bootTimeMs = boot_clock_ms();
+	TCCR1B = 0;								// Stop the boot clock; Timer1 goes back to the buzzer
+
+#ifdef BOOT_REPORT
+	printf("BOOT %u\n", bootTimeMs);		// Peers ignore lines they don't know
+#endif
+}
+
+/* -------------------------------------------------------------------------
+ *  MAIN FUNCTION
+ * ------------------------------------------------------------------------- */
+// game_start() and game_tick() are the whole firmware loop; a host runtime with
+// its own <util/delay.h> can drive them in virtual time instead of calling main().
 
-		_delay_ms(1);   // Tick every 1 ms
-		systemTime++;   // Advance system time counter
+/**
+ * Boot to the main menu and start the millisecond ticker.
+ */
+void game_start(void) {
+	boot();
+	game.systemTime = bootTimeMs;				// The millisecond ticker counts from reset
+#ifdef LATENCY_REPORT
+	lat_init();
+#endif
+}
+
+/**
+ * Run one 1 ms pass of the main game loop.
+ */
+void game_tick(void) {
+#ifdef LATENCY_REPORT
+	lat_poll();		// Stamp input changes before the handlers act on them
+#endif
+	net_tick(); // Process network events (incoming messages, retries)
+
+	/* --- Handle game state --- */
+	switch (game.gState) {
+		case GS_RESET:
+			handle_reset();				// Reset full protocol and board state; draw the main menu screen; update gState (to GS_MAINMENU) and default gMode (to GM_MULTIPLAYER)
+			break;
+		case GS_MAINMENU:
+			handle_main_menu();			// Allow the user to select between gModes GM_MULTIPLAYER and GM_SINGLEPLAYER; goes to GS_NEWGAME or GS_SETTINGS
+			break;
+		case GS_SETTINGS:
+			handle_settings();
+			break;
+		case GS_NEWGAME:
+			handle_new_game();			// Draw initial game screen; goes to GS_PLACING
+			break;
+		case GS_PLACING:
+			handle_placing();
+			break;
+		case GS_WAIT:
+			handle_wait_peer();
+			break;
+		case GS_MYTURN:
+			handle_my_turn();
+			break;
+		case GS_WAITRES:
+			/* Passive – waiting for attack result */
+			break;
+		case GS_ENEMYTURN:
+			/* Passive – waiting for peer's move */
+			break;
+		case GS_OVER:
+			handle_over();
+			break;
 	}
+
+	/* Flush one queued spoofed packet (single-player only) */
+	if (game.gMode == GM_SINGLEPLAYER) {
+		 sp_tick();
+	}
+
+	anim_tick();	// Step running animations
+	buzzer_tick();	// Step the non-blocking sound
+	gfx_capture_tick();	// Send draw-call capture while the UART is idle (GFX_CAPTURE builds)
+
+	_delay_ms(1);   // Tick every 1 ms
+	game.systemTime++;   // Advance system time counter
+}
+
+/**
+ * Program entry point.
+ * Boots to the main menu and runs the main game loop forever.
+ */
+int main(void) {
+	game_start();
+	while (1)
+		game_tick();
 }
@@ -5,6 +5,9 @@
  * Copyright (c) 2025 Peter Kamp and Brendan Brooks
  * --------------------------------------------------------------------------- */
 #include "singleplayer.h"
+#include "arena.h"
+#include "eeprom.h"
+#include <avr/pgmspace.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -14,15 +17,25 @@ extern void net_inject_line(const char *line);
 /* Simple circular queue of pending lines to inject on the next tick  */
 /* ------------------------------------------------------------------ */
 #define QCAP 4
-static char  qbuf[QCAP][32];
+static char  (*qbuf)[32];      /* Borrowed from the arena for the game phase */
 static uint8_t qhead = 0, qtail = 0;
+static bool aiSetUp;			/* AI fleet and per-game state ready (READY is resent for a while) */
+
+_Static_assert(sizeof(char[QCAP][32]) <= ARENA_SP_QUEUE_BYTES, "Single-player queue exceeds its arena budget");
 
 static inline bool q_full (void) { return (uint8_t)(qhead + 1) % QCAP == qtail; }
 static inline bool q_empty(void) { return qhead == qtail; }
 
+static void habit_tick(void);
+
+typedef struct Endgame Endgame;
+static Endgame *eg;				/* Endgame search in progress (arena scratch), or NULL */
+static bool eg_step(int* row_to_attack, int* col_to_attack, uint16_t* chance);
+static void ai_push_endgame_move(int row, int col, uint16_t chance);
+
 static void q_push(const char *s)
 {
-	if (q_full()) return;          /* Drop if ever overrun  harmless here */
+	if (!qbuf || q_full()) return; /* Drop if ever overrun  harmless here */
 	strncpy(qbuf[qhead], s, 31);
 	qbuf[qhead][31] = '\0';
 	qhead = (uint8_t)(qhead + 1) % QCAP;
@@ -32,11 +45,21 @@ static void q_push(const char *s)
 
 void sp_reset(void)
 {
+	/* Call after arena_enter(ARENA_GAME); the queue lives until the game ends */
+	qbuf = arena_alloc(sizeof(char[QCAP][32]));
 	qhead = qtail = 0;
+	aiSetUp = false;
+	eg = NULL;		/* Its scratch went with the old phase */
 }
 
 void sp_tick(void)
 {
+	habit_tick();
+
+	int row, col;
+	uint16_t chance;
+	if (eg && eg_step(&row, &col, &chance)) ai_push_endgame_move(row, col, chance);
+
 	if (q_empty()) return;
 	net_inject_line(qbuf[qtail]);
 	qtail = (uint8_t)(qtail + 1) % QCAP;
@@ -44,56 +67,119 @@ void sp_tick(void)
 
 /* AI board helpers ------------------------------------------------------- */
 
+#define AI_PLACE_MAX (GRID_ROWS * GRID_COLS * 2)   /* Both orientations at every cell */
+
+_Static_assert(AI_PLACE_MAX < 256, "AI placement codes and counts no longer fit in a byte");
+
+/* Fleets sampled per game by difficulty; the one a hunter is least likely	*/
+/* to find is kept. Each sample is ~16k cycles (~1 ms), so Hard's 16		*/
+/* add ~16 ms to the READY handshake. Easy keeps a uniform fleet.			*/
+/* Both values are tuned with host/placetune, which builds them writable	*/
+/* (AI_PLACE_TUNE) and plays two hunters against the fleets they give. A	*/
+/* touch score from ~700 up ranks any fleet with fewer shared edges first	*/
+/* and only then looks at density, which both hunters found hardest. More	*/
+/* samples than 16 drift back towards the edge-hugging fleets hunt/target	*/
+/* players find fastest. A fleet has at most 34 shared edges, so the score	*/
+/* stays within 16 bits.													*/
+#ifdef AI_PLACE_TUNE
+#define AI_PLACE_PARAM				/* Set by host/placetune between fleets */
+#else
+#define AI_PLACE_PARAM	static const
+#endif
+
+AI_PLACE_PARAM uint8_t	AI_PLACE_SAMPLES[] = { 1, 8, 16 };	/* AI_EASY, AI_MEDIUM, AI_HARD */
+AI_PLACE_PARAM uint16_t	AI_PLACE_TOUCH = 1000;	/* Score per cell edge two ships share: one target run finds both */
+
+_Static_assert(sizeof(AI_PLACE_SAMPLES) == AI_HARD + 1, "One sample count per difficulty");
+
+static uint8_t ai_prior(int8_t row, int8_t col);
+
+static uint8_t popcount16(uint16_t b) {
+	uint8_t n = 0;
+	for (; b; b &= b - 1) n++;
+	return n;
+}
+
 /* ------------------------------------------------------------------ */
-/* Fill the AI board with ships using RNG							  */
+/* Place a uniformly random fleet into `rows` (row words) and score	  */
+/* it: the prior density of its cells plus AI_PLACE_TOUCH per edge	  */
+/* shared between ships. Lower is harder to find.					  */
 /* ------------------------------------------------------------------ */
-void ai_place_random(void) {
-	
-	// Reseed the RNG for ship placement
-	srand16(adc_read(3) * adc_read(4));	
-	
-	// Start with an empty board
-	memset(aiOccupiedBitmap, 0, BITMAP_SIZE);
+static uint16_t ai_sample_fleet(uint16_t *rows) {
+	uint16_t score = 0;
+	memset(rows, 0, GRID_ROWS * sizeof(uint16_t));
 
 	for (uint8_t i = 0; i < NUM_SHIPS; ++i) {
 		uint8_t len = SHIP_LENGTHS[i];
 
-		// Generate all possible valid positions for this ship
-		typedef struct {
-			uint8_t row, col;
-			bool horizontal;
-		} ShipPos;
-
-		ShipPos positions[GRID_ROWS * GRID_COLS * 2];
-		uint16_t pos_count = 0;
+		// Count all possible valid positions for this ship
+		uint8_t pos_count = 0;
+		for (uint8_t row = 0; row < GRID_ROWS; ++row) {
+			pos_count += popcount16(ship_fit_row(rows, row, len, true));
+			pos_count += popcount16(ship_fit_row(rows, row, len, false));
+		}
+		if (pos_count == 0) return UINT16_MAX;	// Boxed in: never keep a fleet missing a ship
 
+		// Place the ship at a uniformly random valid position: walk to the pick-th one,
+		// coded (row * GRID_COLS + col) * 2 + vertical
+		uint8_t pick = rand16() % pos_count, chosen = 0;
 		for (uint8_t row = 0; row < GRID_ROWS; ++row) {
-			for (uint8_t col = 0; col < GRID_COLS; ++col) {
-				if (ship_can_fit(aiOccupiedBitmap, row, col, len, true)) {
-					positions[pos_count++] = (ShipPos){row, col, true};
-				}
-				if (ship_can_fit(aiOccupiedBitmap, row, col, len, false)) {
-					positions[pos_count++] = (ShipPos){row, col, false};
-				}
+			uint16_t fitH = ship_fit_row(rows, row, len, true);
+			uint16_t fitV = ship_fit_row(rows, row, len, false);
+			uint8_t here = popcount16(fitH) + popcount16(fitV);
+			if (pick >= here) {
+				pick -= here;
+				continue;
+			}
+			for (uint8_t col = 0; ; ++col, fitH >>= 1, fitV >>= 1) {
+				uint8_t cell = row * GRID_COLS + col;
+				if ((fitH & 1) && pick-- == 0) { chosen = cell * 2;	   break; }
+				if ((fitV & 1) && pick-- == 0) { chosen = cell * 2 + 1; break; }
 			}
+			break;
 		}
+		uint8_t row = (chosen / 2) / GRID_COLS, col = (chosen / 2) % GRID_COLS;
+		bool horizontal = !(chosen & 1);
+		uint16_t span = horizontal ? ((1u << len) - 1) << col : 1u << col;
+		for (uint8_t r = row; r < row + (horizontal ? 1 : len); ++r) {
+			// Edges shared with ships already placed (this one is not in `rows` yet)
+			uint8_t touch = popcount16(rows[r] & ((span << 1) | (span >> 1)));
+			if (r > 0)			   touch += popcount16(rows[r - 1] & span);
+			if (r < GRID_ROWS - 1) touch += popcount16(rows[r + 1] & span);
+			score += touch * AI_PLACE_TOUCH;
+		}
+		for (uint8_t k = 0; k < len; ++k) {
+			score += ai_prior(row + (horizontal ? 0 : k), col + (horizontal ? k : 0));
+		}
+		for (uint8_t r = row; r < row + (horizontal ? 1 : len); ++r) rows[r] |= span;
+	}
+	return score;
+}
+
+/* ------------------------------------------------------------------ */
+/* Fill the AI board with the best of AI_PLACE_SAMPLES random fleets  */
+/* ------------------------------------------------------------------ */
+void ai_place_random(void) {
+	
+	// Reseed the RNG for ship placement
+	srand16(adc_read(3) * adc_read(4));	
+	
+	// Start with an empty board
+	memset(aiOccupiedBitmap, 0, BITMAP_SIZE);
 
-		// Shuffle the valid positions
-		for (uint16_t j = 0; j < pos_count - 1; ++j) {
-			uint16_t k = j + (rand16() % (pos_count - j));
-			ShipPos tmp = positions[j];
-			positions[j] = positions[k];
-			positions[k] = tmp;
+	// Keep sampling past the quota until some fleet is complete
+	uint16_t rows[GRID_ROWS], best[GRID_ROWS] = { 0 }, bestScore = UINT16_MAX;
+	for (uint8_t k = 0; k < AI_PLACE_SAMPLES[aiDifficulty] || bestScore == UINT16_MAX; ++k) {
+		uint16_t score = ai_sample_fleet(rows);
+		if (score < bestScore) {
+			bestScore = score;
+			memcpy(best, rows, sizeof(best));
 		}
+	}
 
-		// Place the ship at the first valid position
-		if (pos_count > 0) {
-			ShipPos chosen = positions[0];
-			for (uint8_t k = 0; k < len; ++k) {
-				uint8_t r = chosen.row + (chosen.horizontal ? 0 : k);
-				uint8_t c = chosen.col + (chosen.horizontal ? k : 0);
-				BITMAP_SET(aiOccupiedBitmap, r, c);
-			}
+	for (uint8_t r = 0; r < GRID_ROWS; ++r) {
+		for (uint8_t c = 0; c < GRID_COLS; ++c) {
+			if (best[r] & (1u << c)) BITMAP_SET(aiOccupiedBitmap, r, c);
 		}
 	}
 }
@@ -104,19 +190,19 @@ void ai_place_random(void) {
 void find_random_ship_square(int* row_to_attack, int* col_to_attack) {
 	
 	// Edge case: no remaining player ship squares to attack
-	if (playerRemaining == 0) {
+	if (game.playerRemaining == 0) {
 		return;
 	}
 	
 	// Randomly select a player ship square to hit (indexed 0 to n-1)
-	int hit_index = rand_int(0, playerRemaining-1);
+	int hit_index = rand_int(0, game.playerRemaining-1);
 		
 	// Iterate through all player squares until the unattacked player ship square corresponding to `hit_index` (0 to n-1) is found
 	int i=0;
 	for (int8_t y=0; y<GRID_ROWS; ++y) {
 		for (int8_t x=0; x<GRID_COLS; ++x) {
 				
-			if (BITMAP_GET(playerOccupiedBitmap, y, x) && !BITMAP_GET(playerAttackedAtBitmap, y, x)) {		// *Unattacked* player ship squares
+			if (BITMAP_GET(game.playerOccupiedBitmap, y, x) && !BITMAP_GET(game.playerAttackedAtBitmap, y, x)) {		// *Unattacked* player ship squares
 					
 				if (i == hit_index) {
 					*row_to_attack = y;
@@ -137,7 +223,7 @@ void find_random_ship_square(int* row_to_attack, int* col_to_attack) {
 void find_random_ocean_square(int* row_to_attack, int* col_to_attack) {
 	
 	// Compute the number of remaining ocean squares
-	player_ocean_squares_left = GRID_CELLS - (player_ship_squares_attacked + playerRemaining + player_ocean_squares_attacked);
+	player_ocean_squares_left = GRID_CELLS - (player_ship_squares_attacked + game.playerRemaining + player_ocean_squares_attacked);
 	
 	// Edge case: no remaining player ocean squares to attack; must attack a ship
 	if (player_ocean_squares_left == 0) {
@@ -153,7 +239,7 @@ void find_random_ocean_square(int* row_to_attack, int* col_to_attack) {
 	for (int8_t y=0; y<GRID_ROWS; ++y) {
 		for (int8_t x=0; x<GRID_COLS; ++x) {
 			
-			if (!BITMAP_GET(playerOccupiedBitmap, y, x) && !BITMAP_GET(playerAttackedAtBitmap, y, x)) {		// *Unattacked* player ocean squares
+			if (!BITMAP_GET(game.playerOccupiedBitmap, y, x) && !BITMAP_GET(game.playerAttackedAtBitmap, y, x)) {		// *Unattacked* player ocean squares
 				
 				if (i == hit_index) {
 					*row_to_attack = y;
@@ -168,11 +254,484 @@ void find_random_ocean_square(int* row_to_attack, int* col_to_attack) {
 	
 }
 
+/* AI radar --------------------------------------------------------------- */
+/* The Hard AI spends its scans on its first honest guesses, which are the	*/
+/* least informed; on a host this costs it ~0.05 turns per scan. A scan		*/
+/* that finds nothing clears its area like a ring of misses; other counts	*/
+/* must be matched exactly by every fleet the endgame solver keeps.			*/
+
+static RadarScan aiScans[RADAR_USES];		/* The AI's scans of the player's board, in order */
+static uint8_t aiRadarLeft;
+
+/* Did an AI scan find (row, col) empty? */
+static bool ai_known_empty(uint8_t row, uint8_t col) {
+	for (uint8_t i = 0; i < RADAR_USES; ++i) {
+		if (aiScans[i].count == 0 && radar_covers(&aiScans[i], row, col)) return true;
+	}
+	return false;
+}
+
+/* Clamp v to lo..hi */
+static int ai_clamp(int v, int lo, int hi) {
+	return v < lo ? lo : (v > hi ? hi : v);
+}
+
+/* Opening prior ---------------------------------------------------------- */
+/* How often each cell holds a ship when the whole fleet is placed like	*/
+/* one ai_sample_fleet() draw, scaled so the busiest cell is 255. Centre	*/
+/* cells hold a ship three times as often as corners. The board is			*/
+/* symmetric, so only the top-left quadrant is kept. Generated by			*/
+/* host/prior (2M boards, seed 1); `make -C host test` checks the table.	*/
+/* Without sink reports the AI never learns which ships are left, so one	*/
+/* table for the full fleet is all it can use; the only update is that		*/
+/* cells already shot drop out of the draw.									*/
+
+#define PRIOR_HALF	(GRID_ROWS / 2)
+
+static const uint8_t AI_PRIOR[PRIOR_HALF][PRIOR_HALF] PROGMEM = {
+	{  85, 125, 157, 173, 181 },
+	{ 125, 162, 191, 205, 212 },
+	{ 157, 191, 217, 230, 237 },
+	{ 173, 205, 230, 242, 249 },
+	{ 181, 212, 237, 249, 255 },
+};
+
+_Static_assert(GRID_ROWS == GRID_COLS && GRID_ROWS % 2 == 0, "The prior quadrant assumes an even square grid");
+
+static uint8_t ai_prior(int8_t row, int8_t col)
+{
+	if (row >= PRIOR_HALF) row = GRID_ROWS - 1 - row;
+	if (col >= PRIOR_HALF) col = GRID_COLS - 1 - col;
+	return pgm_read_byte(&AI_PRIOR[row][col]);
+}
+
+/* Opponent habits -------------------------------------------------------- */
+/* Players reuse their placements, so the AI remembers how crowded each		*/
+/* region of their board has been: a 3x3 grid of bands (rows and columns	*/
+/* 0-2, 3-6, 7-9), one EEPROM byte per region. Each byte is the share of	*/
+/* the region's cells under a ship (255 = all), averaged over past games	*/
+/* with the latest weighted 1/4. Erased EEPROM reads 255 everywhere, which	*/
+/* biases nothing. The bytes are read at the game's first READY, so a game	*/
+/* only uses earlier games. Once it ends, its update goes back one byte per	*/
+/* tick whenever no EEPROM write is in progress, so the loop never waits.	*/
+
+#define HABIT_BANDS		3
+#define HABIT_EDGE		3		/* Rows (and columns) in each outer band */
+#define HABIT_REGIONS	(HABIT_BANDS * HABIT_BANDS)
+#define HABIT_FLOOR		4		/* Keeps every unshot cell drawable (habits never decay below 3) */
+
+_Static_assert(HABIT_REGIONS == EEPROM_HABIT_BYTES, "One EEPROM byte per habit region");
+_Static_assert(GRID_CELLS * ((255UL * (255 + HABIT_FLOOR)) >> 8) <= UINT16_MAX, "Target weights no longer sum in 16 bits");
+
+static uint8_t habit[HABIT_REGIONS];				/* As read at the first READY */
+static uint8_t habitWrite = HABIT_REGIONS;		/* Next region to write back (HABIT_REGIONS = none) */
+
+static uint8_t habit_band(uint8_t i) {
+	return i < HABIT_EDGE ? 0 : i < GRID_ROWS - HABIT_EDGE ? 1 : 2;
+}
+
+static uint8_t habit_band_size(uint8_t band) {
+	return band == 1 ? GRID_ROWS - 2 * HABIT_EDGE : HABIT_EDGE;
+}
+
+static uint8_t habit_region(uint8_t row, uint8_t col) {
+	return habit_band(row) * HABIT_BANDS + habit_band(col);
+}
+
+/* Region `i` with this game's fleet averaged in */
+static uint8_t habit_blend(uint8_t i) {
+	uint8_t shipCells = 0;
+	for (uint8_t s = 0; s < NUM_SHIPS; ++s) {
+		const Ship *ship = &game.playerFleet[s];
+		for (uint8_t k = 0; k < ship->length; ++k) {
+			uint8_t r = ship->row + (ship->horizontal ? 0 : k);
+			uint8_t c = ship->col + (ship->horizontal ? k : 0);
+			if (habit_region(r, c) == i) shipCells++;
+		}
+	}
+	uint8_t cells = habit_band_size(i / HABIT_BANDS) * habit_band_size(i % HABIT_BANDS);
+	uint8_t now = (uint16_t)shipCells * 255 / cells;
+	return habit[i] - habit[i] / 4 + now / 4;
+}
+
+static void habit_load(void) {
+	for (uint8_t i = 0; i < HABIT_REGIONS; ++i) {
+		habit[i] = eeprom_read_byte((const uint8_t*)(EEPROM_HABIT_ADDR + i));
+	}
+	habitWrite = HABIT_REGIONS;		/* Nothing to write back until the game ends */
+}
+
+static void habit_tick(void) {
+	if (habitWrite >= HABIT_REGIONS || !eeprom_is_ready()) return;
+	eeprom_update_byte((uint8_t*)(EEPROM_HABIT_ADDR + habitWrite), habit_blend(habitWrite));
+	habitWrite++;
+}
+
+/* Shot weight of a cell: the prior, scaled by the player's habits (0 once radar cleared it) */
+static uint16_t ai_target_weight(int8_t row, int8_t col) {
+	if (ai_known_empty(row, col)) return 0;
+	return ((uint16_t)ai_prior(row, col) * (habit[habit_region(row, col)] + HABIT_FLOOR)) >> 8;
+}
+
+/* -----------------------------------------------------------------------------*/
+/* Get the coordinates of an unattacked square drawn with ai_target_weight	*/
+/* (The AI does not peek here, so the shot may hit or miss; the caller		*/
+/* counts it)																*/
+/* ---------------------------------------------------------------------------- */
+static void find_prior_square(int* row_to_attack, int* col_to_attack) {
+
+	uint16_t total = 0;
+	for (int8_t y=0; y<GRID_ROWS; ++y)
+		for (int8_t x=0; x<GRID_COLS; ++x)
+			if (!BITMAP_GET(game.playerAttackedAtBitmap, y, x)) total += ai_target_weight(y, x);
+	if (total == 0) return;
+
+	uint16_t pick = rand16() % total;
+	for (int8_t y=0; y<GRID_ROWS; ++y) {
+		for (int8_t x=0; x<GRID_COLS; ++x) {
+			if (BITMAP_GET(game.playerAttackedAtBitmap, y, x)) continue;
+			uint16_t w = ai_target_weight(y, x);
+			if (pick < w) {
+				*row_to_attack = y;
+				*col_to_attack = x;
+				return;
+			}
+			pick -= w;
+		}
+	}
+}
+
+/* AI shot trace (-DAI_TRACE) -------------------------------------------- */
+/* One line per game start and per AI shot, for scoring the AI's choices	*/
+/* against exact hit probabilities on a host. The UART is unused in			*/
+/* singleplayer, so nothing else reads these lines.							*/
+/*   AI NEW <difficulty>		a new game (0 = easy .. 2 = hard)			*/
+/*   AI <row> <col> H|M			a shot and what it found					*/
+/*   AI S <row> <col> <count>	a radar scan and the ship cells it found	*/
+/*   AI EG <est> <tests> <slices> <fleets>	an endgame search and its cost	*/
+/*   AI EG <est> <tests> <slices> -			one cut off at its budget		*/
+#ifdef AI_TRACE
+#define AI_TRACE_NEW()				printf("AI NEW %u\n", (unsigned)aiDifficulty)
+#define AI_TRACE_SHOT(r, c, hit)	printf("AI %u %u %c\n", (unsigned)(r), (unsigned)(c), (hit) ? 'H' : 'M')
+#define AI_TRACE_SCAN(r, c, n)		printf("AI S %u %u %u\n", (unsigned)(r), (unsigned)(c), (unsigned)(n))
+#define AI_TRACE_ENDGAME(est, tests, slices, fleets) \
+	printf("AI EG %lu %u %u %u\n", (unsigned long)(est), (unsigned)(tests), (unsigned)(slices), (unsigned)(fleets))
+#define AI_TRACE_ENDGAME_CUT(est, tests, slices) \
+	printf("AI EG %lu %u %u -\n", (unsigned long)(est), (unsigned)(tests), (unsigned)(slices))
+#else
+#define AI_TRACE_NEW()				((void)0)
+#define AI_TRACE_SHOT(r, c, hit)	((void)0)
+#define AI_TRACE_SCAN(r, c, n)		((void)0)
+#define AI_TRACE_ENDGAME(est, tests, slices, fleets)	((void)0)
+#define AI_TRACE_ENDGAME_CUT(est, tests, slices)		((void)0)
+#endif
+
+/* Endgame solver --------------------------------------------------------- */
+/* Late in a game few fleets fit the AI's hits and misses. The solver		*/
+/* enumerates every one of them depth-first and picks the unshot cell that	*/
+/* the most fleets cover, i.e. the exact best hit chance.					*/
+/* The fleet has only (total length - hits) cells nobody has hit yet; a		*/
+/* placement that needs more of them is pruned.								*/
+/* It only starts when eg_estimate(), a count of the paths it can take,	*/
+/* is within ENDGAME_ESTIMATE_MAX, and runs from sp_tick() in slices of		*/
+/* ENDGAME_SLICE_STEPS placement tests, so a move never holds the main		*/
+/* loop for long: the result goes out at once and the attack follows when	*/
+/* the search ends. A search still going after ENDGAME_STEP_BUDGET tests	*/
+/* is cut off and the AI moves as it would have without one.				*/
+/* The search is iterative (its path is in the state), so it can stop and	*/
+/* go on between ticks; the state lives in the AI arena scratch.			*/
+/* The estimate is an upper bound but a loose one (8 to 500 times the		*/
+/* tests in host runs), so the budget is what bounds the cost. In host	*/
+/* runs (host/aiscore, 300 Hard games) searches under this gate took up to	*/
+/* 27,610 tests (111 slices) and none was cut off; each one is checked		*/
+/* against the exact fleet count.											*/
+
+#define ENDGAME_ESTIMATE_MAX	250000UL	/* Largest estimate a search starts on */
+#define ENDGAME_STEP_BUDGET	30000	/* Placement tests before a search is cut off */
+#define ENDGAME_SLICE_STEPS	250		/* Placement tests per sp_tick */
+#define ENDGAME_ALLOW_MAX	6		/* Most unhit cells eg_estimate() counts paths for */
+#define ENDGAME_MIN_CHANCE	128		/* Best cell's hit chance (1/256) worth taking: Hard's own odds */
+
+struct Endgame {
+	uint16_t blocked[GRID_ROWS];	/* Misses plus the ships placed on the current path (row words) */
+	uint16_t hits[GRID_ROWS];
+	uint16_t fitH, fitV;			/* Fits of the current ship in the row it is testing */
+	uint8_t  code[NUM_SHIPS];		/* Placement each ship on the path holds or tests next (AI_PLACE_MAX codes) */
+	uint8_t  ship;					/* Ship being placed; NUM_SHIPS: a whole fleet */
+	uint8_t  lenLeft;				/* Cells of that ship and the ones after it */
+	uint8_t  uncovered;				/* Hits no placed ship covers yet */
+	bool	 refit;					/* fitH/fitV are stale */
+	uint16_t steps;					/* Placement tests so far */
+	uint16_t fleets;				/* Consistent fleets found */
+	uint16_t count[GRID_CELLS];		/* Fleets covering each cell */
+};
+
+_Static_assert(sizeof(Endgame) <= ARENA_AI_PLACE_BYTES, "Endgame search exceeds the AI scratch budget");
+_Static_assert(ENDGAME_STEP_BUDGET <= UINT16_MAX, "Endgame counts no longer fit in 16 bits");	/* A fleet costs at least one test */
+
+static uint16_t egMark;				/* Arena level to hand back when it ends */
+#ifdef AI_TRACE
+static uint32_t egEstimate;
+static uint16_t egSlices;
+#endif
+
+/* Set or clear a placement in `blocked`; returns how many hits it covers */
+static uint8_t eg_mark(Endgame *e, uint8_t code, uint8_t len, bool set) {
+	uint8_t row = (code / 2) / GRID_COLS, col = (code / 2) % GRID_COLS, covered = 0;
+	bool horizontal = !(code & 1);
+	uint16_t span = horizontal ? ((1u << len) - 1) << col : 1u << col;	// The ship's cells in each row it covers
+	for (uint8_t r = row; r < row + (horizontal ? 1 : len); ++r) {
+		if (set) e->blocked[r] |= span; else e->blocked[r] &= ~span;
+		for (uint16_t b = e->hits[r] & span; b; b &= b - 1) covered++;
+	}
+	return covered;
+}
+
+/* Does the placed fleet hold exactly as many cells as each scan counted? */
+static bool eg_scans_match(const Endgame *e) {
+	for (uint8_t i = 0; i < RADAR_USES; ++i) {
+		const RadarScan *scan = &aiScans[i];
+		if (scan->count == RADAR_NONE || scan->count == 0) continue;	/* Empty areas are in `blocked` */
+
+		uint8_t found = 0;
+		for (uint8_t s = 0; s < NUM_SHIPS; ++s) {
+			uint8_t row = (e->code[s] / 2) / GRID_COLS, col = (e->code[s] / 2) % GRID_COLS;
+			bool horizontal = !(e->code[s] & 1);
+			for (uint8_t k = 0; k < SHIP_LENGTHS[s]; ++k) {
+				if (radar_covers(scan, row + (horizontal ? 0 : k), col + (horizontal ? k : 0))) found++;
+			}
+		}
+		if (found != scan->count) return false;
+	}
+	return true;
+}
+
+/* Count a whole fleet's unhit cells */
+static void eg_count_fleet(Endgame *e) {
+	if (e->uncovered || !eg_scans_match(e)) return;		/* A hit left unexplained, or a radar count missed */
+	e->fleets++;
+	for (uint8_t i = 0; i < NUM_SHIPS; ++i) {
+		uint8_t row = (e->code[i] / 2) / GRID_COLS, col = (e->code[i] / 2) % GRID_COLS;
+		bool horizontal = !(e->code[i] & 1);
+		for (uint8_t k = 0; k < SHIP_LENGTHS[i]; ++k) {
+			uint8_t r = row + (horizontal ? 0 : k);
+			uint8_t c = col + (horizontal ? k : 0);
+			if (!(e->hits[r] & (1u << c))) e->count[r * GRID_COLS + c]++;
+		}
+	}
+}
+
+/* Start placing ship e->ship; ships of equal length are interchangeable, so each pair of positions counts once */
+static void eg_descend(Endgame *e) {
+	uint8_t s = e->ship;
+	e->code[s] = (s > 0 && SHIP_LENGTHS[s - 1] == SHIP_LENGTHS[s]) ? e->code[s - 1] + 1 : 0;
+	e->refit = true;
+}
+
+/* Take back the ship before e->ship and move it on; false once the search is over */
+static bool eg_backtrack(Endgame *e) {
+	if (e->ship == 0) return false;
+	uint8_t s = --e->ship, len = SHIP_LENGTHS[s];
+	e->uncovered += eg_mark(e, e->code[s], len, false);
+	e->lenLeft += len;
+	e->code[s]++;
+	e->refit = true;
+	return true;
+}
+
+/* Run up to `steps` placement tests; true once the search is over.		*/
+/* A test places the ship at the next place that fits in its row, or	*/
+/* finds none and moves to the next row.								*/
+static bool eg_run(Endgame *e, uint16_t steps) {
+	for (;;) {
+		uint8_t s = e->ship;
+		if (s == NUM_SHIPS) {
+			eg_count_fleet(e);
+			if (!eg_backtrack(e)) return true;
+			continue;
+		}
+		if (e->uncovered > e->lenLeft || e->code[s] >= AI_PLACE_MAX) {	/* Not enough ship left for the hits, or tried them all */
+			if (!eg_backtrack(e)) return true;
+			continue;
+		}
+		if (steps-- == 0) return false;
+		e->steps++;
+
+		uint8_t code = e->code[s], len = SHIP_LENGTHS[s];
+		uint8_t row = (code / 2) / GRID_COLS, col = (code / 2) % GRID_COLS;
+		if (e->refit || (col == 0 && !(code & 1))) {	// `blocked` only changes on the path, so each row's fits are tested once
+			e->fitH = ship_fit_row(e->blocked, row, len, true);
+			e->fitV = ship_fit_row(e->blocked, row, len, false);
+			e->refit = false;
+		}
+		bool vertical = code & 1;
+		while (col < GRID_COLS && !(((vertical ? e->fitV : e->fitH) >> col) & 1)) {	/* On to the row's next fit */
+			if (vertical) col++;
+			vertical = !vertical;
+		}
+		if (col == GRID_COLS) {		/* None left: one test takes it to the next row */
+			e->code[s] = (row + 1) * GRID_COLS * 2;
+			continue;
+		}
+		code = (row * GRID_COLS + col) * 2 + vertical;
+		e->code[s] = code + 1;
+
+		uint8_t covered = eg_mark(e, code, len, true);
+		if (len - covered > e->lenLeft - e->uncovered) {	/* Uses more unhit cells than the fleet has left */
+			eg_mark(e, code, len, false);
+			continue;
+		}
+		e->code[s] = code;
+		e->uncovered -= covered;
+		e->lenLeft -= len;
+		e->ship++;
+		if (e->ship < NUM_SHIPS) eg_descend(e);
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* Upper bound on the placement tests a whole search takes. A ship is */
+/* tried once per path of the ships before it, taking a test for each */
+/* place that fits around the misses and one per row. A path only	  */
+/* goes on while its ships											  */
+/* hold no more than `allow` unhit cells between them, so the paths	  */
+/* are counted by how many unhit cells they hold: each ship's places  */
+/* (fitting around the misses) are grouped by unhit cells, and the	  */
+/* paths to the next ship are the sums that stay within `allow`.	  */
+/* Overlaps and equal-length ships only make the bound looser.		  */
+/* Stops counting once past `limit`; an `allow` of more than		  */
+/* ENDGAME_ALLOW_MAX is always past it.								  */
+/* ------------------------------------------------------------------ */
+static uint32_t eg_estimate(const Endgame *e, uint8_t allow, uint32_t limit) {
+	if (allow > ENDGAME_ALLOW_MAX) return limit + 1;
+
+	uint32_t paths[ENDGAME_ALLOW_MAX + 1] = { 1 };	/* Paths to the current ship, by unhit cells held */
+	uint32_t tests = 0;
+	for (uint8_t s = 0; s < NUM_SHIPS; ++s) {
+		uint8_t len = SHIP_LENGTHS[s], fits = 0, places[ENDGAME_ALLOW_MAX + 1] = { 0 };	/* This ship's places, by unhit cells */
+		for (uint8_t row = 0; row < GRID_ROWS; ++row) {
+			uint16_t fit[2] = { ship_fit_row(e->blocked, row, len, true), ship_fit_row(e->blocked, row, len, false) };
+			for (uint8_t v = 0; v < 2; ++v) {
+				for (uint8_t col = 0; fit[v]; ++col, fit[v] >>= 1) {
+					if (!(fit[v] & 1)) continue;
+					fits++;
+					uint16_t span = v ? 1u << col : ((1u << len) - 1) << col;
+					uint8_t covered = 0;
+					for (uint8_t r = row; r < row + (v ? len : 1); ++r) {
+						for (uint16_t b = e->hits[r] & span; b; b &= b - 1) covered++;
+					}
+					if (len - covered <= allow) places[len - covered]++;
+				}
+			}
+		}
+		uint32_t total = 0;
+		for (uint8_t k = 0; k <= allow; ++k) total += paths[k];
+		tests += total * (fits + GRID_ROWS);
+		if (!total || tests > limit) return tests;
+
+		for (int8_t k = allow; k >= 0; --k) {	/* In place: paths[k] takes from paths[k - u] before those change */
+			uint32_t sum = 0;
+			for (uint8_t u = 0; u <= k; ++u) sum += paths[k - u] * places[u];
+			paths[k] = sum > limit ? limit + 1 : sum;	/* Past the limit is past it; keep the sums from wrapping */
+		}
+	}
+	return tests;
+}
+
+/* ------------------------------------------------------------------ */
+/* Hard AI: start a search for its next move if the estimate is	  */
+/* small enough. True if it started (sp_tick then runs it).		  */
+/* ------------------------------------------------------------------ */
+static bool eg_begin(void) {
+	if (aiDifficulty != AI_HARD || eg) return false;
+
+	uint16_t mark = arena_mark();
+	Endgame *e = arena_alloc(sizeof(Endgame));
+	if (!e) return false;
+
+	// What the AI has seen: hits and misses of its own shots
+	uint8_t totalLen = 0;
+	for (uint8_t i = 0; i < NUM_SHIPS; ++i) totalLen += SHIP_LENGTHS[i];
+	e->uncovered = 0;
+	bitmap_to_rows(game.playerAttackedAtBitmap, e->blocked);
+	bitmap_to_rows(game.playerOccupiedBitmap, e->hits);
+	for (uint8_t r = 0; r < GRID_ROWS; ++r) {
+		uint16_t shot = e->blocked[r];
+		e->hits[r]	&= shot;
+		e->blocked[r] = shot & ~e->hits[r];
+		for (uint16_t b = e->hits[r]; b; b &= b - 1) e->uncovered++;
+		for (uint8_t c = 0; c < GRID_COLS; ++c) {
+			if (ai_known_empty(r, c)) e->blocked[r] |= 1u << c;
+		}
+	}
+
+	uint32_t estimate = eg_estimate(e, totalLen - e->uncovered, ENDGAME_ESTIMATE_MAX);
+	if (estimate > ENDGAME_ESTIMATE_MAX) {
+		arena_release(mark);
+		return false;
+	}
+
+	memset(e->count, 0, sizeof(e->count));
+	e->ship	   = 0;
+	e->lenLeft = totalLen;
+	e->steps   = 0;
+	e->fleets  = 0;
+	eg_descend(e);
+	eg	   = e;
+	egMark = mark;
+#ifdef AI_TRACE
+	egEstimate = estimate;
+	egSlices   = 0;
+#endif
+	return true;
+}
+
+/* Drop a search in progress (game over, or a new game) */
+static void eg_cancel(void) {
+	if (!eg) return;
+	arena_release(egMark);
+	eg = NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* Run a slice of the search. Once it is over, pick the unshot cell	  */
+/* most fleets cover and return true; `chance` is its hit chance in	  */
+/* 1/256 (0: no fleet fits or the search was cut off, nothing chosen). */
+/* ------------------------------------------------------------------ */
+static bool eg_step(int* row_to_attack, int* col_to_attack, uint16_t* chance) {
+	*chance = 0;
+	if (!eg_run(eg, ENDGAME_SLICE_STEPS)) {
+#ifdef AI_TRACE
+		egSlices++;
+#endif
+		if (eg->steps < ENDGAME_STEP_BUDGET) return false;
+		AI_TRACE_ENDGAME_CUT(egEstimate, eg->steps, egSlices);
+		eg_cancel();
+		return true;
+	}
+
+	if (eg->fleets) {
+		uint8_t best = 0;
+		for (uint8_t cell = 1; cell < GRID_CELLS; ++cell) {
+			if (eg->count[cell] > eg->count[best]) best = cell;
+		}
+		if (eg->count[best]) {
+			*row_to_attack = best / GRID_COLS;
+			*col_to_attack = best % GRID_COLS;
+			*chance = ((uint32_t)eg->count[best] * 256) / eg->fleets;
+		}
+	}
+	AI_TRACE_ENDGAME(egEstimate, eg->steps, egSlices + 1, eg->fleets);
+	eg_cancel();
+	return true;
+}
+
 /* ----------------------------------------------------------------- */
 /* AI determines the square to attack, and returns it via			 */
-/* row_to_attack and col_to_attack									 */
+/* row_to_attack and col_to_attack. Returns true to radar-scan		 */
+/* around that square instead.										 */
 /* ----------------------------------------------------------------- */
-void ai_attack_algorithm(int* row_to_attack, int* col_to_attack) {
+bool ai_attack_algorithm(int* row_to_attack, int* col_to_attack) {
 		
 	// Determine the probability the AI will hit a ship square, based on difficulty setting
 	switch (aiDifficulty) {
@@ -188,31 +747,99 @@ void ai_attack_algorithm(int* row_to_attack, int* col_to_attack) {
 	}
 	
 	// Select a ship or ocean square based on that probability
+	// (Hard guesses honestly from the prior instead of taking a sure miss)
 	if (rand_bool(probability_of_hit)) {
 		find_random_ship_square(row_to_attack, col_to_attack);		// (result returned in row_to_attack and col_to_attack)
+	} else if (aiDifficulty == AI_HARD) {
+		find_prior_square(row_to_attack, col_to_attack);
+		if (aiRadarLeft) {
+			// Scan around the guess instead, moved in off the edge so all nine cells count
+			*row_to_attack = ai_clamp(*row_to_attack, RADAR_RADIUS, GRID_ROWS - 1 - RADAR_RADIUS);
+			*col_to_attack = ai_clamp(*col_to_attack, RADAR_RADIUS, GRID_COLS - 1 - RADAR_RADIUS);
+			return true;
+		}
+		if (BITMAP_GET(game.playerOccupiedBitmap, *row_to_attack, *col_to_attack)) player_ship_squares_attacked++;
+		else player_ocean_squares_attacked++;
 	} else {
 		find_random_ocean_square(row_to_attack, col_to_attack);
 	}
-	
+	return false;
 }
 
+
 /* Spoofed TX helpers ----------------------------------------------------- */
 
+/* ------------------------------------------------------------------ */
+/* Queue the AI's move now: a lone attack, or a scan					  */
+/* ------------------------------------------------------------------ */
+static void ai_push_plain_move(void)
+{
+	char line[32];
+	int row_to_attack = 0;
+	int col_to_attack = 0;
+
+	if (ai_attack_algorithm(&row_to_attack, &col_to_attack)) {
+		snprintf(line, sizeof(line), "S %u %u %u", RADAR_USES - aiRadarLeft, row_to_attack, col_to_attack);
+		aiRadarLeft--;
+	} else {
+		AI_TRACE_SHOT(row_to_attack, col_to_attack, BITMAP_GET(game.playerOccupiedBitmap, row_to_attack, col_to_attack));
+		snprintf(line, sizeof(line), "A %u %u", row_to_attack, col_to_attack);
+	}
+	q_push(line);
+}
+
+/* ------------------------------------------------------------------ */
+/* Queue the AI's move, or start an endgame search that queues it	  */
+/* from sp_tick														  */
+/* ------------------------------------------------------------------ */
+static void ai_push_move(void)
+{
+	if (!eg_begin()) ai_push_plain_move();
+}
+
+/* ------------------------------------------------------------------ */
+/* An endgame search is over: take its cell when the odds are good	  */
+/* ------------------------------------------------------------------ */
+static void ai_push_endgame_move(int row, int col, uint16_t chance)
+{
+	if (chance < ENDGAME_MIN_CHANCE) {
+		ai_push_plain_move();
+		return;
+	}
+	char line[32];
+	if (BITMAP_GET(game.playerOccupiedBitmap, row, col)) player_ship_squares_attacked++;
+	else player_ocean_squares_attacked++;
+	AI_TRACE_SHOT(row, col, BITMAP_GET(game.playerOccupiedBitmap, row, col));
+	snprintf(line, sizeof(line), "A %u %u", row, col);
+	q_push(line);
+}
+
 /* ------------------------------------------------------------------ */
 /* Player transmits that they're ready to the AI					  */
 /* ------------------------------------------------------------------ */
 void sp_on_tx_ready(uint16_t self_token)
 {
-	// 1 - Set up the AI board
-	ai_place_random();
-	
-	// 2 - Initialize game variables
-	player_ship_squares_attacked = 0;
-	player_ocean_squares_attacked = 0;
+	// 1 - Once per game (READY keeps coming for READY_LINGER_MS after the first)
+	if (!aiSetUp) {
+		aiSetUp = true;
+
+		// Set up the AI board, and recall (then start learning) the player's habits
+		ai_place_random();
+		habit_load();
+
+		// Initialize game variables
+		player_ship_squares_attacked = 0;
+		player_ocean_squares_attacked = 0;
+		for (uint8_t i = 0; i < RADAR_USES; ++i) aiScans[i].count = RADAR_NONE;
+		aiRadarLeft = RADAR_USES;
+		AI_TRACE_NEW();
+	}
 	
-	// 3 - Transmit ready back
+	// 3 - Transmit ready back (the AI answers radar scans), only until the
+	//     player has synced: lingering answers would fill the queue ahead of moves
+	if (game.nState != NS_WAIT_READY) return;
 	char line[32];
-	snprintf(line, sizeof(line), "READY %u", 1);   /* static peer token = 1 */
+	snprintf(line, sizeof(line), "READY %u S", 1);   /* static peer token = 1 */
 	q_push(line);
 }
 
@@ -223,21 +850,71 @@ void sp_on_tx_attack(uint8_t row, uint8_t col)
 {
 	char line[32];
 
-	// 1 - Send back the result (player just hit/missed an AI ship)
+	// 1 - Result of the player's shot (player just hit/missed an AI ship)
 	int hit = BITMAP_GET(aiOccupiedBitmap, row, col);
-	snprintf(line, sizeof(line), "R %u %u %c", row, col, hit ? 'H' : 'M');
-	q_push(line);
 
-	// 2 - AI determines which player square to attack
+	// 2 - Hard AI in the endgame: the result goes now, the attack once the search ends (sp_tick)
+	if (eg_begin()) {
+		snprintf(line, sizeof(line), "R %u %u %c", row, col, hit ? 'H' : 'M');
+		q_push(line);
+		return;
+	}
+
+	//     Otherwise the AI determines which player square to attack
 	int row_to_attack = 0;
 	int col_to_attack = 0;
-	ai_attack_algorithm(&row_to_attack, &col_to_attack);  // (result stored in row_to_attack and col_to_attack)
+	if (ai_attack_algorithm(&row_to_attack, &col_to_attack)) {  // (result stored in row_to_attack and col_to_attack)
+		// A scan can't ride on the result: send them one after the other
+		snprintf(line, sizeof(line), "R %u %u %c", row, col, hit ? 'H' : 'M');
+		q_push(line);
+		snprintf(line, sizeof(line), "S %u %u %u", RADAR_USES - aiRadarLeft, row_to_attack, col_to_attack);
+		aiRadarLeft--;
+		q_push(line);
+		return;
+	}
+	AI_TRACE_SHOT(row_to_attack, col_to_attack, BITMAP_GET(game.playerOccupiedBitmap, row_to_attack, col_to_attack));
 	
-	// 3 - AI attacks that square
-	snprintf(line, sizeof(line), "A %u %u", row_to_attack, col_to_attack);
+	// 3 - AI sends the result and its attack in one piggybacked frame
+	snprintf(line, sizeof(line), "P %u %u %c %u %u", row, col, hit ? 'H' : 'M', row_to_attack, col_to_attack);
 	q_push(line);
 }
 
+/* ------------------------------------------------------------------ */
+/* Game over: write this game's habits back (once, from sp_tick)	  */
+/* ------------------------------------------------------------------ */
+void sp_on_game_over(void)
+{
+	eg_cancel();
+	habitWrite = 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Player scans the AI's board with radar							  */
+/* ------------------------------------------------------------------ */
+void sp_on_tx_scan(uint8_t seq, uint8_t row, uint8_t col)
+{
+	char line[32];
+	(void)seq;		// Answers are never lost here, so resends need no telling apart
+
+	// 1 - Answer with the AI ship cells around the centre
+	snprintf(line, sizeof(line), "Q %u %u %u", row, col, radar_count(aiOccupiedBitmap, row, col));
+	q_push(line);
+
+	// 2 - The scan used the player's turn: AI moves
+	ai_push_move();
+}
+
+/* ------------------------------------------------------------------ */
+/* Player answers the AI's scan: remember it for the endgame solver   */
+/* ------------------------------------------------------------------ */
+void sp_on_tx_scan_result(uint8_t row, uint8_t col, uint8_t count)
+{
+	RadarScan *scan = &aiScans[RADAR_USES - 1 - aiRadarLeft];
+	if (scan->count != RADAR_NONE) return;		// Already answered
+	*scan = (RadarScan){ row, col, count };
+	AI_TRACE_SCAN(row, col, count);
+}
+
 /* ------------------------------------------------------------------ */
 /* Player transmits a hit/miss result back to the AI (not used)		  */
 /* ------------------------------------------------------------------ */
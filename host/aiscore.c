@@ -0,0 +1,288 @@
+/* ---------------------------------------------------------------------------
+ * aiscore.c - The firmware AI's shots against the exact best ones
+ *
+ *     aiscore [-g games] [-s seed] [-l level] [-r scan-chance] [-f first]
+ *             [-j threads] [-c cache] [-i trace] [-v]
+ *
+ * Plays -g games against the firmware's AI on the "trace" image (built with
+ * -DAI_TRACE, see singleplayer.c), or reads the same lines from a serial
+ * log with -i:
+ *
+ *     AI NEW <level>          a game starts
+ *     AI <row> <col> H|M      the AI shot here, and hit or missed
+ *     AI S <row> <col> <n>    the AI's radar scan found n ship cells
+ *     AI EG <est> <tests> <slices> <fleets>|-
+ *                             the Hard AI's endgame search finished, or
+ *                             was cut off at its budget (-)
+ *
+ * Before each shot, the position the AI shot from (its hits, misses and
+ * scans so far) is solved exactly (posterior.h), and the shot is scored:
+ *
+ *   p      the shot's hit probability given what the AI had seen
+ *   best   the highest hit probability of any unshot cell
+ *   rank   1 + unshot cells more likely than the one it chose
+ *
+ * Per game and per level it prints hits made, hits expected (sum of p), the
+ * hits a greedy player expects from the same positions (sum of best), how
+ * often the AI took a best cell, and its mean rank. The firmware's AI knows
+ * the player's board and hits by a set chance per level, so more hits than
+ * expected is that knowledge, not skill.
+ *
+ * Each endgame search that finished is checked: its fleet count against the
+ * exact one for the same position, and its placement tests against its own
+ * estimate (an upper bound). The most tests and slices any search took are
+ * the host-measured worst case, and cut-off searches are counted; a search
+ * that disagrees fails the run.
+ *
+ * -f skips scoring each game's first shots (the costly positions; they are
+ * still applied). -c keeps solved positions in a file: every game starts
+ * from the same opening, which is solved once.
+ * --------------------------------------------------------------------------- */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "instance.h"
+#include "match.h"
+#include "posterior.h"
+
+#include "battleship_utils.h"
+
+#define LEVELS	3
+
+static const char *const LEVEL_NAMES[LEVELS] = { "easy", "medium", "hard" };
+
+typedef struct {
+	uint32_t games, shots, hits, best, rankSum;
+	double	 expected, greedy;
+} Score;
+
+/* The firmware's endgame searches */
+typedef struct {
+	uint32_t searches, cut, wrong, overEstimate;
+	uint32_t maxEstimate, maxTests, maxSlices;
+} Endgames;
+
+typedef struct {
+	PostCache *cache;
+	unsigned  threads;
+	uint32_t  first;
+	bool	  verbose;
+	/* The game being read */
+	bool	  open;
+	uint8_t	  level;
+	uint32_t  shot;
+	Position  pos;
+	Score	  game;
+	Score	  levels[LEVELS];
+	Endgames  endgames;
+} Scorer;
+
+/* Trace lines from the board, kept for scoring after the match */
+typedef struct {
+	char	 (*lines)[32];
+	uint32_t count, cap;
+} Trace;
+
+static void print_score(const char *name, const Score *s) {
+	if (!s->shots) {
+		printf("%-8s games=%u no shots scored\n", name, s->games);
+		return;
+	}
+	printf("%-8s games=%u shots=%u hits=%u expected=%.1f greedy=%.1f best=%.0f%% mean-rank=%.1f\n", name, s->games,
+		   s->shots, s->hits, s->expected, s->greedy, 100.0 * s->best / s->shots, (double)s->rankSum / s->shots);
+}
+
+static void add_score(Score *sum, const Score *s) {
+	sum->games += s->games;
+	sum->shots += s->shots;
+	sum->hits += s->hits;
+	sum->best += s->best;
+	sum->rankSum += s->rankSum;
+	sum->expected += s->expected;
+	sum->greedy += s->greedy;
+}
+
+static void end_game(Scorer *sc) {
+	if (!sc->open)
+		return;
+	sc->game.games = 1;
+	char name[16];
+	snprintf(name, sizeof(name), "game %u", sc->levels[sc->level].games + 1);
+	print_score(name, &sc->game);
+	add_score(&sc->levels[sc->level], &sc->game);
+	sc->open = false;
+}
+
+static void shot(Scorer *sc, uint8_t row, uint8_t col, bool hit) {
+	if (sc->shot++ >= sc->first) {
+		Posterior post;
+		posterior_solve(sc->cache, &sc->pos, sc->threads, &post);
+		ShotScore s = posterior_score(&post, &sc->pos, row, col);
+		sc->game.shots++;
+		sc->game.hits += hit;
+		sc->game.expected += s.pShot;
+		sc->game.greedy += s.pBest;
+		sc->game.best += s.rank == 1;
+		sc->game.rankSum += s.rank;
+		if (sc->verbose)
+			printf("  shot %2u %u,%u %c p=%.3f best=%.3f at %u,%u rank=%u fleets=%llu\n", sc->shot, row, col,
+				   hit ? 'H' : 'M', s.pShot, s.pBest, s.best / GRID_COLS, s.best % GRID_COLS, s.rank,
+				   (unsigned long long)post.fleets);
+	}
+	position_shot(&sc->pos, row, col, hit);
+}
+
+/**
+ * The firmware finished an endgame search from the current position, or cut
+ * it off (`cut`, no fleet count).
+ */
+static void endgame(Scorer *sc, uint32_t estimate, uint32_t tests, uint32_t slices, bool cut, uint32_t fleets) {
+	Endgames *e = &sc->endgames;
+	if (estimate > e->maxEstimate) e->maxEstimate = estimate;
+	if (tests > e->maxTests) e->maxTests = tests;
+	if (slices > e->maxSlices) e->maxSlices = slices;
+	e->searches++;
+	if (cut) {
+		e->cut++;
+		if (sc->verbose)
+			printf("  endgame est=%u tests=%u slices=%u cut off\n", estimate, tests, slices);
+		return;
+	}
+	Posterior post;
+	posterior_solve(sc->cache, &sc->pos, sc->threads, &post);
+	bool wrong = post.fleets != fleets;
+	e->wrong += wrong;
+	e->overEstimate += tests > estimate;
+	if (sc->verbose || wrong)
+		printf("  endgame est=%u tests=%u slices=%u fleets=%u exact=%llu%s\n", estimate, tests, slices, fleets,
+			   (unsigned long long)post.fleets, wrong ? " WRONG" : "");
+}
+
+/**
+ * One line of trace (or of a log with other lines in it).
+ */
+static void trace_line(Scorer *sc, const char *line) {
+	const char *ai = strstr(line, "AI ");
+	if (!ai || (ai != line && ai[-1] != ' '))
+		return;
+	unsigned a, b, c, d;
+	char hm, end;
+	if (sscanf(ai, "AI NEW %u%c", &a, &end) == 1 && a < LEVELS) {
+		end_game(sc);
+		sc->open = true;
+		sc->level = (uint8_t)a;
+		sc->shot = 0;
+		position_clear(&sc->pos);
+		memset(&sc->game, 0, sizeof(sc->game));
+	} else if (!sc->open) {
+		return;
+	} else if (sscanf(ai, "AI EG %u %u %u %u%c", &a, &b, &c, &d, &end) == 4) {
+		endgame(sc, a, b, c, false, d);
+	} else if (sscanf(ai, "AI EG %u %u %u %c%c", &a, &b, &c, &hm, &end) == 4 && hm == '-') {
+		endgame(sc, a, b, c, true, 0);
+	} else if (sscanf(ai, "AI S %u %u %u%c", &a, &b, &c, &end) == 3) {
+		position_scan(&sc->pos, (uint8_t)a, (uint8_t)b, (uint8_t)c);
+	} else if (sscanf(ai, "AI %u %u %c%c", &a, &b, &hm, &end) == 3 && a < GRID_ROWS && b < GRID_COLS
+			   && (hm == 'H' || hm == 'M')) {
+		shot(sc, (uint8_t)a, (uint8_t)b, hm == 'H');
+	}
+}
+
+/**
+ * MatchLineFn: keep the AI's lines; scoring runs after the match, off the
+ * firmware's stack.
+ */
+static void on_line(void *user, Node *n, const char *line) {
+	Trace *t = user;
+	if (!strncmp(line, "AI X", 4)) fprintf(stderr, "%s\n", line);
+	if (strncmp(line, "AI ", 3))
+		return;
+	if (t->count == t->cap) {
+		t->cap = t->cap ? 2 * t->cap : 256;
+		t->lines = realloc(t->lines, t->cap * sizeof(*t->lines));
+	}
+	snprintf(t->lines[t->count++], sizeof(*t->lines), "%s", line);
+}
+
+int main(int argc, char **argv) {
+	MatchConfig cfg = { .mode = MATCH_AI, .games = 1, .seed = 1, .scanChance = 0.1, .mute = true };
+	Scorer sc = { .threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN) };
+	const char *cachePath = NULL, *tracePath = NULL;
+	int level = -1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "g:s:l:r:f:j:c:i:v")) != -1) {
+		switch (opt) {
+			case 'g': cfg.games = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 's': cfg.seed = strtoull(optarg, NULL, 0); break;
+			case 'l': level = atoi(optarg); break;
+			case 'r': cfg.scanChance = atof(optarg); break;
+			case 'f': sc.first = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 'j': sc.threads = (unsigned)strtoul(optarg, NULL, 0); break;
+			case 'c': cachePath = optarg; break;
+			case 'i': tracePath = optarg; break;
+			case 'v': sc.verbose = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-g games] [-s seed] [-l level] [-r scan-chance] [-f first] [-j threads] [-c cache] [-i trace] [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+	if (level >= LEVELS) {
+		fprintf(stderr, "level is 0 (easy) to %d (hard)\n", LEVELS - 1);
+		return 2;
+	}
+
+	posterior_fleet(SHIP_LENGTHS, NUM_SHIPS);
+	sc.cache = posterior_cache_open(cachePath);
+	bool stalled = false;
+
+	if (tracePath) {
+		FILE *f = fopen(tracePath, "r");
+		if (!f) {
+			perror(tracePath);
+			return 2;
+		}
+		char line[256];
+		while (fgets(line, sizeof(line), f)) {
+			line[strcspn(line, "\r\n")] = '\0';
+			trace_line(&sc, line);
+		}
+		fclose(f);
+	} else {
+		Trace t = { 0 };
+		cfg.onLine = on_line;
+		cfg.user = &t;
+		Match m;
+		match_init(&m, &cfg);
+		if (level >= 0) {
+			instance_enter(m.nodes[0].in);
+			aiDifficulty = (AIDifficulty)level;
+		}
+		while (match_step(&m))
+			;
+		stalled = m.stalled;
+		match_free(&m);
+		for (uint32_t i = 0; i < t.count; i++)
+			trace_line(&sc, t.lines[i]);
+		free(t.lines);
+	}
+	end_game(&sc);
+
+	printf("\n");
+	for (uint8_t l = 0; l < LEVELS; l++)
+		if (sc.levels[l].games)
+			print_score(LEVEL_NAMES[l], &sc.levels[l]);
+	const Endgames *e = &sc.endgames;
+	if (e->searches)
+		printf("endgame: searches=%u most tests=%u slices=%u estimate=%u; %u cut off, %u over estimate, %u wrong\n",
+			   e->searches, e->maxTests, e->maxSlices, e->maxEstimate, e->cut, e->overEstimate, e->wrong);
+	uint64_t hits, misses;
+	posterior_cache_stats(sc.cache, &hits, &misses);
+	printf("positions: %llu solved, %llu from the cache\n", (unsigned long long)misses, (unsigned long long)hits);
+	posterior_cache_close(sc.cache);
+	return stalled || e->wrong || e->overEstimate ? 1 : 0;
+}
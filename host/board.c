@@ -0,0 +1,387 @@
+/* ---------------------------------------------------------------------------
+ * board.c - Virtual-time ATmega328P board for the host build
+ *
+ * Linked into the firmware image: its globals are per board, like the
+ * firmware's own.
+ * --------------------------------------------------------------------------- */
+#include "board.h"
+
+#include <avr/io.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------------
+ *  REGISTERS WITHOUT SIDE EFFECTS
+ * ------------------------------------------------------------------------- */
+volatile uint8_t DDRB, PORTB, PINB, DDRC, PORTC, PINC, DDRD, PORTD, PIND = 0xFF;
+volatile uint8_t SPCR, ADMUX, DIDR0, UBRR0H, UBRR0L, UCSR0B, UCSR0C;
+volatile uint8_t TCCR0A, TCCR0B, TIMSK0, TIFR0, OCR0A, TCCR1A, TCCR1B, TIFR1;
+volatile uint8_t SREG, MCUSR;
+volatile uint16_t ADC, ICR1, OCR1B;
+
+Board board;
+FILE *board_stdout;
+
+#define TIMER0_OVERFLOW_NS	(256ULL * 4 * NS_PER_US)	/* clk/64: 4 us per count */
+#define TIMER1_COUNT_NS		(64ULL * NS_PER_US)			/* clk/1024 */
+#define TIMER_POLL_NS		NS_PER_US					/* One poll of a timer register */
+#define RECHECK_NS			NS_PER_MS					/* Look at the timer setup this often */
+#define EEPROM_WRITE_NS		(3400ULL * NS_PER_US)
+
+/* Vectors the firmware may leave out (Timer0 is LATENCY_REPORT only) */
+void TIMER0_OVF_vect(void) __attribute__((weak));
+void USART_RX_vect(void) __attribute__((weak));
+
+static uint64_t eepromReady;
+
+/* -------------------------------------------------------------------------
+ *  VIRTUAL CLOCK
+ * ------------------------------------------------------------------------- */
+static bool timer0_running(void) {
+	return (TIMSK0 & (1 << TOIE0)) && (TCCR0B & 0x07) == ((1 << CS01) | (1 << CS00)) && TIMER0_OVF_vect;
+}
+
+void board_reschedule(void) {
+	uint64_t due = board.horizon;
+	if (board.eventCount && board.events[0].at < due)
+		due = board.events[0].at;
+	if (board.rxCount && board.rxq[board.rxHead].at < due)
+		due = board.rxq[board.rxHead].at;
+
+	uint64_t check = timer0_running() ? board.t0NextOverflow : board.now + RECHECK_NS;
+	if (check < due)
+		due = check;
+	board.nextDue = due;
+}
+
+/**
+ * Deliver everything due at `board.now`, and yield at the horizon.
+ */
+static void service(void) {
+	while (board.eventCount && board.events[0].at <= board.now) {
+		BoardEvent *e = &board.events[0];
+		if (e->kind == BOARD_EV_ADC) {
+			board.adc[e->channel & 7] = e->value;
+		} else {
+			board.button = e->value != 0;
+			PIND = board.button ? (PIND & ~(1 << PD2)) : (PIND | (1 << PD2));
+		}
+		memmove(&board.events[0], &board.events[1], --board.eventCount * sizeof(BoardEvent));
+	}
+
+	while (board.rxCount && board.rxq[board.rxHead].at <= board.now) {
+		if (board.rxFifoCount < BOARD_UART_RX_DEPTH)
+			board.rxFifo[board.rxFifoCount++] = board.rxq[board.rxHead].byte;
+		else
+			board.stats.uartOverruns++;
+		board.rxHead = (board.rxHead + 1) % BOARD_RX_QUEUE;
+		board.rxCount--;
+	}
+
+	if (timer0_running()) {
+		if (board.t0NextOverflow <= board.now) {
+			board.t0NextOverflow += TIMER0_OVERFLOW_NS;
+			TIFR0 |= 1 << TOV0;
+		}
+	} else {
+		board.t0NextOverflow = (board.now / TIMER0_OVERFLOW_NS + 1) * TIMER0_OVERFLOW_NS;
+	}
+
+	/* Vectors run with I clear, like the AVR's, so they don't nest */
+	if (SREG & (1 << SREG_I)) {
+		SREG &= ~(1 << SREG_I);
+		if ((TIFR0 & (1 << TOV0)) && timer0_running()) {
+			TIFR0 &= ~(1 << TOV0);
+			TIMER0_OVF_vect();
+		}
+		while (board.rxFifoCount && (UCSR0B & (1 << RXCIE0)) && USART_RX_vect)
+			USART_RX_vect();
+		SREG |= 1 << SREG_I;
+	}
+
+	if (board.now >= board.horizon && board.yield)
+		board.yield();		/* Returns with a later horizon */
+
+	board_reschedule();
+}
+
+void board_advance(uint64_t ns) {
+	uint64_t end = board.now + ns;
+	while (board.nextDue <= end) {
+		if (board.nextDue > board.now)
+			board.now = board.nextDue;
+		service();
+	}
+	board.now = end;
+}
+
+void board_power_on(void) {
+	memset(&board, 0, sizeof(board));
+	memset(board.eeprom, 0xFF, sizeof(board.eeprom));
+	for (uint8_t ch = 0; ch < 8; ch++)
+		board.adc[ch] = BOARD_STICK_CENTRE;
+	board.horizon = BOARD_NEVER;
+	board.spiStatus = 1 << SPIF;
+	board.t0NextOverflow = TIMER0_OVERFLOW_NS;
+	PIND = 0xFF;
+	eepromReady = 0;
+	board_reschedule();
+}
+
+/* -------------------------------------------------------------------------
+ *  INPUTS
+ * ------------------------------------------------------------------------- */
+static void post(uint64_t at, uint8_t kind, uint8_t channel, uint16_t value) {
+	if (board.eventCount == BOARD_EVENTS)
+		return;
+	uint8_t i = board.eventCount++;
+	while (i && board.events[i - 1].at > at) {
+		board.events[i] = board.events[i - 1];
+		i--;
+	}
+	board.events[i] = (BoardEvent){ at, kind, channel, value };
+	board_reschedule();
+}
+
+void board_stick_at(uint64_t at, uint8_t channel, uint16_t value) {
+	post(at, BOARD_EV_ADC, channel, value);
+}
+
+void board_button_at(uint64_t at, bool pressed) {
+	post(at, BOARD_EV_BUTTON, 0, pressed);
+}
+
+bool board_rx_push(uint64_t at, uint8_t byte) {
+	if (board.rxCount == BOARD_RX_QUEUE)
+		return false;
+	uint16_t tail = (board.rxHead + board.rxCount) % BOARD_RX_QUEUE;
+	board.rxq[tail].at = at;
+	board.rxq[tail].byte = byte;
+	if (board.rxCount++ == 0)
+		board_reschedule();
+	return true;
+}
+
+/* -------------------------------------------------------------------------
+ *  REGISTERS WITH SIDE EFFECTS
+ * ------------------------------------------------------------------------- */
+static void spi_shift(void) {
+	board.spiPending = false;
+	board.stats.spiBytes++;
+	if (board.lcd)
+		lcd_byte(board.lcd, board.spiLatch, board.spiData);
+	board_advance(BOARD_SPI_BYTE_NS);
+}
+
+volatile uint8_t *board_spdr(void) {
+	if (board.spiPending)
+		spi_shift();			/* Written again without waiting for SPIF */
+	board.spiPending = true;
+	board.spiData = (PORTB >> PB1) & 1;
+	return &board.spiLatch;
+}
+
+volatile uint8_t *board_spsr(void) {
+	if (board.spiPending)
+		spi_shift();
+	board.spiStatus |= 1 << SPIF;
+	return &board.spiStatus;
+}
+
+volatile uint8_t *board_ucsr0a(void) {
+	board.ucsr0a = (1 << UDRE0) | (board.rxFifoCount ? 1 << RXC0 : 0);
+	return &board.ucsr0a;
+}
+
+volatile uint8_t *board_udr0(void) {
+	if (board.rxFifoCount) {
+		board.udrLatch = board.rxFifo[0];
+		memmove(&board.rxFifo[0], &board.rxFifo[1], --board.rxFifoCount);
+		board.stats.uartRx++;
+	}
+	return &board.udrLatch;
+}
+
+volatile uint8_t *board_adcsra(void) {
+	if (board.adcsra & (1 << ADSC)) {
+		board_advance(BOARD_ADC_NS);
+		ADC = board.adc[ADMUX & 0x07];
+		board.adcsra &= ~(1 << ADSC);
+		board.stats.adcReads++;
+	}
+	return &board.adcsra;
+}
+
+volatile uint8_t *board_tcnt0(void) {
+	board_advance(TIMER_POLL_NS);
+	board.t0Shown = (uint8_t)(board.now / (4 * NS_PER_US));
+	return &board.t0Shown;
+}
+
+static uint16_t t1Cell;
+
+volatile uint16_t *board_tcnt1(void) {
+	if (t1Cell != board.t1Shown)	/* The firmware wrote the counter */
+		board.t1Start = board.now - t1Cell * TIMER1_COUNT_NS;
+	board_advance(TIMER_POLL_NS);
+	if ((TCCR1B & 0x07) == ((1 << CS12) | (1 << CS10)))
+		board.t1Shown = (uint16_t)((board.now - board.t1Start) / TIMER1_COUNT_NS);
+	t1Cell = board.t1Shown;
+	return &t1Cell;
+}
+
+uint16_t board_tone_hz(void) {
+	if (!(TCCR1A & (1 << COM1B1)) || (TCCR1B & 0x07) != (1 << CS10))
+		return 0;
+	return (uint16_t)(16000000UL / ((uint32_t)ICR1 + 1));
+}
+
+/* -------------------------------------------------------------------------
+ *  DELAYS AND EEPROM
+ * ------------------------------------------------------------------------- */
+void _delay_ms(double ms) {
+	board_advance((uint64_t)(ms * NS_PER_MS));
+}
+
+void _delay_us(double us) {
+	board_advance((uint64_t)(us * NS_PER_US));
+}
+
+static uint16_t ee_addr(const void *p) {
+	return (uint16_t)((uintptr_t)p % BOARD_EEPROM_BYTES);
+}
+
+static void ee_wait(void) {
+	if (board.now < eepromReady)
+		board_advance(eepromReady - board.now);
+}
+
+static void ee_write(uint16_t addr, uint8_t value) {
+	ee_wait();
+	board.eeprom[addr % BOARD_EEPROM_BYTES] = value;
+	eepromReady = board.now + EEPROM_WRITE_NS;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *p) {
+	ee_wait();
+	return board.eeprom[ee_addr(p)];
+}
+
+uint16_t eeprom_read_word(const uint16_t *p) {
+	uint16_t a = ee_addr(p);
+	ee_wait();
+	return board.eeprom[a] | board.eeprom[(a + 1) % BOARD_EEPROM_BYTES] << 8;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+	uint16_t a = ee_addr(src);
+	ee_wait();
+	for (size_t i = 0; i < n; i++)
+		((uint8_t *)dst)[i] = board.eeprom[(a + i) % BOARD_EEPROM_BYTES];
+}
+
+void eeprom_write_byte(uint8_t *p, uint8_t value) {
+	ee_write(ee_addr(p), value);
+}
+
+void eeprom_update_byte(uint8_t *p, uint8_t value) {
+	if (eeprom_read_byte(p) != value)
+		ee_write(ee_addr(p), value);
+}
+
+void eeprom_update_word(uint16_t *p, uint16_t value) {
+	eeprom_update_byte((uint8_t *)p, value & 0xFF);
+	eeprom_update_byte((uint8_t *)p + 1, value >> 8);
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t n) {
+	for (size_t i = 0; i < n; i++)
+		eeprom_update_byte((uint8_t *)dst + i, ((const uint8_t *)src)[i]);
+}
+
+int eeprom_is_ready(void) {
+	return board.now >= eepromReady;
+}
+
+/* -------------------------------------------------------------------------
+ *  STDIO
+ * ------------------------------------------------------------------------- */
+/**
+ * Rewrite an avr-libc format for the host C library: avr-libc's int is 16
+ * bits and its long 32, so "%u" stores a uint16_t and "%lu" takes a uint32_t.
+ */
+static const char *host_format(const char *fmt, char *out, size_t n, bool scan) {
+	size_t o = 0;
+	while (*fmt && o + 3 < n) {
+		out[o++] = *fmt;
+		if (*fmt++ != '%')
+			continue;
+		while (*fmt && strchr("-+ #0123456789.*", *fmt) && o + 3 < n)
+			out[o++] = *fmt++;
+
+		uint8_t longs = 0, shorts = 0;
+		while (*fmt == 'l') { longs++; fmt++; }
+		while (*fmt == 'h') { shorts++; fmt++; }
+
+		bool integer = *fmt && strchr("diouxXn", *fmt);
+		if (longs >= 2)
+			out[o++] = 'l', out[o++] = 'l';
+		else if (shorts)
+			for (uint8_t i = 0; i < shorts; i++) out[o++] = 'h';
+		else if (!longs && scan && integer)
+			out[o++] = 'h';
+		if (*fmt)
+			out[o++] = *fmt++;
+	}
+	out[o] = '\0';
+	return out;
+}
+
+static void uart_send(uint8_t c) {
+	if (board.now < board.txStart) {	/* UDR0 is still full: wait for UDRE0 */
+		board.stats.txBlockedNs += board.txStart - board.now;
+		board_advance(board.txStart - board.now);
+	}
+	board.txStart = board.now > board.txEnd ? board.now : board.txEnd;
+	board.txEnd = board.txStart + BOARD_UART_BYTE_NS;
+	board.stats.uartTx++;
+	if (board.txSink)
+		board.txSink(board.txCtx, board.txEnd, c);
+}
+
+/**
+ * printf on the board's UART, with uart_putchar()'s "\n" -> "\r\n".
+ */
+int board_printf(const char *fmt, ...) {
+	char f[128], line[256];
+	va_list ap;
+	va_start(ap, fmt);
+	int len = vsnprintf(line, sizeof(line), host_format(fmt, f, sizeof(f), false), ap);
+	va_end(ap);
+
+	for (const char *c = line; *c; c++) {
+		if (*c == '\n')
+			uart_send('\r');
+		uart_send((uint8_t)*c);
+	}
+	return len;
+}
+
+int board_snprintf(char *buf, size_t n, const char *fmt, ...) {
+	char f[128];
+	va_list ap;
+	va_start(ap, fmt);
+	int len = vsnprintf(buf, n, host_format(fmt, f, sizeof(f), false), ap);
+	va_end(ap);
+	return len;
+}
+
+int board_sscanf(const char *s, const char *fmt, ...) {
+	char f[128];
+	va_list ap;
+	va_start(ap, fmt);
+	int got = vsscanf(s, host_format(fmt, f, sizeof(f), true), ap);
+	va_end(ap);
+	return got;
+}
@@ -0,0 +1,126 @@
+/* ---------------------------------------------------------------------------
+ * board.h - Virtual-time ATmega328P board for the host build
+ *
+ * The board model is linked into the firmware image (see Makefile), so every
+ * simulated board has its own copy of `board` along with the firmware's
+ * globals. Host tools reach the board of the image that is swapped in.
+ *
+ * Time is virtual, in nanoseconds since power-on. Delays, SPI bytes, ADC
+ * conversions and blocked UART writes advance it; nothing waits on the wall
+ * clock. Inputs and received bytes are events that land at their time,
+ * between two firmware statements.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lcd.h"
+
+#define NS_PER_US			1000ULL
+#define NS_PER_MS			1000000ULL
+
+#define BOARD_SPI_BYTE_NS	4500ULL		/* Matches SPI_BYTE_US_X2 in gfx.h */
+#define BOARD_ADC_NS		104000ULL	/* 13 ADC clocks at 125 kHz */
+#define BOARD_UART_BYTE_NS	1041667ULL	/* 10 bits at 9600 baud */
+#define BOARD_UART_RX_DEPTH	3			/* 2-byte receive FIFO plus the shift register */
+#define BOARD_RX_QUEUE		256 		/* Bytes on their way in */
+#define BOARD_EVENTS		32			/* Pending input changes */
+#define BOARD_EEPROM_BYTES	1024
+
+#define BOARD_NEVER			UINT64_MAX
+
+/* Joystick axes and the button at rest */
+#define BOARD_STICK_CENTRE	512
+#define BOARD_STICK_LOW		100
+#define BOARD_STICK_HIGH	923
+
+typedef enum {
+	BOARD_EV_ADC,		/* channel, value */
+	BOARD_EV_BUTTON		/* value: 1 = pressed */
+} BoardEventKind;
+
+typedef struct {
+	uint64_t at;
+	uint8_t	 kind;
+	uint8_t	 channel;
+	uint16_t value;
+} BoardEvent;
+
+typedef struct {
+	uint32_t spiBytes;
+	uint32_t uartTx;			/* Bytes sent */
+	uint32_t uartRx;			/* Bytes read by the firmware */
+	uint32_t uartOverruns;		/* Bytes lost because the firmware read too late */
+	uint32_t adcReads;
+	uint64_t txBlockedNs;		/* Time printf spent waiting for the UART */
+} BoardStats;
+
+/* Sink for transmitted bytes: `at` is when the stop bit ends */
+typedef void (*BoardTxFn)(void *ctx, uint64_t at, uint8_t byte);
+/* Hands the CPU back to whoever runs this board (see instance.c) */
+typedef void (*BoardYieldFn)(void);
+
+typedef struct {
+	uint64_t	now;					/* Virtual time (ns) */
+	uint64_t	horizon;				/* Yield once `now` reaches this */
+	uint64_t	nextDue;				/* Earliest event, interrupt or horizon */
+	BoardYieldFn yield;
+
+	/* Inputs */
+	uint16_t	adc[8];
+	bool		button;
+	BoardEvent	events[BOARD_EVENTS];	/* Sorted by time */
+	uint8_t		eventCount;
+
+	/* UART */
+	struct { uint64_t at; uint8_t byte; } rxq[BOARD_RX_QUEUE];
+	uint16_t	rxHead, rxCount;
+	uint8_t		rxFifo[BOARD_UART_RX_DEPTH];
+	uint8_t		rxFifoCount;
+	uint64_t	txStart;				/* Start bit of the last byte sent */
+	uint64_t	txEnd;					/* Its stop bit's end */
+	BoardTxFn	txSink;
+	void		*txCtx;
+
+	/* SPI */
+	Lcd			*lcd;					/* NULL: bytes are only counted */
+	bool		spiPending;
+	uint8_t		spiLatch;
+	bool		spiData;
+	uint8_t		spiStatus;
+
+	/* Timers */
+	uint64_t	t1Start;				/* When Timer1 (clk/1024) read zero */
+	uint16_t	t1Shown;				/* Last value handed out, to spot writes */
+	uint8_t		t0Shown;
+	uint64_t	t0NextOverflow;
+
+	uint8_t		eeprom[BOARD_EEPROM_BYTES];
+	uint8_t		udrLatch;
+	uint8_t		ucsr0a;
+	uint8_t		adcsra;
+
+	BoardStats	stats;
+} Board;
+
+extern Board board;
+
+/* Power-on: clock at zero, stick centred, button up, EEPROM erased */
+void	 board_power_on(void);
+/* Let `ns` of virtual time pass (the firmware is busy or delaying) */
+void	 board_advance(uint64_t ns);
+/* Recompute when board_advance() must next stop; call after changing `horizon` */
+void	 board_reschedule(void);
+
+/* Input changes at virtual time `at` */
+void	 board_stick_at(uint64_t at, uint8_t channel, uint16_t value);
+void	 board_button_at(uint64_t at, bool pressed);
+/* A byte whose stop bit ends at `at` (non-decreasing); false if the queue is full */
+bool	 board_rx_push(uint64_t at, uint8_t byte);
+
+/* Buzzer frequency (Hz) Timer1 is driving right now, 0 if silent */
+uint16_t board_tone_hz(void);
+
+#endif
@@ -0,0 +1,228 @@
+/* ---------------------------------------------------------------------------
+ * farm.c - Many simulated boards at once, spread over worker processes
+ *
+ *     farm [-m ai|link|bot] [-N boards] [-j workers] [-g games] [-s seed]
+ *          [-n link-spec] [-r scan-chance] [-t think-ms] [-q]
+ *
+ * -N        boards in all (default 16); with -m link they play in pairs
+ * -j        worker processes (default: one per CPU)
+ * -g        games each pilot plays (default 1)
+ * Other options are runner's.
+ *
+ * Every match is its own set of instances, so a worker holds all of its
+ * matches at once and steps them in turn, CHUNK_NS of virtual time each.
+ * Workers are forked rather than threaded: the firmware image is one set of
+ * globals per process (instance.c swaps copies in and out of it), so
+ * processes are how the farm uses more than one core.
+ *
+ * Prints the games played per wall second in all, and the spread of each
+ * board's answer-time p99 (its tail latency) over the farm.
+ * --------------------------------------------------------------------------- */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "instance.h"
+#include "match.h"
+
+#define CHUNK_NS	(50 * NS_PER_MS)	/* Virtual time a match runs before the next one's turn */
+#define MAX_WORKERS	256
+
+/* One board's result, from a worker to the parent */
+typedef struct {
+	uint32_t   match;
+	char	   name;
+	bool	   stalled;
+	uint64_t   virtNs;
+	PilotStats stats;
+	BoardStats board;
+} BoardResult;
+
+static double seconds(const struct timespec *a, const struct timespec *b) {
+	return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static int by_value(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static bool write_all(int fd, const void *buf, size_t len) {
+	const char *p = buf;
+	while (len) {
+		ssize_t n = write(fd, p, len);
+		if (n <= 0)
+			return false;
+		p += n;
+		len -= (size_t)n;
+	}
+	return true;
+}
+
+/**
+ * Play matches first, first + step, ... to the end and send each board's
+ * result down `fd`.
+ */
+static int worker(const MatchConfig *base, uint32_t first, uint32_t count, uint32_t step, int fd) {
+	uint32_t n = first < count ? (count - first + step - 1) / step : 0;
+	Match *matches = calloc(n ? n : 1, sizeof(Match));
+	bool *running = calloc(n ? n : 1, sizeof(bool));
+
+	for (uint32_t i = 0; i < n; i++) {
+		MatchConfig cfg = *base;
+		cfg.seed = base->seed + first + i * step;
+		match_init(&matches[i], &cfg);
+		running[i] = true;
+	}
+
+	for (uint32_t left = n; left;) {
+		for (uint32_t i = 0; i < n; i++) {
+			if (!running[i])
+				continue;
+			uint64_t until = match_now(&matches[i]) + CHUNK_NS;
+			while ((running[i] = match_step(&matches[i])) && match_now(&matches[i]) < until)
+				;
+			if (!running[i])
+				left--;
+		}
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		Match *m = &matches[i];
+		for (uint8_t k = 0; k < m->nodeCount; k++) {
+			Node *node = &m->nodes[k];
+			instance_enter(node->in);
+			BoardResult r = {
+				.match = first + i * step, .name = node->name, .stalled = m->stalled,
+				.virtNs = instance_now(node->in), .stats = node->pilot.stats, .board = board.stats
+			};
+			if (!write_all(fd, &r, sizeof(r)))
+				return 1;
+		}
+		match_free(m);
+	}
+	free(matches);
+	free(running);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	MatchConfig cfg = { .mode = MATCH_AI, .games = 1, .seed = 1, .scanChance = 0.1 };
+	uint32_t boards = 16;
+	long workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+	int opt;
+	while ((opt = getopt(argc, argv, "m:N:j:g:s:n:r:t:q")) != -1) {
+		switch (opt) {
+			case 'm':
+				cfg.mode = !strcmp(optarg, "link") ? MATCH_LINK : !strcmp(optarg, "bot") ? MATCH_BOT : MATCH_AI;
+				break;
+			case 'N': boards = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 'j': workers = strtol(optarg, NULL, 0); break;
+			case 'g': cfg.games = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 's': cfg.seed = strtoull(optarg, NULL, 0); break;
+			case 'n':
+				if (!link_parse(&cfg.model, optarg)) {
+					fprintf(stderr, "bad link spec: %s\n", optarg);
+					return 2;
+				}
+				break;
+			case 'r': cfg.scanChance = atof(optarg); break;
+			case 't': cfg.thinkNs = (uint64_t)(atof(optarg) * NS_PER_MS); break;
+			case 'q': cfg.mute = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-m ai|link|bot] [-N boards] [-j workers] [-g games] [-s seed] [-n link-spec] [-r scan-chance] [-t think-ms] [-q]\n", argv[0]);
+				return 2;
+		}
+	}
+	uint32_t perMatch = cfg.mode == MATCH_LINK ? 2 : 1;
+	uint32_t count = (boards + perMatch - 1) / perMatch;
+	if (workers < 1)
+		workers = 1;
+	if (workers > MAX_WORKERS)
+		workers = MAX_WORKERS;
+	if (workers > (long)count)
+		workers = count;
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	int fds[MAX_WORKERS];
+	pid_t pids[MAX_WORKERS];
+	for (long w = 0; w < workers; w++) {
+		int p[2];
+		if (pipe(p) < 0) {
+			perror("pipe");
+			return 1;
+		}
+		fflush(stdout);
+		pids[w] = fork();
+		if (pids[w] < 0) {
+			perror("fork");
+			return 1;
+		}
+		if (!pids[w]) {
+			close(p[0]);
+			for (long k = 0; k < w; k++)
+				close(fds[k]);
+			_exit(worker(&cfg, (uint32_t)w, count, (uint32_t)workers, p[1]));
+		}
+		close(p[1]);
+		fds[w] = p[0];
+	}
+
+	/* Gather every board's result; a worker that dies short is reported */
+	uint32_t total = count * perMatch, got = 0, stalled = 0;
+	uint32_t *p99 = calloc(total, sizeof(uint32_t));
+	PilotStats sum = { 0 };
+	uint64_t virt = 0, overruns = 0;
+	for (long w = 0; w < workers; w++) {
+		BoardResult r;
+		FILE *in = fdopen(fds[w], "r");
+		while (fread(&r, sizeof(r), 1, in) == 1 && got < total) {
+			pilot_stats_add(&sum, &r.stats);
+			p99[got++] = pilot_answer_ms(&r.stats, 99);
+			stalled += r.stalled;
+			overruns += r.board.uartOverruns;
+			virt += r.virtNs;
+		}
+		fclose(in);
+	}
+	bool failed = false;
+	for (long w = 0; w < workers; w++) {
+		int status;
+		if (waitpid(pids[w], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+			failed = true;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	struct rusage ru;
+	getrusage(RUSAGE_CHILDREN, &ru);
+	double wall = seconds(&t0, &t1);
+	uint32_t played = perMatch == 2 ? sum.games / 2 : sum.games;
+	qsort(p99, got, sizeof(uint32_t), by_value);
+
+	printf("farm: boards=%u matches=%u workers=%ld image=%zu bytes/board peak-rss=%ld KiB/worker\n",
+		   got, count, workers, instance_image_bytes(), ru.ru_maxrss);
+	printf("games=%u aborted=%u shots=%u stalled=%u overruns=%lu answer p50<=%ums p99<=%ums\n",
+		   played, sum.aborted, sum.shots, stalled, (unsigned long)overruns,
+		   pilot_answer_ms(&sum, 50), pilot_answer_ms(&sum, 99));
+	if (got)
+		printf("per-board answer p99: median<=%ums p99<=%ums worst<=%ums\n",
+			   p99[got / 2], p99[(got * 99) / 100 < got ? (got * 99) / 100 : got - 1], p99[got - 1]);
+	printf("%u games in %.1f wall s: %.1f games/s, %.0f virtual board-s per wall s\n",
+		   played, wall, played / wall, virt / 1e9 / wall);
+	free(p99);
+
+	if (got != total || failed) {
+		fprintf(stderr, "farm: %u of %u boards reported\n", got, total);
+		return 1;
+	}
+	return stalled ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+/* ---------------------------------------------------------------------------
+ * avr/interrupt.h - Interrupts on the host build
+ *
+ * The board model calls a vector from its clock, between two firmware
+ * register accesses, while the I bit in SREG is set.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define ISR(vector)		void vector(void)
+#define sei()			(SREG |= 1 << SREG_I)
+#define cli()			(SREG &= ~(1 << SREG_I))
+
+#endif
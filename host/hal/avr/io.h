@@ -0,0 +1,96 @@
+/* ---------------------------------------------------------------------------
+ * avr/io.h - ATmega328P registers for the host build
+ *
+ * Plain registers are variables in the board model (board.c). Registers with
+ * side effects (SPI data/status, UART, ADC start, timer counters) are
+ * accessor calls that step the model's virtual clock.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+extern volatile uint8_t DDRB, PORTB, PINB, DDRC, PORTC, PINC, DDRD, PORTD, PIND;
+extern volatile uint8_t SPCR, ADMUX, DIDR0, UBRR0H, UBRR0L, UCSR0B, UCSR0C;
+extern volatile uint8_t TCCR0A, TCCR0B, TIMSK0, TIFR0, OCR0A, TCCR1A, TCCR1B, TIFR1;
+extern volatile uint8_t SREG, MCUSR;
+extern volatile uint16_t ADC, ICR1, OCR1B;
+
+volatile uint8_t  *board_spdr(void);
+volatile uint8_t  *board_spsr(void);
+volatile uint8_t  *board_ucsr0a(void);
+volatile uint8_t  *board_udr0(void);
+volatile uint8_t  *board_adcsra(void);
+volatile uint8_t  *board_tcnt0(void);
+volatile uint16_t *board_tcnt1(void);
+
+#define SPDR	(*board_spdr())
+#define SPSR	(*board_spsr())
+#define UCSR0A	(*board_ucsr0a())
+#define UDR0	(*board_udr0())			/* Read only: transmit goes through printf */
+#define ADCSRA	(*board_adcsra())
+#define TCNT0	(*board_tcnt0())
+#define TCNT1	(*board_tcnt1())
+
+#define E2END	0x3FF
+
+/* PORTB / PORTD */
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PD0 0
+#define PD1 1
+#define PD2 2
+
+/* SPI */
+#define SPIF	7
+#define SPE		6
+#define MSTR	4
+#define SPR1	1
+#define SPR0	0
+#define SPI2X	0
+
+/* ADC */
+#define REFS0	6
+#define ADEN	7
+#define ADSC	6
+#define ADPS2	2
+#define ADPS1	1
+#define ADPS0	0
+#define ADC0D	0
+#define ADC1D	1
+
+/* USART0 */
+#define RXC0	7
+#define UDRE0	5
+#define RXCIE0	7
+#define UDRIE0	5
+#define RXEN0	4
+#define TXEN0	3
+#define UCSZ01	2
+#define UCSZ00	1
+
+/* Timer0 */
+#define WGM01	1
+#define CS01	1
+#define CS00	0
+#define TOIE0	0
+#define OCIE0A	1
+#define TOV0	0
+#define SREG_I	7
+#define OCF0A	1
+
+/* Timer1 */
+#define COM1B1	5
+#define WGM11	1
+#define WGM13	4
+#define WGM12	3
+#define CS12	2
+#define CS11	1
+#define CS10	0
+#define TOV1	0
+
+#endif
@@ -0,0 +1,27 @@
+/* ---------------------------------------------------------------------------
+ * avrlibc.h - Forced into every firmware file of the host build (-include)
+ *
+ * stdio goes through the board model: printf bytes leave on its UART, and
+ * the formats are read the avr-libc way (int is 16 bits, long is 32).
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_AVRLIBC_H
+#define HOST_AVRLIBC_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+int board_printf(const char *fmt, ...);
+int board_snprintf(char *buf, size_t n, const char *fmt, ...);
+int board_sscanf(const char *s, const char *fmt, ...);
+
+extern FILE *board_stdout;
+
+#define printf				board_printf
+#define snprintf			board_snprintf
+#define sscanf				board_sscanf
+#undef stdout
+#define stdout				board_stdout
+#define FDEV_SETUP_STREAM(put, get, flags)	{ 0 }
+#define _FDEV_SETUP_WRITE	0
+
+#endif
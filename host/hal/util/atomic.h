@@ -0,0 +1,18 @@
+/* ---------------------------------------------------------------------------
+ * util/atomic.h - Atomic blocks on the host build
+ *
+ * The block clears the I bit, so the board model holds its vectors back, and
+ * puts SREG back on the way out (both types restore; none of the firmware
+ * leaves a block by jumping out of it).
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include <avr/interrupt.h>
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) \
+	for (uint8_t _sreg = SREG, _atomic = (cli(), 1); _atomic; SREG = _sreg, _atomic = 0)
+
+#endif
@@ -0,0 +1,10 @@
+/* ---------------------------------------------------------------------------
+ * util/delay.h - Delays advance the board's virtual clock
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+void _delay_ms(double ms);
+void _delay_us(double us);
+
+#endif
@@ -0,0 +1,122 @@
+/* ---------------------------------------------------------------------------
+ * instance.c - Many simulated boards in one process
+ * --------------------------------------------------------------------------- */
+#include "instance.h"
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+/* The firmware image's data, renamed by the Makefile (objcopy) */
+extern char __start_fw_data[], __stop_fw_data[];
+extern char __start_fw_bss[], __stop_fw_bss[];
+
+int fw_main(void);		/* The firmware's main(), renamed */
+
+#define STACK_BYTES		(256 * 1024)
+
+struct Instance {
+	char		*data;			/* Saved fw_data while not live */
+	char		*bss;			/* Saved fw_bss */
+	uint64_t	now;
+	ucontext_t	start;			/* First entry into fw_main() */
+	jmp_buf		firmware;		/* Where the firmware yielded */
+	jmp_buf		host;			/* Where instance_run() resumes */
+	bool		started;
+	void		*stack;
+};
+
+static char		*pristine;		/* fw_data as loaded, before any firmware ran */
+static Instance *live;
+static Instance *running;
+
+static size_t data_bytes(void)	{ return (size_t)(__stop_fw_data - __start_fw_data); }
+static size_t bss_bytes(void)	{ return (size_t)(__stop_fw_bss - __start_fw_bss); }
+
+size_t instance_image_bytes(void) {
+	return data_bytes() + bss_bytes();
+}
+
+/**
+ * Back to instance_run(); returns when the instance is run again.
+ */
+static void yield(void) {
+	Instance *in = running;
+	if (!_setjmp(in->firmware))
+		_longjmp(in->host, 1);
+}
+
+static void entry(void) {
+	fw_main();
+	abort();			/* main() never returns */
+}
+
+Instance *instance_new(void) {
+	if (!pristine) {
+		pristine = malloc(data_bytes());
+		memcpy(pristine, __start_fw_data, data_bytes());
+	}
+
+	Instance *in = calloc(1, sizeof(*in));
+	in->data = malloc(data_bytes());
+	in->bss = calloc(1, bss_bytes());
+	memcpy(in->data, pristine, data_bytes());
+	in->stack = malloc(STACK_BYTES);
+
+	getcontext(&in->start);
+	in->start.uc_stack.ss_sp = in->stack;
+	in->start.uc_stack.ss_size = STACK_BYTES;
+	in->start.uc_link = NULL;
+	makecontext(&in->start, entry, 0);
+
+	/* Power the board on inside its own image */
+	instance_enter(in);
+	board_power_on();
+	board.yield = yield;
+	return in;
+}
+
+void instance_free(Instance *in) {
+	if (live == in)
+		live = NULL;
+	free(in->data);
+	free(in->bss);
+	free(in->stack);
+	free(in);
+}
+
+void instance_enter(Instance *in) {
+	if (live == in)
+		return;
+	if (live) {
+		memcpy(live->data, __start_fw_data, data_bytes());
+		memcpy(live->bss, __start_fw_bss, bss_bytes());
+	}
+	memcpy(__start_fw_data, in->data, data_bytes());
+	memcpy(__start_fw_bss, in->bss, bss_bytes());
+	live = in;
+}
+
+void instance_run(Instance *in, uint64_t until) {
+	instance_enter(in);
+	board.horizon = until;
+	board_reschedule();
+	running = in;
+
+	if (!_setjmp(in->host)) {
+		if (!in->started) {
+			in->started = true;
+			ucontext_t here;
+			swapcontext(&here, &in->start);		/* Comes back through _longjmp */
+		} else {
+			_longjmp(in->firmware, 1);
+		}
+	}
+	running = NULL;
+	in->now = board.now;
+}
+
+uint64_t instance_now(const Instance *in) {
+	return in->now;
+}
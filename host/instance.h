@@ -0,0 +1,39 @@
+/* ---------------------------------------------------------------------------
+ * instance.h - Many simulated boards in one process
+ *
+ * Each instance is a copy of the firmware image's writable data (every
+ * firmware global plus its `board`) and a coroutine running the firmware's
+ * main(). Only one image is live at a time: instance_enter() copies the live
+ * one out and the next one in, so the firmware runs unmodified.
+ *
+ * An instance runs until its virtual clock reaches the horizon it was given
+ * and then yields, between two firmware statements if need be (inside a
+ * redraw, a blocking sound, a button-hold loop). A scheduler that always
+ * runs the instance furthest behind, up to the others' clocks plus the link
+ * latency, never delivers a byte into an instance's past.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_INSTANCE_H
+#define HOST_INSTANCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "board.h"
+
+typedef struct Instance Instance;
+
+/* A powered-on board whose firmware starts at main() on its first run */
+Instance *instance_new(void);
+void	  instance_free(Instance *in);
+
+/* Make `in` the live image (board, game, ...); no-op if it already is */
+void	  instance_enter(Instance *in);
+/* Run the firmware until the virtual clock reaches `until`; leaves `in` live */
+void	  instance_run(Instance *in, uint64_t until);
+/* Virtual clock of `in` as of its last yield */
+uint64_t  instance_now(const Instance *in);
+
+/* Bytes of state each instance carries */
+size_t	  instance_image_bytes(void);
+
+#endif
@@ -0,0 +1,32 @@
+/* ---------------------------------------------------------------------------
+ * latency.c - Latency histograms for the host tools
+ * --------------------------------------------------------------------------- */
+#include "latency.h"
+#include "board.h"
+
+void latency_add(Latency *l, uint64_t ns) {
+	l->n++;
+	l->sumNs += ns;
+	if (ns > l->maxNs)
+		l->maxNs = ns;
+	uint8_t b = 0;
+	while (b < LATENCY_BUCKETS - 1 && ns > (NS_PER_MS << b))
+		b++;
+	l->hist[b]++;
+}
+
+uint32_t latency_ms(const Latency *l, uint8_t pct) {
+	uint32_t need = (l->n * pct + 99) / 100, seen = 0;
+	for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+		seen += l->hist[b];
+		if (seen >= need)
+			return 1u << b;
+	}
+	return 1u << (LATENCY_BUCKETS - 1);
+}
+
+void latency_print(FILE *out, const char *name, const Latency *l) {
+	fprintf(out, " %s avg=%.1fms p50<=%ums p99<=%ums max=%.1fms", name,
+			l->n ? (double)l->sumNs / l->n / 1e6 : 0.0,
+			latency_ms(l, 50), latency_ms(l, 99), (double)l->maxNs / 1e6);
+}
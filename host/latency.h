@@ -0,0 +1,27 @@
+/* ---------------------------------------------------------------------------
+ * latency.h - Latency histograms for the host tools
+ *
+ * Power-of-two buckets from 1 ms, so percentiles come out as bucket bounds
+ * ("p99<=256ms"), plus an exact count, sum and maximum.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_LATENCY_H
+#define HOST_LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LATENCY_BUCKETS	16
+
+typedef struct {
+	uint32_t n;
+	uint64_t sumNs, maxNs;
+	uint32_t hist[LATENCY_BUCKETS];
+} Latency;
+
+void	 latency_add(Latency *l, uint64_t ns);
+/* Percentile (0..100), as a bucket bound in ms */
+uint32_t latency_ms(const Latency *l, uint8_t pct);
+/* " <name> avg=..ms p50<=..ms p99<=..ms max=..ms" */
+void	 latency_print(FILE *out, const char *name, const Latency *l);
+
+#endif
@@ -0,0 +1,171 @@
+/* ---------------------------------------------------------------------------
+ * lcd.c - ILI9341 display model for the host build
+ * --------------------------------------------------------------------------- */
+#include "lcd.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define CMD_DISPLAY_ON	0x29
+#define CMD_COLUMN_SET	0x2A
+#define CMD_PAGE_SET	0x2B
+#define CMD_MEMORY_WRITE 0x2C
+#define CMD_MADCTL		0x36
+#define CMD_WRITE_MORE	0x3C
+
+#define MADCTL_MY		0x80
+#define MADCTL_MX		0x40
+#define MADCTL_MV		0x20
+
+/**
+ * Power-on state: black frame, portrait MADCTL, statistics cleared.
+ */
+void lcd_reset(Lcd *lcd) {
+	LcdPixelFn onPixel = lcd->onPixel;
+	void *user = lcd->user;
+	memset(lcd, 0, sizeof(*lcd));
+	lcd->onPixel = onPixel;
+	lcd->user = user;
+	lcd->colEnd = 239;
+	lcd->pageEnd = 319;
+}
+
+void lcd_clear_stats(Lcd *lcd) {
+	memset(&lcd->stats, 0, sizeof(lcd->stats));
+}
+
+/**
+ * Map the write pointer (column, page in memory order) to a screen pixel.
+ * The panel is mounted so that MADCTL 0x28 (MV | BGR) is landscape with the
+ * origin top left.
+ */
+static bool to_screen(const Lcd *lcd, uint16_t col, uint16_t page, int *x, int *y) {
+	uint8_t m = lcd->madctl;
+	int u, v;	/* u: 0..239 across, v: 0..319 down the portrait panel */
+
+	if (m & MADCTL_MV) {
+		if (col >= 320 || page >= 240) return false;
+		u = (m & MADCTL_MX) ? page : 239 - page;
+		v = (m & MADCTL_MY) ? 319 - col : col;
+	} else {
+		if (col >= 240 || page >= 320) return false;
+		u = (m & MADCTL_MX) ? col : 239 - col;
+		v = (m & MADCTL_MY) ? 319 - page : page;
+	}
+	*x = v;
+	*y = 239 - u;
+	return true;
+}
+
+static void put_pixel(Lcd *lcd, uint16_t colour) {
+	int x, y;
+	if (to_screen(lcd, lcd->col, lcd->page, &x, &y)) {
+		if (lcd->onPixel)
+			lcd->onPixel(lcd, x, y, colour);
+		if (lcd->frame[y][x] == colour)
+			lcd->stats.rewrites++;
+		lcd->frame[y][x] = colour;
+		lcd->stats.pixels++;
+	} else {
+		lcd->stats.outside++;
+	}
+
+	if (++lcd->col > lcd->colEnd) {
+		lcd->col = lcd->colStart;
+		if (++lcd->page > lcd->pageEnd)
+			lcd->page = lcd->pageStart;
+	}
+}
+
+/**
+ * Take one SPI byte; `data` is the DC line (high = parameter or pixel data).
+ */
+void lcd_byte(Lcd *lcd, uint8_t value, bool data) {
+	lcd->stats.bytes++;
+
+	if (!data) {
+		lcd->stats.commands++;
+		lcd->cmd = value;
+		lcd->arg = 0;
+		lcd->haveHigh = false;
+		if (value == CMD_MEMORY_WRITE) {
+			lcd->col = lcd->colStart;
+			lcd->page = lcd->pageStart;
+		} else if (value == CMD_COLUMN_SET) {
+			lcd->stats.windows++;
+		} else if (value == CMD_DISPLAY_ON) {
+			lcd->displayOn = true;
+		}
+		return;
+	}
+
+	uint8_t i = lcd->arg < 255 ? lcd->arg++ : 255;
+	switch (lcd->cmd) {
+		case CMD_COLUMN_SET:
+			if		(i == 0) lcd->colStart = value << 8;
+			else if (i == 1) lcd->colStart |= value;
+			else if (i == 2) lcd->colEnd = value << 8;
+			else if (i == 3) lcd->colEnd |= value;
+			break;
+		case CMD_PAGE_SET:
+			if		(i == 0) lcd->pageStart = value << 8;
+			else if (i == 1) lcd->pageStart |= value;
+			else if (i == 2) lcd->pageEnd = value << 8;
+			else if (i == 3) lcd->pageEnd |= value;
+			break;
+		case CMD_MADCTL:
+			if (i == 0) lcd->madctl = value;
+			break;
+		case CMD_MEMORY_WRITE:
+		case CMD_WRITE_MORE:
+			if (!lcd->haveHigh) {
+				lcd->high = value;
+				lcd->haveHigh = true;
+			} else {
+				lcd->haveHigh = false;
+				put_pixel(lcd, (uint16_t)(lcd->high << 8 | value));
+			}
+			break;
+		default:
+			break;		/* Power, gamma and timing setup: nothing to model */
+	}
+}
+
+/**
+ * Save the frame as a binary PPM (P6, 8 bits per channel).
+ */
+bool lcd_write_ppm(const Lcd *lcd, const char *path) {
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return false;
+	fprintf(f, "P6\n%d %d\n255\n", LCD_W, LCD_H);
+	for (int y = 0; y < LCD_H; y++) {
+		for (int x = 0; x < LCD_W; x++) {
+			uint16_t c = lcd->frame[y][x];
+			uint8_t rgb[3] = { lcd_red(c), lcd_green(c), lcd_blue(c) };
+			fwrite(rgb, 1, 3, f);
+		}
+	}
+	return fclose(f) == 0;
+}
+
+/**
+ * Load a PPM written by lcd_write_ppm() back into RGB565.
+ */
+bool lcd_read_ppm(uint16_t frame[LCD_H][LCD_W], const char *path) {
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return false;
+	int w, h, max;
+	bool ok = fscanf(f, "P6 %d %d %d", &w, &h, &max) == 3 && w == LCD_W && h == LCD_H && max == 255
+		   && fgetc(f) != EOF;
+	for (int y = 0; ok && y < LCD_H; y++) {
+		for (int x = 0; ok && x < LCD_W; x++) {
+			uint8_t rgb[3];
+			ok = fread(rgb, 1, 3, f) == 3;
+			frame[y][x] = (uint16_t)((rgb[0] >> 3) << 11 | (rgb[1] >> 2) << 5 | rgb[2] >> 3);
+		}
+	}
+	fclose(f);
+	return ok;
+}
@@ -0,0 +1,58 @@
+/* ---------------------------------------------------------------------------
+ * lcd.h - ILI9341 display model for the host build
+ *
+ * Decodes the SPI byte stream the firmware sends (column/page address, memory
+ * write, MADCTL) into a 320x240 RGB565 frame in screen orientation, and
+ * counts what it costs.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_LCD_H
+#define HOST_LCD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LCD_W		320
+#define LCD_H		240
+
+typedef struct Lcd Lcd;
+
+/* Called for every pixel written, before the frame changes */
+typedef void (*LcdPixelFn)(Lcd *lcd, int x, int y, uint16_t colour);
+
+typedef struct {
+	uint32_t bytes;			/* SPI bytes */
+	uint32_t commands;		/* Command bytes (DC low) */
+	uint32_t windows;		/* Column address sets */
+	uint32_t pixels;		/* Pixels written */
+	uint32_t rewrites;		/* Pixels written with the colour they already had */
+	uint32_t outside;		/* Pixels written outside the panel */
+} LcdStats;
+
+struct Lcd {
+	uint16_t	frame[LCD_H][LCD_W];	/* What the panel shows */
+	LcdStats	stats;
+	LcdPixelFn	onPixel;				/* Optional */
+	void		*user;
+	/* Controller state */
+	uint8_t		madctl;
+	uint8_t		cmd;
+	uint8_t		arg;					/* Parameter bytes seen since the command */
+	uint16_t	colStart, colEnd, pageStart, pageEnd;
+	uint16_t	col, page;				/* Write pointer */
+	uint8_t		high;					/* First byte of a pixel */
+	bool		haveHigh;
+	bool		displayOn;
+};
+
+void lcd_reset(Lcd *lcd);
+void lcd_byte(Lcd *lcd, uint8_t value, bool data);
+void lcd_clear_stats(Lcd *lcd);
+bool lcd_write_ppm(const Lcd *lcd, const char *path);
+bool lcd_read_ppm(uint16_t frame[LCD_H][LCD_W], const char *path);
+
+/* RGB565 to 8-bit channels, as the panel shows them */
+static inline uint8_t lcd_red(uint16_t c)	{ return (uint8_t)(((c >> 11) & 0x1F) << 3); }
+static inline uint8_t lcd_green(uint16_t c)	{ return (uint8_t)(((c >> 5) & 0x3F) << 2); }
+static inline uint8_t lcd_blue(uint16_t c)	{ return (uint8_t)((c & 0x1F) << 3); }
+
+#endif
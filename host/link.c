@@ -0,0 +1,108 @@
+/* ---------------------------------------------------------------------------
+ * link.c - One direction of a simulated serial link
+ * --------------------------------------------------------------------------- */
+#include "link.h"
+#include "board.h"
+#include "rng.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void link_init(Link *l, const LinkModel *model, uint64_t seed) {
+	memset(l, 0, sizeof(*l));
+	l->model = *model;
+	l->rng = seed;
+	l->cap = 256;
+	l->queue = malloc(l->cap * sizeof(*l->queue));
+	l->lineStart = true;
+}
+
+void link_free(Link *l) {
+	free(l->queue);
+	l->queue = NULL;
+}
+
+void link_send(void *ctx, uint64_t at, uint8_t byte) {
+	Link *l = ctx;
+	l->stats.bytes++;
+
+	if (l->lineStart) {
+		l->stats.lines++;
+		l->dropLine = rng_chance(&l->rng, l->model.lineLoss);
+		if (l->dropLine)
+			l->stats.linesLost++;
+		l->lineJitter = l->model.jitterNs ? rng_next(&l->rng) % (l->model.jitterNs + 1) : 0;
+	}
+	l->lineStart = byte == '\n';
+	if (l->dropLine)
+		return;
+	if (rng_chance(&l->rng, l->model.byteLoss)) {
+		l->stats.bytesLost++;
+		return;
+	}
+	if (rng_chance(&l->rng, l->model.corruption)) {
+		byte ^= (uint8_t)(1 << rng_below(&l->rng, 8));
+		l->stats.bytesCorrupted++;
+	}
+
+	/* In order, and no faster than the far UART's baud rate */
+	at += l->model.latencyNs + l->lineJitter;
+	if (at < l->lastAt + BOARD_UART_BYTE_NS)
+		at = l->lastAt + BOARD_UART_BYTE_NS;
+	l->lastAt = at;
+
+	if (l->count == l->cap) {
+		uint32_t cap = l->cap * 2;
+		typeof(l->queue) q = malloc(cap * sizeof(*q));
+		for (uint32_t i = 0; i < l->count; i++)
+			q[i] = l->queue[(l->head + i) % l->cap];
+		free(l->queue);
+		l->queue = q;
+		l->cap = cap;
+		l->head = 0;
+	}
+	uint32_t tail = (l->head + l->count++) % l->cap;
+	l->queue[tail].at = at;
+	l->queue[tail].byte = byte;
+}
+
+bool link_peek(const Link *l, uint64_t *at) {
+	if (!l->count)
+		return false;
+	*at = l->queue[l->head].at;
+	return true;
+}
+
+uint8_t link_pop(Link *l, uint64_t *at) {
+	uint8_t byte = l->queue[l->head].byte;
+	if (at)
+		*at = l->queue[l->head].at;
+	l->head = (l->head + 1) % l->cap;
+	l->count--;
+	return byte;
+}
+
+uint64_t link_lookahead(const LinkModel *model) {
+	return BOARD_UART_BYTE_NS + model->latencyNs;
+}
+
+bool link_parse(LinkModel *model, const char *spec) {
+	char buf[256];
+	strncpy(buf, spec, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+
+	for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+		char *eq = strchr(tok, '=');
+		if (!eq)
+			return false;
+		*eq = '\0';
+		double v = atof(eq + 1);
+		if		(!strcmp(tok, "latency"))	model->latencyNs = (uint64_t)(v * NS_PER_MS);
+		else if (!strcmp(tok, "jitter"))	model->jitterNs = (uint64_t)(v * NS_PER_MS);
+		else if (!strcmp(tok, "lineloss"))	model->lineLoss = v;
+		else if (!strcmp(tok, "byteloss"))	model->byteLoss = v;
+		else if (!strcmp(tok, "corrupt"))	model->corruption = v;
+		else return false;
+	}
+	return true;
+}
@@ -0,0 +1,55 @@
+/* ---------------------------------------------------------------------------
+ * link.h - One direction of a simulated serial link
+ *
+ * Bytes leave a board's UART with the time their stop bit ends, and reach
+ * the other end after a latency, in order and at most at the baud rate.
+ * Lines can be delayed or lost whole, and single bytes lost or hit by a
+ * flipped bit.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_LINK_H
+#define HOST_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	uint64_t latencyNs;		/* Added to every byte */
+	uint64_t jitterNs;		/* Up to this much more per line, uniformly (order is kept) */
+	double	 lineLoss;		/* Chance a line is lost whole */
+	double	 byteLoss;		/* Chance a byte is lost */
+	double	 corruption;	/* Chance a byte arrives with one bit flipped */
+} LinkModel;
+
+typedef struct {
+	uint32_t bytes;			/* Bytes sent into the link */
+	uint32_t lines;
+	uint32_t linesLost;
+	uint32_t bytesLost;
+	uint32_t bytesCorrupted;
+} LinkStats;
+
+typedef struct {
+	LinkModel model;
+	LinkStats stats;
+	uint64_t  rng;
+	struct { uint64_t at; uint8_t byte; } *queue;
+	uint32_t  cap, head, count;
+	uint64_t  lastAt;		/* Latest arrival queued */
+	uint64_t  lineJitter;	/* Extra delay of the current line */
+	bool	  lineStart;	/* The next byte starts a line */
+	bool	  dropLine;		/* The current line is being lost */
+} Link;
+
+void	 link_init(Link *l, const LinkModel *model, uint64_t seed);
+void	 link_free(Link *l);
+/* Board tx sink: `ctx` is the Link */
+void	 link_send(void *ctx, uint64_t at, uint8_t byte);
+/* Next byte's arrival time, false if none is on the way */
+bool	 link_peek(const Link *l, uint64_t *at);
+uint8_t	 link_pop(Link *l, uint64_t *at);
+/* Shortest time from a byte's start bit to its arrival */
+uint64_t link_lookahead(const LinkModel *model);
+/* Parse "latency=MS,jitter=MS,lineloss=P,byteloss=P,corrupt=P" (any subset) */
+bool	 link_parse(LinkModel *model, const char *spec);
+
+#endif
@@ -0,0 +1,170 @@
+/* ---------------------------------------------------------------------------
+ * match.c - One game setup: a board against its AI, another board or the bot
+ * --------------------------------------------------------------------------- */
+#include "match.h"
+#include "board.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern bool soundsEnabled;
+
+#define SLICE_NS		NS_PER_MS					/* Longest run between two pilot steps */
+#define STALL_NS		(600ULL * 1000 * NS_PER_MS)
+#define SCRIPT_TAIL_NS	(5000 * NS_PER_MS)			/* Run on after a script's last step */
+
+/**
+ * Board tx sink: feed the link, and print whole lines or hand them to onLine.
+ */
+static void on_tx(void *ctx, uint64_t at, uint8_t byte) {
+	Node *n = ctx;
+	link_send(&n->out, at, byte);
+	if ((!n->echo && !n->onLine) || byte == '\r')
+		return;
+	if (byte != '\n' && n->lineLen < sizeof(n->line) - 1) {
+		n->line[n->lineLen++] = (char)byte;
+		return;
+	}
+	n->line[n->lineLen] = '\0';
+	if (n->echo)
+		printf("%10.3f %c> %s\n", (double)at / NS_PER_MS, n->name, n->line);
+	if (n->onLine)
+		n->onLine(n->user, n, n->line);
+	n->lineLen = 0;
+}
+
+/**
+ * Move every byte on the way into the live board's receive queue.
+ */
+static void deliver(Link *l) {
+	uint64_t at;
+	while (link_peek(l, &at) && board_rx_push(at, l->queue[l->head].byte))
+		link_pop(l, NULL);
+}
+
+/**
+ * Hand the bot what board A sent up to `now`, then let it answer and move.
+ */
+static void bot_step(Match *m, uint64_t now) {
+	uint64_t at;
+	while (link_peek(&m->nodes[0].out, &at) && at <= now) {
+		uint8_t byte = link_pop(&m->nodes[0].out, &at);
+		peer_rx(&m->bot, at, byte);
+	}
+	peer_poll(&m->bot, now);
+}
+
+void match_init(Match *m, const MatchConfig *cfg) {
+	memset(m, 0, sizeof(*m));
+	m->mode = cfg->mode;
+	m->nodeCount = cfg->mode == MATCH_LINK ? 2 : 1;
+	m->lookahead = link_lookahead(&cfg->model);
+
+	for (uint8_t i = 0; i < m->nodeCount; i++) {
+		Node *n = &m->nodes[i];
+		n->name = 'A' + i;
+		n->echo = cfg->echo;
+		n->onLine = cfg->onLine;
+		n->user = cfg->user;
+		n->in = instance_new();
+		link_init(&n->out, &cfg->model, cfg->seed * 1000003 + i);
+		pilot_init(&n->pilot, cfg->mode == MATCH_AI, cfg->games, cfg->seed * 7919 + i);
+		n->pilot.scanChance = cfg->scanChance;
+		n->pilot.lastProgress = 0;
+
+		board.txSink = on_tx;
+		board.txCtx = n;
+		board.adc[3] = 300 + (cfg->seed * 131 + i * 17) % 400;	/* Floating inputs seed the firmware's RNG */
+		board.adc[4] = 300 + (cfg->seed * 71 + i * 29) % 400;
+		if (cfg->mute)
+			soundsEnabled = false;
+		if (cfg->display) {
+			n->lcd = calloc(1, sizeof(Lcd));
+			lcd_reset(n->lcd);
+			board.lcd = n->lcd;
+		}
+	}
+	if (cfg->mode == MATCH_BOT) {
+		PeerConfig peer = { .thinkNs = cfg->thinkNs, .scanChance = cfg->scanChance, .piggyback = true, .radar = true };
+		link_init(&m->botOut, &cfg->model, cfg->seed * 1000003 + 1);
+		peer_init(&m->bot, &peer, cfg->seed * 7919 + 1, link_send, &m->botOut);
+	}
+}
+
+void match_free(Match *m) {
+	for (uint8_t i = 0; i < m->nodeCount; i++) {
+		Node *n = &m->nodes[i];
+		instance_free(n->in);
+		link_free(&n->out);
+		free(n->lcd);
+		if (n->scripted)
+			script_free(&n->script);
+	}
+	if (m->mode == MATCH_BOT)
+		link_free(&m->botOut);
+}
+
+void match_script(Match *m, const Script *s) {
+	Node *n = &m->nodes[0];
+	n->script = *s;
+	n->scripted = true;
+	n->pilot.passive = true;
+	if (s->count)
+		n->scriptEnd = s->steps[s->count - 1].at + SCRIPT_TAIL_NS;
+}
+
+bool match_step(Match *m) {
+	/* Run the board furthest behind, up to where the other could reach it */
+	Node *n = &m->nodes[0];
+	for (uint8_t i = 1; i < m->nodeCount; i++)
+		if (instance_now(m->nodes[i].in) < instance_now(n->in))
+			n = &m->nodes[i];
+	uint64_t until = instance_now(n->in) + SLICE_NS;
+	for (uint8_t i = 0; i < m->nodeCount; i++)
+		if (&m->nodes[i] != n && instance_now(m->nodes[i].in) + m->lookahead < until)
+			until = instance_now(m->nodes[i].in) + m->lookahead;
+
+	if (m->mode == MATCH_BOT) {
+		/* The bot answers at once, so it gets the same lookahead as a board */
+		uint64_t now = instance_now(n->in);
+		bot_step(m, now);
+		if (now + m->lookahead < until)
+			until = now + m->lookahead;
+		if (peer_due(&m->bot) > now && peer_due(&m->bot) < until)
+			until = peer_due(&m->bot);
+	}
+
+	instance_enter(n->in);
+	for (uint8_t i = 0; i < m->nodeCount; i++)
+		if (&m->nodes[i] != n)
+			deliver(&m->nodes[i].out);
+	if (m->mode == MATCH_BOT)
+		deliver(&m->botOut);
+	if (n->scripted)
+		script_post(&n->script, until);
+	instance_run(n->in, until);
+
+	pilot_step(&n->pilot);
+
+	bool done = true;
+	for (uint8_t i = 0; i < m->nodeCount; i++) {
+		Node *o = &m->nodes[i];
+		if (o->scripted)	/* A recorded game ends where it did; a hand script after its tail */
+			done &= script_done(&o->script)
+				&& (pilot_done(&o->pilot) || instance_now(o->in) > o->scriptEnd);
+		else
+			done &= pilot_done(&o->pilot);
+		if (instance_now(o->in) - o->pilot.lastProgress > STALL_NS)
+			m->stalled = true;
+	}
+	return !done && !m->stalled;
+}
+
+uint64_t match_now(const Match *m) {
+	uint64_t now = instance_now(m->nodes[0].in);
+	for (uint8_t i = 1; i < m->nodeCount; i++)
+		if (instance_now(m->nodes[i].in) < now)
+			now = instance_now(m->nodes[i].in);
+	return now;
+}
@@ -0,0 +1,85 @@
+/* ---------------------------------------------------------------------------
+ * match.h - One game setup: a board against its AI, another board or the bot
+ *
+ * A Match owns its boards (instances), their pilots and the links between
+ * them, and runs them in step: match_step() runs the board furthest behind
+ * for one slice, no further than the other side could reach it through the
+ * link. Matches share nothing, so a process can hold many and step them in
+ * any order (see farm.c).
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_MATCH_H
+#define HOST_MATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "instance.h"
+#include "lcd.h"
+#include "link.h"
+#include "peer.h"
+#include "pilot.h"
+#include "script.h"
+
+#define MATCH_BOARDS	2
+
+typedef enum {
+	MATCH_AI,			/* One board against the firmware's own AI */
+	MATCH_LINK,			/* Two boards over a simulated link */
+	MATCH_BOT			/* One board against peer.c over a simulated link */
+} MatchMode;
+
+typedef struct Node Node;
+
+/* Called with each whole line a board sends, as its last byte goes out */
+typedef void (*MatchLineFn)(void *user, Node *n, const char *line);
+
+typedef struct {
+	MatchMode mode;
+	uint32_t  games;		/* Each pilot plays this many */
+	uint64_t  seed;
+	LinkModel model;
+	double	  scanChance;
+	uint64_t  thinkNs;		/* The bot's, before each move */
+	bool	  mute;			/* Sounds off, as if toggled in the settings */
+	bool	  display;		/* Decode each board's display stream */
+	bool	  echo;			/* Print what each board sends */
+	MatchLineFn onLine;		/* Optional */
+	void	  *user;
+} MatchConfig;
+
+struct Node {
+	Instance *in;
+	Pilot	 pilot;
+	Script	 script;
+	bool	 scripted;
+	uint64_t scriptEnd;			/* Last step plus time to see its effect */
+	Link	 out;				/* Bytes this board sends */
+	Lcd		 *lcd;
+	char	 name;
+	bool	 echo;
+	MatchLineFn onLine;
+	void	 *user;
+	char	 line[128];
+	uint8_t	 lineLen;
+};
+
+typedef struct {
+	MatchMode mode;
+	Node	  nodes[MATCH_BOARDS];
+	uint8_t	  nodeCount;
+	Peer	  bot;					/* MATCH_BOT: the peer, and its link to board A */
+	Link	  botOut;
+	uint64_t  lookahead;
+	bool	  stalled;				/* A board went 10 virtual minutes without progress */
+} Match;
+
+void	 match_init(Match *m, const MatchConfig *cfg);
+void	 match_free(Match *m);
+/* Script board A's inputs; call before the first step */
+void	 match_script(Match *m, const Script *s);
+/* Run one slice; false once every pilot is done or a board stalled */
+bool	 match_step(Match *m);
+/* Virtual time every board has reached */
+uint64_t match_now(const Match *m);
+
+#endif
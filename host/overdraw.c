@@ -0,0 +1,257 @@
+/* ---------------------------------------------------------------------------
+ * overdraw.c - Where the firmware writes pixels it didn't need to
+ *
+ *     overdraw [-m ai|link|bot] [-g games] [-s seed] [-n link-spec]
+ *              [-r scan-chance] [-t think-ms] [-k top] [-d prefix] [-q]
+ *
+ * Plays games on the "draw" image (see probe.h) with the display decoded, and
+ * charges every pixel written to the firmware function that asked for it and
+ * that function's caller. A write is:
+ *
+ *   same   if the pixel already had that colour (nothing changed on screen)
+ *   over   if the pixel was already written in the same 1 ms main-loop pass
+ *          (drawn twice before anyone could see the first one)
+ *
+ * Prints the -k worst sites by wasted writes (same + over, counted once),
+ * and the same totals per screen (game.gState). -d writes three heatmaps,
+ * <prefix>-writes.ppm, -same.ppm and -over.ppm, on a log scale from black
+ * (never) through blue, red and yellow to white (the most).
+ * --------------------------------------------------------------------------- */
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "instance.h"
+#include "match.h"
+#include "probe.h"
+
+#include "battleship_utils.h"
+
+#define SITES		1024			/* Open addressing, a power of two */
+#define SCREENS		(GS_OVER + 1)
+
+static const char *const SCREEN_NAMES[SCREENS] = {
+	"reset", "menu", "settings", "new game", "placing", "wait", "my turn", "wait result", "enemy turn", "over"
+};
+
+typedef struct {
+	uint64_t pixels, same, over, wasted;
+} Counts;
+
+typedef struct {
+	bool	used;
+	void	*fn, *caller;
+	Counts	c;
+} Site;
+
+/* Per board: the main-loop pass each pixel was last written in */
+typedef struct {
+	uint32_t tick[LCD_H][LCD_W];
+} Ticks;
+
+static Site		sites[SITES];
+static Counts	screens[SCREENS];
+static Counts	total;
+static uint32_t	writes[LCD_H][LCD_W], same[LCD_H][LCD_W], over[LCD_H][LCD_W];
+
+static Site *site(void *fn, void *caller) {
+	uintptr_t h = ((uintptr_t)fn * 0x9E3779B1u) ^ ((uintptr_t)caller * 0x85EBCA77u);
+	for (uint32_t i = 0; i < SITES; i++) {
+		Site *s = &sites[(h + i) & (SITES - 1)];
+		if (!s->used) {
+			s->used = true;
+			s->fn = fn;
+			s->caller = caller;
+		}
+		if (s->fn == fn && s->caller == caller)
+			return s;
+	}
+	return &sites[0];		/* Full: lump the rest together */
+}
+
+static void count(Counts *c, bool isSame, bool isOver) {
+	c->pixels++;
+	c->same += isSame;
+	c->over += isOver;
+	c->wasted += isSame || isOver;
+}
+
+/**
+ * LcdPixelFn: runs inside the drawing board's image, before the frame changes.
+ */
+static void on_pixel(Lcd *lcd, int x, int y, uint16_t colour) {
+	Ticks *b = lcd->user;
+	uint32_t tick = probe_tick() + 1;	/* 0: never written */
+	bool isSame = lcd->frame[y][x] == colour;
+	bool isOver = b->tick[y][x] == tick;
+	b->tick[y][x] = tick;
+
+	void *fn, *caller;
+	probe_site(&fn, &caller);
+	count(&site(fn, caller)->c, isSame, isOver);
+	count(&screens[game.gState < SCREENS ? game.gState : 0], isSame, isOver);
+	count(&total, isSame, isOver);
+	writes[y][x]++;
+	same[y][x] += isSame;
+	over[y][x] += isOver;
+}
+
+/* -------------------------------------------------------------------------
+ *  REPORT
+ * ------------------------------------------------------------------------- */
+/**
+ * Function names (and file:line) for addresses in this executable.
+ */
+static void symbolise(void **addrs, uint32_t n, char names[][96]) {
+	char cmd[64 + 20 * 64];
+	for (uint32_t i = 0; i < n; i++)
+		snprintf(names[i], 96, "%p", addrs[i]);
+
+	for (uint32_t base = 0; base < n; base += 64) {
+		int len = snprintf(cmd, sizeof(cmd), "addr2line -f -s -e /proc/%d/exe", (int)getpid());
+		uint32_t end = base + 64 < n ? base + 64 : n;
+		for (uint32_t i = base; i < end; i++)
+			len += snprintf(cmd + len, sizeof(cmd) - len, " %p", addrs[i]);
+		FILE *p = popen(cmd, "r");
+		if (!p)
+			return;
+		char fn[128], at[128];
+		for (uint32_t i = base; i < end && fgets(fn, sizeof(fn), p) && fgets(at, sizeof(at), p); i++) {
+			fn[strcspn(fn, "\n")] = '\0';
+			at[strcspn(at, "\n")] = '\0';
+			if (strcmp(fn, "??"))
+				snprintf(names[i], 96, "%.40s (%.50s)", fn, at);
+		}
+		pclose(p);
+	}
+}
+
+static int by_waste(const void *a, const void *b) {
+	const Site *x = a, *y = b;
+	return (x->c.wasted < y->c.wasted) - (x->c.wasted > y->c.wasted);
+}
+
+static void print_counts(const char *name, const Counts *c) {
+	printf("%9lu %7.1f%% %7.1f%% %9lu  %s\n", (unsigned long)c->pixels,
+		   c->pixels ? 100.0 * c->same / c->pixels : 0.0, c->pixels ? 100.0 * c->over / c->pixels : 0.0,
+		   (unsigned long)c->wasted, name);
+}
+
+static void report(uint32_t top) {
+	Site ranked[SITES];
+	uint32_t n = 0;
+	for (uint32_t i = 0; i < SITES; i++)
+		if (sites[i].used)
+			ranked[n++] = sites[i];
+	qsort(ranked, n, sizeof(Site), by_waste);
+	if (top > n)
+		top = n;
+
+	void *addrs[2 * SITES];
+	static char names[2 * SITES][96];
+	for (uint32_t i = 0; i < top; i++) {
+		addrs[2 * i] = ranked[i].fn;
+		addrs[2 * i + 1] = ranked[i].caller;
+	}
+	symbolise(addrs, 2 * top, names);
+
+	printf("   pixels    same    over    wasted  site <- caller\n");
+	for (uint32_t i = 0; i < top; i++) {
+		char name[200];
+		snprintf(name, sizeof(name), "%s <- %s", ranked[i].fn ? names[2 * i] : "?",
+				 ranked[i].caller ? names[2 * i + 1] : "?");
+		print_counts(name, &ranked[i].c);
+	}
+	printf("\n   pixels    same    over    wasted  screen\n");
+	for (uint32_t i = 0; i < SCREENS; i++)
+		if (screens[i].pixels)
+			print_counts(SCREEN_NAMES[i], &screens[i]);
+	print_counts("all", &total);
+}
+
+/**
+ * Heat colour for `v` of `max`, on a log scale.
+ */
+static void heat(uint32_t v, uint32_t max, uint8_t rgb[3]) {
+	static const uint8_t STOPS[5][3] = { { 0, 0, 0 }, { 0, 0, 255 }, { 255, 0, 0 }, { 255, 255, 0 }, { 255, 255, 255 } };
+	double t = v && max > 1 ? log(v) / log(max) : v ? 1.0 : 0.0;
+	double pos = v ? 1 + t * 3 : 0;		/* Anything written is at least blue */
+	int i = pos >= 4 ? 3 : (int)pos;
+	double f = pos - i;
+	for (int k = 0; k < 3; k++)
+		rgb[k] = (uint8_t)(STOPS[i][k] + (STOPS[i + 1][k] - STOPS[i][k]) * f);
+}
+
+static bool write_heat(const char *prefix, const char *name, uint32_t map[LCD_H][LCD_W]) {
+	char path[256];
+	snprintf(path, sizeof(path), "%s-%s.ppm", prefix, name);
+	FILE *f = fopen(path, "wb");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	uint32_t max = 0;
+	for (int y = 0; y < LCD_H; y++)
+		for (int x = 0; x < LCD_W; x++)
+			if (map[y][x] > max)
+				max = map[y][x];
+	fprintf(f, "P6\n%d %d\n255\n", LCD_W, LCD_H);
+	for (int y = 0; y < LCD_H; y++)
+		for (int x = 0; x < LCD_W; x++) {
+			uint8_t rgb[3];
+			heat(map[y][x], max, rgb);
+			fwrite(rgb, 1, 3, f);
+		}
+	printf("%s: max %u per pixel\n", path, max);
+	return fclose(f) == 0;
+}
+
+int main(int argc, char **argv) {
+	MatchConfig cfg = { .mode = MATCH_AI, .games = 1, .seed = 1, .scanChance = 0.1, .display = true };
+	const char *prefix = NULL;
+	uint32_t top = 20;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "m:g:s:n:r:t:k:d:q")) != -1) {
+		switch (opt) {
+			case 'm':
+				cfg.mode = !strcmp(optarg, "link") ? MATCH_LINK : !strcmp(optarg, "bot") ? MATCH_BOT : MATCH_AI;
+				break;
+			case 'g': cfg.games = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 's': cfg.seed = strtoull(optarg, NULL, 0); break;
+			case 'n':
+				if (!link_parse(&cfg.model, optarg)) {
+					fprintf(stderr, "bad link spec: %s\n", optarg);
+					return 2;
+				}
+				break;
+			case 'r': cfg.scanChance = atof(optarg); break;
+			case 't': cfg.thinkNs = (uint64_t)(atof(optarg) * NS_PER_MS); break;
+			case 'k': top = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 'd': prefix = optarg; break;
+			case 'q': cfg.mute = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-m ai|link|bot] [-g games] [-s seed] [-n link-spec] [-r scan-chance] [-t think-ms] [-k top] [-d prefix] [-q]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	Match m;
+	match_init(&m, &cfg);
+	for (uint8_t i = 0; i < m.nodeCount; i++) {
+		m.nodes[i].lcd->onPixel = on_pixel;
+		m.nodes[i].lcd->user = calloc(1, sizeof(Ticks));
+	}
+	while (match_step(&m))
+		;
+
+	report(top);
+	if (prefix && !(write_heat(prefix, "writes", writes) && write_heat(prefix, "same", same)
+					&& write_heat(prefix, "over", over)))
+		return 1;
+	return m.stalled ? 1 : 0;
+}
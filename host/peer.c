@@ -0,0 +1,423 @@
+/* ---------------------------------------------------------------------------
+ * peer.c - The multiplayer protocol, played from the host against a board
+ * --------------------------------------------------------------------------- */
+#include "peer.h"
+#include "board.h"
+#include "rng.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+/* The firmware's timing (main.c), so the board sees a peer like itself */
+#define READY_RESEND_NS		(500 * NS_PER_MS)
+#define READY_LINGER_NS		(2000 * NS_PER_MS)
+#define RESEND_NS			(100 * NS_PER_MS)
+#define RESEND_MAX_NS		(1600 * NS_PER_MS)
+#define HOLD_NS				(80 * NS_PER_MS)	/* Longest a result may wait for our attack */
+#define TIMEOUT_NS			(120000 * NS_PER_MS)
+#define OVER_NS				(5000 * NS_PER_MS)	/* Looking at the end screen before starting over */
+
+enum { PEER_SYNC, PEER_MY_TURN, PEER_WAIT_RES, PEER_THEIR_TURN, PEER_OVER };
+
+/* SHIP_LENGTHS lives in the firmware image, which peerbot does not link */
+static const uint8_t FLEET[NUM_SHIPS] = { 5, 4, 3, 3, 2 };
+
+/* Lines a board prints that are reports, not frames */
+static const char *const REPORTS[] = { "BOOT", "STATS", "ARENA", "LAT", "SPI", "AI" };
+
+#define CELL(rows, r, c)	(((rows)[r] >> (c)) & 1)
+#define MARK(rows, r, c)	((rows)[r] |= (uint16_t)(1u << (c)))
+
+/* -------------------------------------------------------------------------
+ *  OUTPUT
+ * ------------------------------------------------------------------------- */
+/**
+ * Send one frame; returns the time its newline is out.
+ */
+static uint64_t send(Peer *p, uint64_t now, const char *fmt, ...) {
+	char buf[PEER_LINE_MAX];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(buf, sizeof(buf) - 1, fmt, ap);
+	va_end(ap);
+	if (n < 0)
+		return now;
+	if (n > (int)sizeof(buf) - 2)
+		n = sizeof(buf) - 2;
+	buf[n++] = '\n';
+
+	uint64_t at = p->txFree > now ? p->txFree : now;
+	for (int i = 0; i < n; i++) {
+		at += BOARD_UART_BYTE_NS;
+		p->tx(p->txCtx, at, (uint8_t)buf[i]);
+	}
+	p->txFree = at;
+	return at;
+}
+
+static void send_ready(Peer *p, uint64_t now) {
+	send(p, now, "READY %u %s%s", p->token, p->cfg.piggyback ? "P" : "", p->cfg.radar ? "S" : "");
+	p->readyAt = now + READY_RESEND_NS;
+}
+
+static void send_move(Peer *p, uint64_t now) {
+	if (p->scan) {
+		if (p->carrying)
+			send(p, now, "R %u %u %c", p->carryRow, p->carryCol, p->carryHit ? 'H' : 'M');
+		p->carrying = false;
+		send(p, now, "S %u %d %d", RADAR_USES - p->scansLeft, p->row, p->col);
+	} else if (p->carrying) {
+		send(p, now, "P %u %u %c %d %d", p->carryRow, p->carryCol, p->carryHit ? 'H' : 'M', p->row, p->col);
+	} else {
+		send(p, now, "A %d %d", p->row, p->col);
+	}
+}
+
+/* -------------------------------------------------------------------------
+ *  GAME
+ * ------------------------------------------------------------------------- */
+static void place_fleet(Peer *p) {
+	memset(p->ships, 0, sizeof(p->ships));
+	p->shipCells = 0;
+	for (uint8_t i = 0; i < NUM_SHIPS; i++) {
+		uint8_t len = FLEET[i];
+		for (;;) {
+			bool horizontal = rng_chance(&p->rng, 0.5);
+			uint8_t r = rng_below(&p->rng, horizontal ? GRID_ROWS : GRID_ROWS - len + 1);
+			uint8_t c = rng_below(&p->rng, horizontal ? GRID_COLS - len + 1 : GRID_COLS);
+			bool clear = true;
+			for (uint8_t k = 0; k < len && clear; k++)
+				clear = !CELL(p->ships, horizontal ? r : r + k, horizontal ? c + k : c);
+			if (!clear)
+				continue;
+			for (uint8_t k = 0; k < len; k++)
+				MARK(p->ships, horizontal ? r : r + k, horizontal ? c + k : c);
+			p->shipCells += len;
+			break;
+		}
+	}
+}
+
+static void new_game(Peer *p, uint64_t now) {
+	place_fleet(p);
+	memset(p->shotAt, 0, sizeof(p->shotAt));
+	memset(p->fired, 0, sizeof(p->fired));
+	memset(p->hits, 0, sizeof(p->hits));
+	p->enemyCells = p->shipCells;
+	p->scansLeft = p->cfg.radar ? RADAR_USES : 0;
+	p->boardScans = 0;
+	p->token = 1 + rng_below(&p->rng, 0xFFFF);
+	p->boardToken = 0;
+	p->row = p->col = -1;
+	p->carrying = false;
+	p->state = PEER_SYNC;
+	p->readyAt = now;
+	p->quietSince = now;
+}
+
+static void game_over(Peer *p, uint64_t at, bool won) {
+	p->state = PEER_OVER;
+	p->quietSince = at;
+	p->stats.games++;
+	if (won)
+		p->stats.wins++;
+}
+
+/**
+ * Hunt and target: finish off hit cells first, else fire at a random unshot
+ * cell of one parity colour.
+ */
+static void aim(Peer *p) {
+	static const int8_t DR[4] = { -1, 1, 0, 0 }, DC[4] = { 0, 0, -1, 1 };
+	uint8_t cells[4 * GRID_ROWS * GRID_COLS];
+	uint16_t n = 0;
+
+	for (uint8_t r = 0; r < GRID_ROWS; r++)
+		for (uint8_t c = 0; c < GRID_COLS; c++)
+			for (uint8_t d = 0; d < 4 && CELL(p->hits, r, c); d++) {
+				int8_t nr = r + DR[d], nc = c + DC[d];
+				if (nr >= 0 && nr < GRID_ROWS && nc >= 0 && nc < GRID_COLS && !CELL(p->fired, nr, nc))
+					cells[n++] = nr * GRID_COLS + nc;
+			}
+	for (uint8_t pass = 0; pass < 2 && !n; pass++)
+		for (uint8_t r = 0; r < GRID_ROWS; r++)
+			for (uint8_t c = 0; c < GRID_COLS; c++)
+				if ((pass || (r + c) % 2 == 0) && !CELL(p->fired, r, c))
+					cells[n++] = r * GRID_COLS + c;
+
+	uint8_t pick = cells[rng_below(&p->rng, n)];
+	p->row = pick / GRID_COLS;
+	p->col = pick % GRID_COLS;
+	p->scan = p->scansLeft && p->boardRadar && rng_chance(&p->rng, p->cfg.scanChance);
+}
+
+static void take_turn(Peer *p, uint64_t at) {
+	p->state = PEER_MY_TURN;
+	p->moveAt = at + p->cfg.thinkNs;
+	p->quietSince = at;
+}
+
+static void pass_turn(Peer *p, uint64_t at) {
+	p->state = PEER_THEIR_TURN;
+	p->turnAt = at;
+	p->quietSince = at;
+}
+
+/* -------------------------------------------------------------------------
+ *  INCOMING FRAMES
+ * ------------------------------------------------------------------------- */
+static void on_ready(Peer *p, uint64_t at, uint16_t tok, const char *flags) {
+	// Believed once heard twice running, as the firmware does
+	if (tok != p->heardToken) {
+		p->heardToken = tok;
+		return;
+	}
+	if (p->state != PEER_SYNC) {
+		if (tok == p->boardToken)
+			return;						// Its READY lingering after sync
+		if (p->state != PEER_OVER)
+			p->stats.abandoned++;		// It started over mid-game
+		new_game(p, at);
+	}
+	if (tok == p->token) {
+		p->token = 1 + rng_below(&p->rng, 0xFFFF);	// Nobody would start
+		return;
+	}
+
+	p->boardToken = tok;
+	p->boardPiggyback = strchr(flags, 'P') != NULL;
+	p->boardRadar = strchr(flags, 'S') != NULL;
+	p->readyUntil = at + READY_LINGER_NS;
+	if (p->token > tok)
+		take_turn(p, at);
+	else
+		pass_turn(p, at);
+}
+
+static void on_attack(Peer *p, uint64_t at, uint8_t r, uint8_t c) {
+	if (r >= GRID_ROWS || c >= GRID_COLS)
+		return;
+	bool hit = CELL(p->ships, r, c);
+
+	if (CELL(p->shotAt, r, c)) {
+		// Sent again: our answer was lost (unless it is still being held)
+		p->stats.repeats++;
+		if (!(p->carrying && p->carryRow == r && p->carryCol == c))
+			send(p, at, "R %u %u %c", r, c, hit ? 'H' : 'M');
+		return;
+	}
+	if (p->state != PEER_THEIR_TURN)
+		return;
+
+	MARK(p->shotAt, r, c);
+	latency_add(&p->stats.move, at - p->turnAt);
+	if (hit && --p->shipCells == 0) {
+		send(p, at, "R %u %u %c", r, c, 'H');
+		game_over(p, at, false);
+		return;
+	}
+	if (p->cfg.piggyback && p->boardPiggyback && p->cfg.thinkNs <= HOLD_NS) {
+		p->carrying = true;
+		p->carryRow = r;
+		p->carryCol = c;
+		p->carryHit = hit;
+	} else {
+		send(p, at, "R %u %u %c", r, c, hit ? 'H' : 'M');
+	}
+	take_turn(p, at);
+}
+
+static void on_scan(Peer *p, uint64_t at, uint8_t seq, uint8_t r, uint8_t c) {
+	if (!p->cfg.radar || r >= GRID_ROWS || c >= GRID_COLS || seq >= RADAR_USES)
+		return;
+
+	uint8_t n = 0;
+	for (int8_t dr = -RADAR_RADIUS; dr <= RADAR_RADIUS; dr++)
+		for (int8_t dc = -RADAR_RADIUS; dc <= RADAR_RADIUS; dc++)
+			if (r + dr >= 0 && r + dr < GRID_ROWS && c + dc >= 0 && c + dc < GRID_COLS)
+				n += CELL(p->ships, r + dr, c + dc);
+
+	if (seq < p->boardScans) {
+		p->stats.repeats++;
+		send(p, at, "Q %u %u %u", r, c, n);
+		return;
+	}
+	if (p->state != PEER_THEIR_TURN)
+		return;
+	latency_add(&p->stats.move, at - p->turnAt);
+	send(p, at, "Q %u %u %u", r, c, n);
+	p->boardScans = seq + 1;
+	take_turn(p, at);
+}
+
+static void on_result(Peer *p, uint64_t at, uint8_t r, uint8_t c, bool hit) {
+	if (p->state != PEER_WAIT_RES || p->scan || p->row != r || p->col != c)
+		return;							// Stale: an answer to a resend
+	latency_add(&p->stats.answer, at - p->sentAt);
+	p->carrying = false;
+	MARK(p->fired, r, c);
+	p->row = p->col = -1;
+	if (hit) {
+		MARK(p->hits, r, c);
+		if (--p->enemyCells == 0) {
+			game_over(p, at, true);
+			return;
+		}
+	}
+	pass_turn(p, at);
+}
+
+static void on_scan_result(Peer *p, uint64_t at, uint8_t r, uint8_t c) {
+	if (p->state != PEER_WAIT_RES || !p->scan || p->row != r || p->col != c)
+		return;
+	latency_add(&p->stats.answer, at - p->sentAt);
+	p->scansLeft--;
+	p->row = p->col = -1;
+	pass_turn(p, at);
+}
+
+/**
+ * Parse one line, as strictly as the firmware: nothing may follow the last
+ * field. Returns false if it is not a frame.
+ */
+static bool parse(Peer *p, uint64_t at, const char *l) {
+	unsigned a, b, c, d, e;
+	char h, x, flags[4] = "";
+	int n;
+
+	if (!strncmp(l, "READY", 5)) {
+		n = sscanf(l + 5, "%u %3s %c", &a, flags, &x);
+		if ((n == 1 || n == 2) && a <= 0xFFFF) {
+			on_ready(p, at, a, flags);
+			return true;
+		}
+	} else if (l[0] == 'A') {
+		if (sscanf(l + 1, "%u %u %c", &a, &b, &x) == 2) {
+			on_attack(p, at, a, b);
+			return true;
+		}
+	} else if (l[0] == 'R') {
+		if (sscanf(l + 1, "%u %u %c %c", &a, &b, &h, &x) == 3 && (h == 'H' || h == 'M')) {
+			on_result(p, at, a, b, h == 'H');
+			return true;
+		}
+	} else if (l[0] == 'P') {
+		if (sscanf(l + 1, "%u %u %c %u %u %c", &a, &b, &h, &d, &e, &x) == 5 && (h == 'H' || h == 'M')) {
+			on_result(p, at, a, b, h == 'H');
+			if (p->state != PEER_OVER)
+				on_attack(p, at, d, e);
+			return true;
+		}
+	} else if (l[0] == 'S') {
+		if (sscanf(l + 1, "%u %u %u %c", &a, &b, &c, &x) == 3) {
+			on_scan(p, at, a, b, c);
+			return true;
+		}
+	} else if (l[0] == 'Q') {
+		if (sscanf(l + 1, "%u %u %u %c", &a, &b, &c, &x) == 3) {
+			on_scan_result(p, at, a, b);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void on_line(Peer *p, uint64_t at, const char *l) {
+	for (size_t i = 0; i < sizeof(REPORTS) / sizeof(REPORTS[0]); i++) {
+		size_t len = strlen(REPORTS[i]);
+		if (!strncmp(l, REPORTS[i], len) && (l[len] == ' ' || l[len] == '\0')) {
+			if (i == 1)
+				snprintf(p->boardStats, sizeof(p->boardStats), "%s", l);
+			return;
+		}
+	}
+	p->stats.frames++;
+	if (!parse(p, at, l))
+		p->stats.bad++;
+}
+
+/* -------------------------------------------------------------------------
+ *  API
+ * ------------------------------------------------------------------------- */
+void peer_init(Peer *p, const PeerConfig *cfg, uint64_t seed, PeerTx tx, void *txCtx) {
+	memset(p, 0, sizeof(*p));
+	p->cfg = *cfg;
+	p->rng = seed;
+	p->tx = tx;
+	p->txCtx = txCtx;
+	new_game(p, 0);
+}
+
+void peer_rx(Peer *p, uint64_t at, uint8_t byte) {
+	if (byte == '\n' || byte == '\r') {
+		if (p->lineLen && !p->lineLong) {
+			p->line[p->lineLen] = '\0';
+			on_line(p, at, p->line);
+		} else if (p->lineLong) {
+			p->stats.frames++;
+			p->stats.bad++;
+		}
+		p->lineLen = 0;
+		p->lineLong = false;
+	} else if (p->lineLen < PEER_LINE_MAX - 1) {
+		p->line[p->lineLen++] = byte;
+	} else {
+		p->lineLong = true;
+	}
+}
+
+void peer_poll(Peer *p, uint64_t now) {
+	if ((p->state == PEER_SYNC || now < p->readyUntil) && now >= p->readyAt)
+		send_ready(p, now);
+
+	if (p->state == PEER_MY_TURN && now >= p->moveAt) {
+		aim(p);
+		send_move(p, now);
+		if (p->scan)
+			p->stats.scans++;
+		else
+			p->stats.shots++;
+		p->sentAt = p->txFree;
+		p->resendWait = RESEND_NS;
+		p->resendAt = p->txFree + RESEND_NS;
+		p->state = PEER_WAIT_RES;
+	} else if (p->state == PEER_WAIT_RES && now >= p->resendAt) {
+		send_move(p, now);
+		p->stats.resends++;
+		p->resendWait = p->resendWait < RESEND_MAX_NS / 2 ? p->resendWait * 2 : RESEND_MAX_NS;
+		p->resendAt = p->txFree + p->resendWait;
+	}
+
+	if (p->state == PEER_OVER && now - p->quietSince > OVER_NS) {
+		new_game(p, now);				// Unless the board's READY started one already
+	} else if (p->state != PEER_SYNC && p->state != PEER_OVER && now - p->quietSince > TIMEOUT_NS) {
+		p->stats.abandoned++;			// The board went silent
+		new_game(p, now);
+	}
+}
+
+uint64_t peer_due(const Peer *p) {
+	uint64_t due = UINT64_MAX;
+	if (p->state == PEER_SYNC || p->readyUntil > p->readyAt)
+		due = p->readyAt;
+	if (p->state == PEER_MY_TURN && p->moveAt < due)
+		due = p->moveAt;
+	if (p->state == PEER_WAIT_RES && p->resendAt < due)
+		due = p->resendAt;
+	if (p->state == PEER_OVER && p->quietSince + OVER_NS < due)
+		due = p->quietSince + OVER_NS + 1;
+	else if (p->state != PEER_SYNC && p->state != PEER_OVER && p->quietSince + TIMEOUT_NS < due)
+		due = p->quietSince + TIMEOUT_NS + 1;
+	return due;
+}
+
+void peer_report(const Peer *p, FILE *out) {
+	const PeerStats *s = &p->stats;
+	fprintf(out, "peer: games=%u wins=%u abandoned=%u shots=%u scans=%u resends=%u repeats=%u frames=%u bad=%u",
+			s->games, s->wins, s->abandoned, s->shots, s->scans, s->resends, s->repeats, s->frames, s->bad);
+	latency_print(out, "answer", &s->answer);
+	latency_print(out, "move", &s->move);
+	fputc('\n', out);
+	if (p->boardStats[0])
+		fprintf(out, "peer: board said \"%s\"\n", p->boardStats);
+}
@@ -0,0 +1,99 @@
+/* ---------------------------------------------------------------------------
+ * peer.h - The multiplayer protocol, played from the host against a board
+ *
+ * A Peer is the far end of a board's UART. It syncs with READY, places a
+ * random fleet, answers attacks ("A", "P") and radar scans ("S"), takes its
+ * own turns with resends, and starts over when the board starts a new game
+ * (or on its own, a few seconds after one ends).
+ *
+ * It keeps no clock: every byte in and every poll comes with the time (ns),
+ * and bytes go out through `tx` stamped with the time their stop bit ends on
+ * a 9600 baud line. The runner drives it in virtual time, peerbot in real
+ * time over a pty or serial port.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_PEER_H
+#define HOST_PEER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "latency.h"
+
+#include "battleship_utils.h"
+
+#define PEER_LINE_MAX	64
+
+typedef void (*PeerTx)(void *ctx, uint64_t at, uint8_t byte);
+
+typedef struct {
+	uint64_t thinkNs;		/* Before each of our moves; 0 = as fast as the link allows */
+	double	 scanChance;	/* Chance a move scans while scans are left */
+	bool	 piggyback;		/* Offer to read "P" frames and carry our results on attacks */
+	bool	 radar;			/* Offer to answer "S" frames, and scan */
+} PeerConfig;
+
+typedef struct {
+	uint32_t games, wins;
+	uint32_t abandoned;		/* The board started over, or went silent, mid-game */
+	uint32_t shots, scans;
+	Latency	 answer;		/* Our move out to the board's answer in */
+	Latency	 move;			/* The turn passing to the board to its move in */
+	uint32_t resends;		/* Our moves sent again: the frame or its answer was lost */
+	uint32_t repeats;		/* Moves the board sent again: it missed our answer */
+	uint32_t frames;		/* Lines from the board */
+	uint32_t bad;			/* ... that were not frames */
+} PeerStats;
+
+typedef struct {
+	PeerConfig	cfg;
+	PeerStats	stats;
+	uint64_t	rng;
+	PeerTx		tx;
+	void		*txCtx;
+	uint64_t	txFree;			/* Our UART is busy until then */
+
+	char		line[PEER_LINE_MAX];
+	uint8_t		lineLen;
+	bool		lineLong;
+
+	/* Sync */
+	uint8_t		state;			/* PeerState */
+	uint16_t	token, boardToken, heardToken;
+	bool		boardPiggyback, boardRadar;
+	uint64_t	readyAt;		/* Next READY out */
+	uint64_t	readyUntil;		/* Keep sending READY until then (linger after sync) */
+
+	/* Boards */
+	uint16_t	ships[GRID_ROWS];	/* Our fleet, a bit per column */
+	uint16_t	shotAt[GRID_ROWS];	/* Cells the board has fired at */
+	uint16_t	fired[GRID_ROWS];	/* Cells we have fired at */
+	uint16_t	hits[GRID_ROWS];
+	uint8_t		shipCells, enemyCells;	/* Left to sink on each side */
+	uint8_t		scansLeft, boardScans;
+
+	/* Our move */
+	uint64_t	moveAt;			/* Thinking ends */
+	int8_t		row, col;		/* Pending move, -1 none */
+	bool		scan;
+	uint64_t	sentAt;			/* Its first copy went out */
+	uint64_t	resendAt, resendWait;
+	bool		carrying;		/* A result waits to ride on our attack */
+	uint8_t		carryRow, carryCol;
+	bool		carryHit;
+
+	uint64_t	turnAt;			/* The turn passed to the board */
+	uint64_t	quietSince;		/* Last progress in this game */
+	char		boardStats[PEER_LINE_MAX];	/* The board's last STATS line */
+} Peer;
+
+void peer_init(Peer *p, const PeerConfig *cfg, uint64_t seed, PeerTx tx, void *txCtx);
+/* A byte from the board, received at `at` */
+void peer_rx(Peer *p, uint64_t at, uint8_t byte);
+/* Send what is due by `now` (READY, moves, resends) */
+void peer_poll(Peer *p, uint64_t now);
+/* When peer_poll next has something to do */
+uint64_t peer_due(const Peer *p);
+void peer_report(const Peer *p, FILE *out);
+
+#endif
@@ -0,0 +1,250 @@
+/* ---------------------------------------------------------------------------
+ * peerbot.c - Play a board, or another peerbot, over a real serial line
+ *
+ *     peerbot (-p | -D device) [-g games] [-s seed] [-n link-spec]
+ *             [-t think-ms] [-r scan-chance] [-P] [-R] [-v]
+ *
+ * -p        make a pty and print the name of its far end
+ * -D        use a serial port (9600 8N1, raw), or the far end of a pty
+ * -g        stop after this many games (default: run until interrupted)
+ * -n        impair the line both ways, as runner's link model:
+ *           "latency=5,jitter=2,lineloss=0.01,byteloss=0.001,corrupt=0.001"
+ * -t        thinking time before each move (default 0)
+ * -r        chance a move scans with the radar while scans are left
+ * -P / -R   don't offer piggybacked results / radar scans
+ * -v        echo every line each way
+ *
+ * The protocol is peer.c's, run on the monotonic clock. A report (moves,
+ * latency percentiles, resends and frames lost) is printed after each game
+ * and on exit.
+ * --------------------------------------------------------------------------- */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "link.h"
+#include "peer.h"
+
+#define POLL_MAX_MS		100
+
+static volatile sig_atomic_t stop;
+
+typedef struct {
+	bool	 on;
+	char	 dir;
+	char	 line[PEER_LINE_MAX];
+	uint8_t	 len;
+} Echo;
+
+static void on_signal(int sig) {
+	stop = 1;
+}
+
+static int usage(const char *argv0) {
+	fprintf(stderr, "usage: %s (-p | -D device) [-g games] [-s seed] [-n link-spec] [-t think-ms] [-r scan-chance] [-P] [-R] [-v]\n", argv0);
+	return 2;
+}
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void echo(Echo *e, uint64_t at, uint8_t byte) {
+	if (!e->on || byte == '\r')
+		return;
+	if (byte != '\n' && e->len < sizeof(e->line) - 1) {
+		e->line[e->len++] = (char)byte;
+		return;
+	}
+	e->line[e->len] = '\0';
+	printf("%10.3f %c %s\n", (double)at / NS_PER_MS, e->dir, e->line);
+	e->len = 0;
+}
+
+/**
+ * Raw 8N1 at 9600 baud. A pty takes the settings but ignores the speed;
+ * peer.c paces what it sends itself.
+ */
+static bool make_raw(int fd) {
+	struct termios t;
+	if (tcgetattr(fd, &t) < 0)
+		return false;
+	cfmakeraw(&t);
+	cfsetispeed(&t, B9600);
+	cfsetospeed(&t, B9600);
+	t.c_cflag |= CLOCAL | CREAD;
+	t.c_cflag &= ~(CSTOPB | CRTSCTS);
+	t.c_cc[VMIN] = 0;
+	t.c_cc[VTIME] = 0;
+	return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+/**
+ * Open a pty and print its far end. The far end is kept open here too, so
+ * reads don't fail while nothing is attached.
+ */
+static int open_pty(void) {
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0)
+		return -1;
+	const char *name = ptsname(fd);
+	int far = name ? open(name, O_RDWR | O_NOCTTY) : -1;
+	if (far < 0 || !make_raw(far))
+		return -1;
+	printf("pty %s\n", name);
+	fflush(stdout);
+	return fd;
+}
+
+static int open_device(const char *path) {
+	int fd = open(path, O_RDWR | O_NOCTTY);
+	if (fd < 0)
+		return -1;
+	if (!make_raw(fd)) {
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIOFLUSH);
+	return fd;
+}
+
+int main(int argc, char **argv) {
+	bool pty = false;
+	const char *device = NULL;
+	uint32_t games = 0;
+	uint64_t seed = 0;
+	LinkModel model = { 0 };
+	PeerConfig cfg = { .scanChance = 0.1, .piggyback = true, .radar = true };
+	Echo rxEcho = { .dir = '<' }, txEcho = { .dir = '>' };
+
+	int opt;
+	while ((opt = getopt(argc, argv, "pD:g:s:n:t:r:PRv")) != -1) {
+		switch (opt) {
+			case 'p': pty = true; break;
+			case 'D': device = optarg; break;
+			case 'g': games = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 's': seed = strtoull(optarg, NULL, 0); break;
+			case 'n':
+				if (!link_parse(&model, optarg)) {
+					fprintf(stderr, "bad link spec: %s\n", optarg);
+					return 2;
+				}
+				break;
+			case 't': cfg.thinkNs = (uint64_t)(atof(optarg) * NS_PER_MS); break;
+			case 'r': cfg.scanChance = atof(optarg); break;
+			case 'P': cfg.piggyback = false; break;
+			case 'R': cfg.radar = false; break;
+			case 'v': rxEcho.on = txEcho.on = true; break;
+			default: return usage(argv[0]);
+		}
+	}
+	if (pty == (device != NULL))
+		return usage(argv[0]);
+	if (!seed)
+		seed = now_ns() ^ (uint64_t)getpid() << 32;
+
+	int fd = pty ? open_pty() : open_device(device);
+	if (fd < 0) {
+		perror(pty ? "pty" : device);
+		return 1;
+	}
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	/* Both directions go through a link model; with no -n it only paces */
+	Link in, out;
+	link_init(&in, &model, seed * 1000003);
+	link_init(&out, &model, seed * 1000003 + 1);
+	Peer p;
+	peer_init(&p, &cfg, seed, link_send, &out);
+
+	uint64_t t0 = now_ns();
+	uint32_t reported = 0;
+	while (!stop && (!games || p.stats.games < games)) {
+		uint64_t now = now_ns() - t0, at;
+
+		/* Out: bytes whose time has come */
+		uint8_t buf[64];
+		size_t n = 0;
+		while (n < sizeof(buf) && link_peek(&out, &at) && at <= now) {
+			buf[n] = link_pop(&out, &at);
+			echo(&txEcho, at, buf[n++]);
+		}
+		if (n && write(fd, buf, n) < 0 && errno != EAGAIN) {
+			perror("write");
+			break;
+		}
+
+		/* In: through the link model, then to the peer */
+		while (link_peek(&in, &at) && at <= now) {
+			uint8_t byte = link_pop(&in, &at);
+			echo(&rxEcho, at, byte);
+			peer_rx(&p, at, byte);
+		}
+		peer_poll(&p, now);
+
+		if (p.stats.games != reported && (!games || p.stats.games < games)) {
+			reported = p.stats.games;
+			peer_report(&p, stdout);
+			fflush(stdout);
+		}
+
+		/* Sleep until a byte comes in or something falls due */
+		uint64_t due = peer_due(&p);
+		if (link_peek(&out, &at) && at < due)
+			due = at;
+		if (link_peek(&in, &at) && at < due)
+			due = at;
+		int wait = due <= now ? 0 : due - now >= POLL_MAX_MS * NS_PER_MS ? POLL_MAX_MS
+				 : (int)((due - now + NS_PER_MS - 1) / NS_PER_MS);
+		struct pollfd pfd = { .fd = fd, .events = POLLIN };
+		if (poll(&pfd, 1, wait) > 0) {
+			if (pfd.revents & POLLIN) {
+				ssize_t got = read(fd, buf, sizeof(buf));
+				uint64_t rx = now_ns() - t0;
+				for (ssize_t i = 0; i < got; i++)
+					link_send(&in, rx, buf[i]);
+			} else if (pfd.revents & (POLLERR | POLLHUP)) {
+				fprintf(stderr, "line closed\n");
+				break;
+			}
+		}
+	}
+
+	/* Let the last answer out before closing the line */
+	uint64_t at;
+	while (!stop && link_peek(&out, &at)) {
+		uint64_t now = now_ns() - t0;
+		if (at > now) {
+			usleep((at - now) / NS_PER_US);
+			continue;
+		}
+		uint8_t byte = link_pop(&out, &at);
+		echo(&txEcho, at, byte);
+		if (write(fd, &byte, 1) < 0)
+			break;
+	}
+	tcdrain(fd);
+
+	peer_report(&p, stdout);
+	printf("link >: bytes=%u lines=%u lost-lines=%u lost-bytes=%u corrupted=%u\n",
+		   out.stats.bytes, out.stats.lines, out.stats.linesLost, out.stats.bytesLost, out.stats.bytesCorrupted);
+	printf("link <: bytes=%u lines=%u lost-lines=%u lost-bytes=%u corrupted=%u\n",
+		   in.stats.bytes, in.stats.lines, in.stats.linesLost, in.stats.bytesLost, in.stats.bytesCorrupted);
+	link_free(&in);
+	link_free(&out);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,282 @@
+/* ---------------------------------------------------------------------------
+ * pilot.c - Plays the game on a simulated board through its stick and button
+ * --------------------------------------------------------------------------- */
+#include "pilot.h"
+#include "board.h"
+#include "rng.h"
+#include "script.h"
+
+#include <string.h>
+
+#include "battleship_utils.h"
+
+#define TAP_NS			(40 * NS_PER_MS)	/* Short press */
+#define HOLD_NS			(650 * NS_PER_MS)	/* Long press: rotate, or scan */
+#define SETTLE_NS		(20 * NS_PER_MS)	/* Gap after a press before the next input */
+#define OVER_READ_NS	(3000 * NS_PER_MS)	/* Looking at the end screen before tapping on */
+#define OVER_GAP_NS		(300 * NS_PER_MS)	/* Between the end screen's two taps */
+
+enum { AXIS_X, AXIS_Y };
+enum { STICK_LOW, STICK_CENTRE, STICK_HIGH };
+
+static const uint16_t STICK_VALUE[3] = { BOARD_STICK_LOW, BOARD_STICK_CENTRE, BOARD_STICK_HIGH };
+
+void pilot_init(Pilot *p, bool versusAi, uint32_t games, uint64_t seed) {
+	memset(p, 0, sizeof(*p));
+	p->rng = seed;
+	p->versusAi = versusAi;
+	p->gamesLeft = games;
+	p->stickX = p->stickY = STICK_CENTRE;
+	p->planIdx = -1;
+	p->aimRow = p->aimCol = -1;
+}
+
+bool pilot_done(const Pilot *p) {
+	return p->gamesLeft == 0 && !p->inGame;
+}
+
+/* Inputs land on whole microseconds so a recorded script replays exactly */
+static uint64_t input_time(void) {
+	return (board.now / NS_PER_US + 1) * NS_PER_US;
+}
+
+static void stick(Pilot *p, uint8_t axis, uint8_t dir) {
+	uint8_t *held = axis == AXIS_X ? &p->stickX : &p->stickY;
+	if (*held == dir)
+		return;
+	*held = dir;
+	uint64_t at = input_time();
+	board_stick_at(at, axis, STICK_VALUE[dir]);
+	if (p->record)
+		script_write_stick(p->record, at, axis, STICK_VALUE[dir]);
+}
+
+static void centre(Pilot *p) {
+	stick(p, AXIS_X, STICK_CENTRE);
+	stick(p, AXIS_Y, STICK_CENTRE);
+}
+
+static void press(Pilot *p, uint64_t ns) {
+	uint64_t at = input_time();
+	board_button_at(at, true);
+	board_button_at(at + ns, false);
+	if (p->record) {
+		script_write_button(p->record, at, true);
+		script_write_button(p->record, at + ns, false);
+	}
+	p->busyUntil = at + ns + SETTLE_NS;
+}
+
+/**
+ * Steer the cursor one axis at a time; true once it is on (row, col).
+ */
+static bool steer(Pilot *p, uint8_t row, uint8_t col) {
+	if (game.selRow != row) {
+		stick(p, AXIS_X, STICK_CENTRE);
+		stick(p, AXIS_Y, game.selRow > row ? STICK_LOW : STICK_HIGH);
+		return false;
+	}
+	if (game.selCol != col) {
+		stick(p, AXIS_Y, STICK_CENTRE);
+		stick(p, AXIS_X, game.selCol > col ? STICK_LOW : STICK_HIGH);
+		return false;
+	}
+	centre(p);
+	return true;
+}
+
+/**
+ * Keep the statistics from what the firmware does, so they hold for a
+ * passive pilot too.
+ */
+static void track(Pilot *p) {
+	uint8_t state = game.gState;
+
+	if (state == GS_PLACING && !p->inGame) {
+		p->inGame = true;
+		p->overSeen = false;
+		p->gameStart = board.now;
+		p->lastProgress = board.now;
+		if (p->gamesLeft)
+			p->gamesLeft--;
+	} else if (state == GS_MAINMENU && p->inGame) {
+		if (!p->overSeen)
+			p->stats.aborted++;		/* The firmware gave up on the game */
+		p->inGame = false;
+	}
+
+	if (state == GS_WAITRES && p->lastState != GS_WAITRES) {
+		p->movedAt = board.now;
+		if (game.pendingScan)
+			p->stats.scans++;
+		else
+			p->stats.shots++;
+	} else if (state != GS_WAITRES && p->lastState == GS_WAITRES) {
+		uint64_t ns = board.now - p->movedAt;
+		p->stats.answers++;
+		p->stats.answerNsSum += ns;
+		if (ns > p->stats.answerNsMax)
+			p->stats.answerNsMax = ns;
+		uint8_t b = 0;
+		while (b < PILOT_TURN_BUCKETS - 1 && ns > (NS_PER_MS << b))
+			b++;
+		p->stats.answerHist[b]++;
+	}
+
+	if (state == GS_OVER && !p->overSeen) {
+		p->overSeen = true;
+		p->stats.games++;
+		if (game.enemyRemaining == 0)
+			p->stats.wins++;
+		p->stats.gameNs += board.now - p->gameStart;
+		p->lastProgress = board.now;
+		p->busyUntil = board.now + OVER_READ_NS;
+	}
+	p->lastState = state;
+}
+
+static void on_menu(Pilot *p) {
+	if (p->gamesLeft == 0)
+		return;
+
+	uint8_t want = p->versusAi ? WID_VERSUS_AI : WID_MULTIPLAYER;
+	uint8_t focus = widgets_focus();
+	if (focus == want) {
+		centre(p);
+		press(p, TAP_NS);
+	} else if (focus == WID_GEAR) {
+		stick(p, AXIS_X, STICK_LOW);
+	} else {
+		stick(p, AXIS_X, STICK_CENTRE);
+		stick(p, AXIS_Y, p->versusAi ? STICK_HIGH : STICK_LOW);
+	}
+}
+
+static void on_placing(Pilot *p) {
+	if (game.showInvalid)
+		return;
+
+	uint8_t idx = game.ghostShipIdx;
+	uint8_t len = SHIP_LENGTHS[idx];
+	if (p->planIdx != idx || !ship_can_fit(game.playerOccupiedBitmap, p->planRow, p->planCol, len, p->planHorizontal)) {
+		do {
+			p->planHorizontal = rng_below(&p->rng, 2);
+			p->planRow = rng_below(&p->rng, p->planHorizontal ? GRID_ROWS : GRID_ROWS - len + 1);
+			p->planCol = rng_below(&p->rng, p->planHorizontal ? GRID_COLS - len + 1 : GRID_COLS);
+		} while (!ship_can_fit(game.playerOccupiedBitmap, p->planRow, p->planCol, len, p->planHorizontal));
+		p->planIdx = idx;
+	}
+
+	if (game.ghostHorizontal != p->planHorizontal) {
+		centre(p);
+		press(p, HOLD_NS);
+	} else if (steer(p, p->planRow, p->planCol)) {
+		press(p, TAP_NS);
+	}
+}
+
+/**
+ * Hunt and target: finish off hit cells first, else fire at a random unshot
+ * cell of one parity colour (the smallest ship covers two cells).
+ */
+static void aim(Pilot *p) {
+	static const int8_t DR[4] = { -1, 1, 0, 0 }, DC[4] = { 0, 0, -1, 1 };
+	uint8_t cells[4 * GRID_CELLS];
+	uint16_t n = 0;
+
+	for (uint8_t r = 0; r < GRID_ROWS; r++) {
+		for (uint8_t c = 0; c < GRID_COLS; c++) {
+			if (!BITMAP_GET(game.enemyConfirmedHitBitmap, r, c))
+				continue;
+			for (uint8_t d = 0; d < 4; d++) {
+				int8_t nr = r + DR[d], nc = c + DC[d];
+				if (nr >= 0 && nr < GRID_ROWS && nc >= 0 && nc < GRID_COLS
+					&& !BITMAP_GET(game.enemyAttackedAtBitmap, nr, nc))
+					cells[n++] = nr * GRID_COLS + nc;
+			}
+		}
+	}
+	for (uint8_t pass = 0; pass < 2 && !n; pass++) {
+		for (uint8_t r = 0; r < GRID_ROWS; r++)
+			for (uint8_t c = 0; c < GRID_COLS; c++)
+				if ((pass || (r + c) % 2 == 0) && !BITMAP_GET(game.enemyAttackedAtBitmap, r, c))
+					cells[n++] = r * GRID_COLS + c;
+	}
+
+	uint8_t pick = cells[rng_below(&p->rng, n)];
+	p->aimRow = pick / GRID_COLS;
+	p->aimCol = pick % GRID_COLS;
+	p->aimScan = game.radarLeft && game.peerRadar && rng_chance(&p->rng, p->scanChance);
+}
+
+static void on_my_turn(Pilot *p) {
+	if (p->aimRow < 0)
+		aim(p);
+	if (steer(p, p->aimRow, p->aimCol)) {
+		press(p, p->aimScan ? HOLD_NS : TAP_NS);
+		p->aimRow = p->aimCol = -1;
+	}
+}
+
+/**
+ * Tap until the firmware leaves the end screen: a tap made while it is still
+ * drawing (or sounding) the end screen is never seen.
+ */
+static void on_over(Pilot *p) {
+	press(p, TAP_NS);
+	p->busyUntil += OVER_GAP_NS;
+}
+
+void pilot_step(Pilot *p) {
+	track(p);
+	if (p->passive || board.now < p->busyUntil)
+		return;
+
+	switch (game.gState) {
+		case GS_MAINMENU:
+			on_menu(p);
+			break;
+		case GS_PLACING:
+			on_placing(p);
+			break;
+		case GS_MYTURN:
+			on_my_turn(p);
+			break;
+		case GS_OVER:
+			on_over(p);
+			break;
+		case GS_SETTINGS:		/* Not visited by the pilot */
+		case GS_RESET:
+		case GS_NEWGAME:
+		case GS_WAIT:
+		case GS_WAITRES:
+		case GS_ENEMYTURN:
+			centre(p);
+			break;
+	}
+}
+
+uint32_t pilot_answer_ms(const PilotStats *s, uint8_t pct) {
+	uint32_t need = (s->answers * pct + 99) / 100, seen = 0;
+	for (uint8_t b = 0; b < PILOT_TURN_BUCKETS; b++) {
+		seen += s->answerHist[b];
+		if (seen >= need)
+			return 1u << b;
+	}
+	return 1u << (PILOT_TURN_BUCKETS - 1);
+}
+
+void pilot_stats_add(PilotStats *sum, const PilotStats *s) {
+	sum->games += s->games;
+	sum->wins += s->wins;
+	sum->aborted += s->aborted;
+	sum->shots += s->shots;
+	sum->scans += s->scans;
+	sum->gameNs += s->gameNs;
+	sum->answers += s->answers;
+	sum->answerNsSum += s->answerNsSum;
+	if (s->answerNsMax > sum->answerNsMax)
+		sum->answerNsMax = s->answerNsMax;
+	for (uint8_t b = 0; b < PILOT_TURN_BUCKETS; b++)
+		sum->answerHist[b] += s->answerHist[b];
+}
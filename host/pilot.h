@@ -0,0 +1,68 @@
+/* ---------------------------------------------------------------------------
+ * pilot.h - Plays the game on a simulated board through its stick and button
+ *
+ * The pilot looks at the live board's `game` and moves the stick and presses
+ * the button the way a player would: it picks a mode from the menu, places
+ * the fleet (rotating with a long press), fires at cells it chooses, and taps
+ * through the end screen to start again. Every input can be written out as a
+ * script (see script.h) that replays the same game.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_PILOT_H
+#define HOST_PILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define PILOT_TURN_BUCKETS	16
+
+typedef struct {
+	uint32_t games;			/* Games played to the end screen */
+	uint32_t wins;
+	uint32_t aborted;		/* Back at the menu without an end screen (peer lost) */
+	uint32_t shots;
+	uint32_t scans;
+	uint64_t gameNs;		/* Virtual time spent in games (placing to end screen) */
+	/* Our move to its answer (attack or scan to the result on screen) */
+	uint32_t answers;
+	uint64_t answerNsSum;
+	uint64_t answerNsMax;
+	uint32_t answerHist[PILOT_TURN_BUCKETS];	/* Powers of two from 1 ms */
+} PilotStats;
+
+typedef struct {
+	uint64_t	rng;
+	bool		versusAi;		/* Pick "Versus AI" from the menu, else multiplayer */
+	double		scanChance;		/* Chance to scan instead of firing while scans are left */
+	uint32_t	gamesLeft;		/* Stop at the menu after this many games */
+	FILE		*record;		/* Inputs as a script, or NULL */
+	bool		passive;		/* Only keep statistics (a script drives the board) */
+
+	/* Progress */
+	uint64_t	busyUntil;		/* A press in flight */
+	uint8_t		stickX, stickY;	/* Direction held: 0 low, 1 centre, 2 high */
+	int8_t		planIdx;		/* Ship the placement plan is for, -1 none */
+	uint8_t		planRow, planCol;
+	bool		planHorizontal;
+	int8_t		aimRow, aimCol;	/* Cell this turn fires at, -1 none */
+	bool		aimScan;
+	bool		inGame;
+	bool		overSeen;
+	uint8_t		lastState;		/* game.gState at the last step */
+	uint64_t	gameStart;
+	uint64_t	movedAt;		/* Our last attack or scan went out */
+	uint64_t	lastProgress;	/* Last game end or start, for stall checks */
+
+	PilotStats	stats;
+} Pilot;
+
+void pilot_init(Pilot *p, bool versusAi, uint32_t games, uint64_t seed);
+/* Act on the live board; call at least once per virtual millisecond */
+void pilot_step(Pilot *p);
+/* True once the pilot has played its games and sits at the menu */
+bool pilot_done(const Pilot *p);
+/* Percentile (0..100) of the answer time histogram, as a bucket bound in ms */
+uint32_t pilot_answer_ms(const PilotStats *s, uint8_t pct);
+void pilot_stats_add(PilotStats *sum, const PilotStats *s);
+
+#endif
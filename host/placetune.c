@@ -0,0 +1,241 @@
+/* ---------------------------------------------------------------------------
+ * placetune.c - How long the AI's fleet survives, per placement setting
+ *
+ *     placetune [-g fleets] [-s seed] [-k samples,...] [-t touch,...]
+ *
+ * Runs the firmware's ai_place_random() on the "tune" image (built with
+ * -DAI_PLACE_TUNE, so AI_PLACE_SAMPLES and AI_PLACE_TOUCH can be set between
+ * fleets) and counts the shots two hunters need to sink each fleet:
+ *
+ *   hunt/target   shoots a random cell of one checkerboard colour, and after
+ *                 a hit the cells next to it until those run out
+ *   density       shoots the unshot cell the most ship placements cover
+ *                 (around the misses), a placement through n hits counting
+ *                 HIT_WEIGHT^n
+ *
+ * Neither is told when a ship sinks; nor is the firmware's player. Each
+ * fleet is seeded the way the firmware seeds it (ADC channels 3 and 4), and
+ * the same -g seeds and hunter draws are used for every setting, so the
+ * settings differ only in their fleets. One line per (-t, -k) pair: the
+ * mean shots to sink the fleet and its standard error. The defaults are the
+ * firmware's: samples 1, 8 and 16 (Easy, Medium, Hard) at touch 1000.
+ *
+ *     host/placetune -g 8000 -k 16 -t 0,200,400,700,1000    # tune the touch score
+ *     host/placetune -g 8000 -k 1,2,4,8,16,32,64            # and the sample counts
+ * --------------------------------------------------------------------------- */
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "rng.h"
+
+#include "battleship_utils.h"
+
+#define MAX_VALUES	16
+#define HIT_WEIGHT	20
+
+/* From singleplayer.c (its header defines its globals, so it can't be
+ * included here); the settings are writable in the tune image only */
+extern uint8_t	AI_PLACE_SAMPLES[AI_HARD + 1];
+extern uint16_t AI_PLACE_TOUCH;
+extern uint8_t	aiOccupiedBitmap[BITMAP_SIZE];
+void			ai_place_random(void);
+
+typedef struct {
+	double	 sum, sumSq;
+	uint32_t n;
+} Mean;
+
+typedef struct {
+	uint16_t ship[GRID_ROWS];			/* The fleet, row words */
+	uint16_t hit[GRID_ROWS], miss[GRID_ROWS];
+	uint8_t	 left;						/* Ship cells not hit yet */
+	uint16_t shots;
+} Hunt;
+
+static void add(Mean *m, double v) {
+	m->sum += v;
+	m->sumSq += v * v;
+	m->n++;
+}
+
+static bool shot_at(const Hunt *h, uint8_t r, uint8_t c) {
+	return ((h->hit[r] | h->miss[r]) >> c) & 1;
+}
+
+static bool fire(Hunt *h, uint8_t r, uint8_t c) {
+	h->shots++;
+	if ((h->ship[r] >> c) & 1) {
+		h->hit[r] |= 1u << c;
+		h->left--;
+		return true;
+	}
+	h->miss[r] |= 1u << c;
+	return false;
+}
+
+/* Uniform over the unshot cells (of one colour if `parity`); false if there are none */
+static bool random_cell(const Hunt *h, uint64_t *rng, bool parity, uint8_t *r, uint8_t *c) {
+	uint8_t cells[GRID_CELLS], n = 0;
+	for (uint8_t i = 0; i < GRID_CELLS; i++)
+		if (!shot_at(h, i / GRID_COLS, i % GRID_COLS) && (!parity || (i / GRID_COLS + i % GRID_COLS) % 2 == 0))
+			cells[n++] = i;
+	if (!n)
+		return false;
+	uint8_t pick = cells[rng_below(rng, n)];
+	*r = pick / GRID_COLS;
+	*c = pick % GRID_COLS;
+	return true;
+}
+
+static void hunt_target(Hunt *h, uint64_t *rng) {
+	static const int8_t STEP[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+	uint8_t stack[4 * GRID_CELLS], depth = 0;
+	while (h->left) {
+		uint8_t r, c;
+		if (depth) {
+			uint8_t cell = stack[--depth];
+			r = cell / GRID_COLS;
+			c = cell % GRID_COLS;
+			if (shot_at(h, r, c))
+				continue;
+		} else if (!random_cell(h, rng, true, &r, &c)) {
+			random_cell(h, rng, false, &r, &c);
+		}
+		if (!fire(h, r, c))
+			continue;
+		for (uint8_t d = 0; d < 4; d++) {
+			int8_t nr = (int8_t)r + STEP[d][0], nc = (int8_t)c + STEP[d][1];
+			if (nr >= 0 && nr < GRID_ROWS && nc >= 0 && nc < GRID_COLS && !shot_at(h, nr, nc))
+				stack[depth++] = (uint8_t)(nr * GRID_COLS + nc);
+		}
+	}
+}
+
+static void density(Hunt *h, uint64_t *rng) {
+	while (h->left) {
+		double weight[GRID_ROWS][GRID_COLS] = { { 0 } };
+		for (uint8_t s = 0; s < NUM_SHIPS; s++) {
+			uint8_t len = SHIP_LENGTHS[s];
+			for (uint8_t r = 0; r < GRID_ROWS; r++) {
+				for (uint8_t v = 0; v < 2; v++) {
+					uint16_t fit = ship_fit_row(h->miss, r, len, !v);
+					for (uint8_t c = 0; fit; c++, fit >>= 1) {
+						if (!(fit & 1))
+							continue;
+						uint16_t span = v ? 1u << c : ((1u << len) - 1) << c;
+						uint8_t hits = 0;
+						for (uint8_t k = r; k < r + (v ? len : 1); k++)
+							hits += __builtin_popcount(h->hit[k] & span);
+						if (hits == len)
+							continue;
+						double w = pow(HIT_WEIGHT, hits);
+						for (uint8_t k = 0; k < len; k++)
+							weight[r + (v ? k : 0)][c + (v ? 0 : k)] += w;
+					}
+				}
+			}
+		}
+		/* Best unshot cell, ties broken at random */
+		double best = -1;
+		uint8_t br = 0, bc = 0, ties = 0;
+		for (uint8_t r = 0; r < GRID_ROWS; r++) {
+			for (uint8_t c = 0; c < GRID_COLS; c++) {
+				if (shot_at(h, r, c) || weight[r][c] < best)
+					continue;
+				ties = weight[r][c] > best ? 1 : ties + 1;
+				best = weight[r][c];
+				if (ties == 1 || rng_below(rng, ties) == 0)
+					br = r, bc = c;
+			}
+		}
+		fire(h, br, bc);
+	}
+}
+
+/* The firmware's fleet for one seed, as row words */
+static void place(uint16_t adc3, uint16_t adc4, AIDifficulty level, uint16_t ship[GRID_ROWS]) {
+	board.adc[3] = adc3;
+	board.adc[4] = adc4;
+	aiDifficulty = level;
+	ai_place_random();
+	for (uint8_t r = 0; r < GRID_ROWS; r++) {
+		ship[r] = 0;
+		for (uint8_t c = 0; c < GRID_COLS; c++)
+			if (BITMAP_GET(aiOccupiedBitmap, r, c))
+				ship[r] |= 1u << c;
+	}
+}
+
+static uint8_t parse_list(const char *s, uint32_t *out) {
+	uint8_t n = 0;
+	for (char *end; *s && n < MAX_VALUES; s = *end ? end + 1 : end)
+		out[n++] = (uint32_t)strtoul(s, &end, 0);
+	return n;
+}
+
+static void print_mean(const Mean *m) {
+	double mean = m->sum / m->n, var = m->sumSq / m->n - mean * mean;
+	printf("  %6.2f +- %4.2f", mean, sqrt(var > 0 ? var / m->n : 0));
+}
+
+int main(int argc, char **argv) {
+	uint32_t fleets = 2000, samples[MAX_VALUES] = { 1, 8, 16 }, touches[MAX_VALUES] = { 1000 };
+	uint8_t nSamples = 3, nTouches = 1;
+	uint64_t seed = 1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "g:s:k:t:")) != -1) {
+		switch (opt) {
+			case 'g': fleets = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 's': seed = strtoull(optarg, NULL, 0); break;
+			case 'k': nSamples = parse_list(optarg, samples); break;
+			case 't': nTouches = parse_list(optarg, touches); break;
+			default:
+				fprintf(stderr, "usage: %s [-g fleets] [-s seed] [-k samples,...] [-t touch,...]\n", argv[0]);
+				return 2;
+		}
+	}
+	for (uint8_t i = 0; i < nSamples; i++) {
+		if (samples[i] < 1 || samples[i] > 255) {
+			fprintf(stderr, "samples are 1 to 255\n");
+			return 2;
+		}
+	}
+
+	board_power_on();
+	printf("touch  samples       hunt/target           density\n");
+	for (uint8_t t = 0; t < nTouches; t++) {
+		for (uint8_t k = 0; k < nSamples; k++) {
+			AI_PLACE_TOUCH = (uint16_t)touches[t];
+			AI_PLACE_SAMPLES[AI_HARD] = (uint8_t)samples[k];
+			Mean hunters[2] = { { 0 } };
+			uint64_t rng = seed;
+			for (uint32_t g = 0; g < fleets; g++) {
+				uint16_t adc3 = (uint16_t)rng_below(&rng, 1024), adc4 = (uint16_t)rng_below(&rng, 1024);
+				uint64_t draws = rng_next(&rng);
+				Hunt h = { .left = 0 };
+				place(adc3, adc4, AI_HARD, h.ship);
+				for (uint8_t r = 0; r < GRID_ROWS; r++)
+					h.left += __builtin_popcount(h.ship[r]);
+
+				Hunt run = h;
+				uint64_t hunterRng = draws;
+				hunt_target(&run, &hunterRng);
+				add(&hunters[0], run.shots);
+				run = h;
+				hunterRng = draws;
+				density(&run, &hunterRng);
+				add(&hunters[1], run.shots);
+			}
+			printf("%5u  %7u", touches[t], samples[k]);
+			print_mean(&hunters[0]);
+			print_mean(&hunters[1]);
+			printf("\n");
+		}
+	}
+	return 0;
+}
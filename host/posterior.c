@@ -0,0 +1,489 @@
+/* ---------------------------------------------------------------------------
+ * posterior.c - Exact hit probabilities from what one side has seen
+ * --------------------------------------------------------------------------- */
+#include "posterior.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PLACEMENTS	(2 * GRID_CELLS)
+#define SLICE_BITS		48				/* Bit-sliced counters: up to 2^48 fleets per thread */
+#define CACHE_MAGIC		"POSTERIOR1"
+
+typedef struct {
+	uint8_t	 len;
+	bool	 same;				/* Same length as the ship before: placed after it */
+	uint16_t n;
+	Cells	 at[MAX_PLACEMENTS];
+} Placements;
+
+static Placements ships[POST_MAX_SHIPS];
+static uint8_t shipCount;
+static uint8_t restCells[POST_MAX_SHIPS + 1];	/* Cells of ships k and after */
+
+static inline Cells cell(uint8_t row, uint8_t col) {
+	return (Cells)1 << (row * GRID_COLS + col);
+}
+
+static inline uint8_t count_cells(Cells c) {
+	return (uint8_t)(__builtin_popcountll((uint64_t)c) + __builtin_popcountll((uint64_t)(c >> 64)));
+}
+
+/* Lowest cell of a non-empty set */
+static inline uint8_t first_cell(Cells c) {
+	uint64_t lo = (uint64_t)c;
+	return lo ? (uint8_t)__builtin_ctzll(lo) : (uint8_t)(64 + __builtin_ctzll((uint64_t)(c >> 64)));
+}
+
+void posterior_fleet(const uint8_t *lengths, uint8_t count) {
+	if (count > POST_MAX_SHIPS)
+		count = POST_MAX_SHIPS;
+	uint8_t sorted[POST_MAX_SHIPS];
+	memcpy(sorted, lengths, count);
+	for (uint8_t i = 1; i < count; i++)		/* Longest first: fewest placements near the root */
+		for (uint8_t k = i; k > 0 && sorted[k] > sorted[k - 1]; k--) {
+			uint8_t t = sorted[k];
+			sorted[k] = sorted[k - 1];
+			sorted[k - 1] = t;
+		}
+
+	shipCount = count;
+	restCells[count] = 0;
+	for (int8_t k = (int8_t)count - 1; k >= 0; k--)
+		restCells[k] = restCells[k + 1] + sorted[k];
+	for (uint8_t k = 0; k < count; k++) {
+		Placements *s = &ships[k];
+		s->len = sorted[k];
+		s->same = k && sorted[k] == sorted[k - 1];
+		s->n = 0;
+		for (uint8_t horizontal = 0; horizontal < 2; horizontal++) {
+			for (uint8_t r = 0; r + (horizontal ? 1 : s->len) <= GRID_ROWS; r++) {
+				for (uint8_t c = 0; c + (horizontal ? s->len : 1) <= GRID_COLS; c++) {
+					Cells at = 0;
+					for (uint8_t i = 0; i < s->len; i++)
+						at |= horizontal ? cell(r, c + i) : cell(r + i, c);
+					s->at[s->n++] = at;
+				}
+			}
+		}
+	}
+}
+
+void position_clear(Position *pos) {
+	memset(pos, 0, sizeof(*pos));
+}
+
+void position_shot(Position *pos, uint8_t row, uint8_t col, bool hit) {
+	if (row >= GRID_ROWS || col >= GRID_COLS)
+		return;
+	if (hit)
+		pos->hit |= cell(row, col);
+	else
+		pos->miss |= cell(row, col);
+}
+
+bool position_scan(Position *pos, uint8_t row, uint8_t col, uint8_t count) {
+	if (pos->scans >= POST_MAX_SCANS || row >= GRID_ROWS || col >= GRID_COLS)
+		return false;
+	pos->scan[pos->scans++] = (PostScan){ row, col, count };
+	return true;
+}
+
+/* -------------------------------------------------------------------------
+ *  ENUMERATION
+ * ------------------------------------------------------------------------- */
+typedef struct {
+	const Position *pos;
+	Cells	 area[POST_MAX_SCANS];			/* Each scan's 3x3, clipped to the board */
+	uint16_t n[POST_MAX_SHIPS];				/* Placements clear of the misses */
+	Cells	 at[POST_MAX_SHIPS][MAX_PLACEMENTS];
+	uint32_t tasks;							/* First two ships' placement pairs */
+	uint32_t next;							/* Next task to take (atomic) */
+	/* Last ship by masks (see place_last): free cells and where it may start */
+	bool	 byMask;
+	Cells	 open, startH, startV;
+	/* The last ship's placements over each cell, for a hit it has to cover */
+	uint8_t	 overN[GRID_CELLS];
+	uint16_t over[GRID_CELLS][2 * POST_MAX_LENGTH];
+} Job;
+
+typedef struct {
+	Job		  *job;
+	pthread_t thread;
+	uint64_t  fleets;
+	uint64_t  weight[POST_MAX_SHIPS][MAX_PLACEMENTS];	/* Fleets each placement is in */
+	Cells	  sliceH[SLICE_BITS], sliceV[SLICE_BITS];	/* The last ship's, by start cell, bit p of each count in [p] */
+} Worker;
+
+/**
+ * Whether ship cells `occ` can still match every scan, with ships k and on
+ * to place (exactly, once they are all placed).
+ */
+static bool scans_allow(const Job *j, Cells occ, uint8_t k) {
+	for (uint8_t s = 0; s < j->pos->scans; s++) {
+		uint8_t have = count_cells(occ & j->area[s]), want = j->pos->scan[s].count;
+		if (have > want || (k == shipCount ? have != want : want - have > restCells[k]))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Add one to the bit-sliced counter of every cell in `add`.
+ */
+static inline void slice_add(Cells slice[SLICE_BITS], Cells add) {
+	for (uint8_t b = 0; add && b < SLICE_BITS; b++) {
+		Cells carry = slice[b] & add;
+		slice[b] ^= add;
+		add = carry;
+	}
+}
+
+/**
+ * The last ship with nothing left to cover and no scans: every start whose
+ * cells are all free is one fleet. The starts come out as two masks, counted
+ * into the bit-sliced counters rather than one placement at a time.
+ */
+static uint64_t place_last(Worker *w, Cells occ) {
+	const Job *j = w->job;
+	uint8_t len = ships[shipCount - 1].len;
+	Cells free = j->open & ~occ, h = free & j->startH, v = free & j->startV;
+	for (uint8_t i = 1; i < len; i++) {
+		h &= free >> i;
+		v &= free >> (i * GRID_COLS);
+	}
+	slice_add(w->sliceH, h);
+	slice_add(w->sliceV, v);
+	return count_cells(h) + count_cells(v);
+}
+
+/**
+ * Fleets that complete `occ` with ships k and on; ship k starts after
+ * placement `from` if it has the length of ship k - 1.
+ */
+static uint64_t place(Worker *w, uint8_t k, Cells occ, uint16_t from) {
+	const Job *j = w->job;
+	Cells need = j->pos->hit & ~occ;
+	if (k == shipCount)
+		return !need && scans_allow(j, occ, k);
+	if (count_cells(need) > restCells[k])
+		return 0;
+
+	bool scans = j->pos->scans;
+	uint64_t total = 0;
+	uint16_t i = ships[k].same ? from + 1 : 0;
+	if (k == shipCount - 1) {		/* Last ship: each placement is one fleet or none */
+		if (j->byMask && !need)
+			return place_last(w, occ);
+		if (need) {					/* Only the placements over its first hit cell */
+			uint8_t first = first_cell(need);
+			for (uint8_t o = 0; o < j->overN[first]; o++) {
+				uint16_t at = j->over[first][o];
+				Cells p = j->at[k][at];
+				if (at < i || (p & occ) || (need & ~p) || (scans && !scans_allow(j, occ | p, k + 1)))
+					continue;
+				w->weight[k][at]++;
+				total++;
+			}
+			return total;
+		}
+		for (; i < j->n[k]; i++) {
+			Cells p = j->at[k][i];
+			if ((p & occ) || (scans && !scans_allow(j, occ | p, k + 1)))
+				continue;
+			w->weight[k][i]++;
+			total++;
+		}
+		return total;
+	}
+	for (; i < j->n[k]; i++) {
+		Cells p = j->at[k][i];
+		if ((p & occ) || (scans && !scans_allow(j, occ | p, k + 1)))
+			continue;
+		uint64_t c = place(w, k + 1, occ | p, i);
+		w->weight[k][i] += c;
+		total += c;
+	}
+	return total;
+}
+
+static void *work(void *arg) {
+	Worker *w = arg;
+	Job *j = w->job;
+	uint16_t n1 = shipCount > 1 ? j->n[1] : 1;
+	for (;;) {
+		uint32_t t = __atomic_fetch_add(&j->next, 1, __ATOMIC_RELAXED);
+		if (t >= j->tasks)
+			break;
+		uint16_t a = (uint16_t)(t / n1), b = (uint16_t)(t % n1);
+		Cells occ = j->at[0][a];
+		uint64_t c;
+		if (shipCount > 1) {
+			if ((ships[1].same && b <= a) || (j->at[1][b] & occ))
+				continue;
+			occ |= j->at[1][b];
+			c = place(w, 2, occ, b);
+			w->weight[1][b] += c;
+		} else {
+			c = place(w, 1, occ, a);
+		}
+		w->weight[0][a] += c;
+		w->fleets += c;
+	}
+	return NULL;
+}
+
+static void enumerate(const Position *pos, unsigned threads, Posterior *out) {
+	Job *j = calloc(1, sizeof(Job));
+	j->pos = pos;
+	for (uint8_t s = 0; s < pos->scans; s++) {
+		const PostScan *sc = &pos->scan[s];
+		for (int r = sc->row - RADAR_RADIUS; r <= sc->row + RADAR_RADIUS; r++)
+			for (int c = sc->col - RADAR_RADIUS; c <= sc->col + RADAR_RADIUS; c++)
+				if (r >= 0 && r < GRID_ROWS && c >= 0 && c < GRID_COLS)
+					j->area[s] |= cell((uint8_t)r, (uint8_t)c);
+	}
+	for (uint8_t k = 0; k < shipCount; k++)
+		for (uint16_t i = 0; i < ships[k].n; i++)
+			if (!(ships[k].at[i] & pos->miss))
+				j->at[k][j->n[k]++] = ships[k].at[i];
+	j->tasks = shipCount ? (uint32_t)j->n[0] * (shipCount > 1 ? j->n[1] : 1) : 0;
+
+	if (shipCount) {
+		uint8_t last = shipCount - 1;
+		for (uint16_t i = 0; i < j->n[last]; i++)
+			for (Cells p = j->at[last][i]; p; p &= p - 1)
+				j->over[first_cell(p)][j->overN[first_cell(p)]++] = i;
+	}
+
+	/* Masks for the last ship: not with scans to match, nor after a ship of its length */
+	j->byMask = shipCount > 2 && !pos->scans && !ships[shipCount - 1].same;
+	if (j->byMask) {
+		uint8_t len = ships[shipCount - 1].len;
+		for (uint8_t r = 0; r < GRID_ROWS; r++) {
+			for (uint8_t c = 0; c < GRID_COLS; c++) {
+				if (!((pos->miss >> (r * GRID_COLS + c)) & 1))
+					j->open |= cell(r, c);
+				if (c + len <= GRID_COLS)
+					j->startH |= cell(r, c);
+				if (r + len <= GRID_ROWS)
+					j->startV |= cell(r, c);
+			}
+		}
+	}
+
+	if (threads < 1)
+		threads = 1;
+	Worker *w = calloc(threads, sizeof(Worker));
+	for (unsigned t = 0; t < threads; t++) {
+		w[t].job = j;
+		if (t && pthread_create(&w[t].thread, NULL, work, &w[t]))
+			w[t].job = NULL;		/* Left to the others */
+	}
+	work(&w[0]);
+
+	memset(out, 0, sizeof(*out));
+	for (unsigned t = 0; t < threads; t++) {
+		if (t && w[t].job)
+			pthread_join(w[t].thread, NULL);
+		out->fleets += w[t].fleets;
+		for (uint8_t k = 0; k < shipCount; k++) {
+			for (uint16_t i = 0; i < j->n[k]; i++) {
+				if (!w[t].weight[k][i])
+					continue;
+				for (Cells p = j->at[k][i]; p; p &= p - 1)
+					out->cover[first_cell(p)] += w[t].weight[k][i];
+			}
+		}
+		for (uint8_t b = 0; j->byMask && b < SLICE_BITS; b++) {
+			uint8_t len = ships[shipCount - 1].len;
+			for (uint8_t i = 0; i < GRID_CELLS; i++) {
+				uint64_t n = 1ULL << b;
+				if ((w[t].sliceH[b] >> i) & 1)
+					for (uint8_t k = 0; k < len; k++)
+						out->cover[i + k] += n;
+				if ((w[t].sliceV[b] >> i) & 1)
+					for (uint8_t k = 0; k < len; k++)
+						out->cover[i + k * GRID_COLS] += n;
+			}
+		}
+	}
+	if (!shipCount)
+		out->fleets = !pos->hit;
+	free(w);
+	free(j);
+}
+
+/* -------------------------------------------------------------------------
+ *  CACHE
+ * ------------------------------------------------------------------------- */
+typedef struct {
+	uint64_t hit[2], miss[2];
+	uint8_t	 scan[POST_MAX_SCANS][3];
+	uint8_t	 scans;
+	uint8_t	 pad[3];
+} Key;
+
+typedef struct {
+	Key		  key;
+	Posterior post;
+} Entry;
+
+struct PostCache {
+	Entry	 *slots;			/* Open addressing; key.scans 0xFF marks a free slot */
+	uint32_t cap, used;
+	FILE	 *file;
+	uint64_t hits, misses;
+};
+
+static void make_key(Key *k, const Position *pos) {
+	memset(k, 0, sizeof(*k));
+	k->hit[0] = (uint64_t)pos->hit, k->hit[1] = (uint64_t)(pos->hit >> 64);
+	k->miss[0] = (uint64_t)pos->miss, k->miss[1] = (uint64_t)(pos->miss >> 64);
+	k->scans = pos->scans;
+	for (uint8_t s = 0; s < pos->scans; s++) {
+		k->scan[s][0] = pos->scan[s].row;
+		k->scan[s][1] = pos->scan[s].col;
+		k->scan[s][2] = pos->scan[s].count;
+	}
+}
+
+static uint32_t hash_key(const Key *k) {
+	const uint8_t *b = (const uint8_t *)k;
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < sizeof(*k); i++)
+		h = (h ^ b[i]) * 16777619u;
+	return h;
+}
+
+static Entry *slot(PostCache *c, const Key *k) {
+	for (uint32_t i = hash_key(k);; i++) {
+		Entry *e = &c->slots[i & (c->cap - 1)];
+		if (e->key.scans == 0xFF || !memcmp(&e->key, k, sizeof(*k)))
+			return e;
+	}
+}
+
+static void insert(PostCache *c, const Key *k, const Posterior *p) {
+	if (2 * (c->used + 1) > c->cap) {
+		Entry *old = c->slots;
+		uint32_t oldCap = c->cap;
+		c->cap = oldCap ? 2 * oldCap : 64;
+		c->slots = malloc(c->cap * sizeof(Entry));
+		for (uint32_t i = 0; i < c->cap; i++)
+			c->slots[i].key.scans = 0xFF;
+		for (uint32_t i = 0; i < oldCap; i++)
+			if (old[i].key.scans != 0xFF)
+				*slot(c, &old[i].key) = old[i];
+		free(old);
+	}
+	Entry *e = slot(c, k);
+	if (e->key.scans == 0xFF)
+		c->used++;
+	e->key = *k;
+	e->post = *p;
+}
+
+/**
+ * The header a cache file starts with: the fleet its counts are for.
+ */
+static void header(char out[32]) {
+	memset(out, 0, 32);
+	memcpy(out, CACHE_MAGIC, sizeof(CACHE_MAGIC) - 1);
+	for (uint8_t k = 0; k < shipCount; k++)
+		out[sizeof(CACHE_MAGIC) + k] = (char)ships[k].len;
+}
+
+PostCache *posterior_cache_open(const char *path) {
+	PostCache *c = calloc(1, sizeof(PostCache));
+	if (!path)
+		return c;
+
+	char want[32], have[32];
+	header(want);
+	c->file = fopen(path, "a+b");
+	if (!c->file) {
+		perror(path);
+		return c;
+	}
+	rewind(c->file);
+	if (fread(have, 1, sizeof(have), c->file) != sizeof(have)) {
+		fwrite(want, 1, sizeof(want), c->file);		/* New (or torn): append mode writes at the end */
+	} else if (memcmp(have, want, sizeof(want))) {
+		fprintf(stderr, "%s: cached for another fleet, not used\n", path);
+		fclose(c->file);
+		c->file = NULL;
+		return c;
+	}
+	Entry e;
+	while (fread(&e, sizeof(e), 1, c->file) == 1)
+		insert(c, &e.key, &e.post);
+	return c;
+}
+
+void posterior_cache_close(PostCache *c) {
+	if (!c)
+		return;
+	if (c->file)
+		fclose(c->file);
+	free(c->slots);
+	free(c);
+}
+
+void posterior_cache_stats(const PostCache *c, uint64_t *hits, uint64_t *misses) {
+	*hits = c ? c->hits : 0;
+	*misses = c ? c->misses : 0;
+}
+
+/* -------------------------------------------------------------------------
+ *  QUERIES
+ * ------------------------------------------------------------------------- */
+void posterior_solve(PostCache *cache, const Position *pos, unsigned threads, Posterior *out) {
+	Key k;
+	make_key(&k, pos);
+	if (cache && cache->cap) {
+		Entry *e = slot(cache, &k);
+		if (e->key.scans != 0xFF) {
+			*out = e->post;
+			cache->hits++;
+			return;
+		}
+	}
+
+	enumerate(pos, threads, out);
+	if (!cache)
+		return;
+	cache->misses++;
+	insert(cache, &k, out);
+	if (cache->file) {
+		Entry e = { k, *out };
+		fwrite(&e, sizeof(e), 1, cache->file);
+		fflush(cache->file);
+	}
+}
+
+double posterior_p(const Posterior *p, uint8_t row, uint8_t col) {
+	return p->fleets ? (double)p->cover[row * GRID_COLS + col] / p->fleets : 0.0;
+}
+
+ShotScore posterior_score(const Posterior *p, const Position *pos, uint8_t row, uint8_t col) {
+	ShotScore s = { .rank = 1 };
+	uint8_t shot = row * GRID_COLS + col;
+	uint64_t best = 0;
+	bool any = false;
+	for (uint8_t i = 0; i < GRID_CELLS; i++) {
+		if (((pos->hit | pos->miss) >> i) & 1)
+			continue;
+		if (!any || p->cover[i] > best) {
+			best = p->cover[i];
+			s.best = i;
+			any = true;
+		}
+		s.rank += p->cover[i] > p->cover[shot];
+	}
+	s.pBest = p->fleets ? (double)best / p->fleets : 0.0;
+	s.pShot = p->fleets ? (double)p->cover[shot] / p->fleets : 0.0;
+	return s;
+}
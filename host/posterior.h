@@ -0,0 +1,78 @@
+/* ---------------------------------------------------------------------------
+ * posterior.h - Exact hit probabilities from what one side has seen
+ *
+ * Counts every fleet (one placement per ship, no overlaps) that agrees with a
+ * position: no ship on a miss, a ship on every hit, and each radar scan's
+ * count of ship cells in its 3x3 area. Ships of the same length are one
+ * unordered set, so the opening has 15,046,987,768 fleets of {5,4,3,3,2}.
+ * A cell's hit probability is the share of those fleets with a ship on it.
+ *
+ * Ships are placed longest first over 128-bit cell masks. The first two
+ * ships' placement pairs are the work items, taken in turn by each thread
+ * from a shared counter, so a thread that draws cheap pairs takes more. Each
+ * placement keeps the count of fleets it completes; cell counts are summed
+ * from those at the end, so a fleet costs one add rather than one per cell.
+ *
+ * Solved positions are cached under their hits, misses and scans. Every game
+ * asks for the same opening and the same early prefixes of its shots, so a
+ * cache kept in a file (posterior_cache_open) pays for them once.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_POSTERIOR_H
+#define HOST_POSTERIOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "battleship_utils.h"
+
+#define POST_MAX_SHIPS	8
+#define POST_MAX_SCANS	4
+#define POST_MAX_LENGTH	10			/* Longest ship */
+
+typedef unsigned __int128 Cells;		/* Bit row * GRID_COLS + col */
+
+typedef struct {
+	uint8_t row, col, count;
+} PostScan;
+
+/* What one side knows of the other's board */
+typedef struct {
+	Cells	 hit, miss;
+	PostScan scan[POST_MAX_SCANS];
+	uint8_t	 scans;
+} Position;
+
+typedef struct {
+	uint64_t fleets;				/* Fleets that agree with the position */
+	uint64_t cover[GRID_CELLS];		/* Of those, the ones with a ship on each cell */
+} Posterior;
+
+/* How good a shot was, against the best one available */
+typedef struct {
+	double	pShot, pBest;			/* Hit probability of the shot and of the best cell */
+	uint8_t	best;					/* Best unshot cell (row * GRID_COLS + col) */
+	uint8_t	rank;					/* 1 + unshot cells strictly more likely than the shot */
+} ShotScore;
+
+typedef struct PostCache PostCache;
+
+/* The fleet to enumerate (e.g. SHIP_LENGTHS); call once before solving */
+void	  posterior_fleet(const uint8_t *lengths, uint8_t count);
+
+void	  position_clear(Position *pos);
+void	  position_shot(Position *pos, uint8_t row, uint8_t col, bool hit);
+bool	  position_scan(Position *pos, uint8_t row, uint8_t col, uint8_t count);
+
+/* Solve `pos` on `threads` threads, from and into `cache` (may be NULL) */
+void	  posterior_solve(PostCache *cache, const Position *pos, unsigned threads, Posterior *out);
+double	  posterior_p(const Posterior *p, uint8_t row, uint8_t col);
+/* Best unshot cell and where the shot at (row, col) stands against it */
+ShotScore posterior_score(const Posterior *p, const Position *pos, uint8_t row, uint8_t col);
+
+/* A cache kept in `path` (NULL: memory only); solves are appended to it */
+PostCache *posterior_cache_open(const char *path);
+void	  posterior_cache_close(PostCache *c);
+/* Lookups answered from the cache, and solves it had to run */
+void	  posterior_cache_stats(const PostCache *c, uint64_t *hits, uint64_t *misses);
+
+#endif
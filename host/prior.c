@@ -0,0 +1,121 @@
+/* ---------------------------------------------------------------------------
+ * prior.c - Generates the Hard AI's opening prior (AI_PRIOR in singleplayer.c)
+ *
+ *     prior [-n boards] [-s seed]
+ *
+ * Places -n fleets (default 2M) the way one ai_sample_fleet() draw does: each
+ * ship, in SHIP_LENGTHS order, at a uniformly random place that fits around
+ * the ships before it (the firmware's own ship_fit_row()). It counts how often
+ * each cell holds a ship, folds the eight symmetries of the board together
+ * (four quadrants, each with its transpose), scales so the busiest cell is
+ * 255, and prints the table as it appears in singleplayer.c. `make test`
+ * checks that the two agree:
+ *
+ *     host/prior > table.txt    # then paste it over AI_PRIOR
+ * --------------------------------------------------------------------------- */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rng.h"
+
+#include "battleship_utils.h"
+
+#define HALF	(GRID_ROWS / 2)
+
+_Static_assert(GRID_ROWS == GRID_COLS && GRID_ROWS % 2 == 0, "The prior quadrant assumes an even square grid");
+
+static uint64_t cells[GRID_ROWS][GRID_COLS];
+
+/**
+ * One fleet, placed ship by ship; false if a ship had nowhere to go (the
+ * firmware throws those away too).
+ */
+static bool place_fleet(uint64_t *rng, uint16_t rows[GRID_ROWS]) {
+	memset(rows, 0, GRID_ROWS * sizeof(uint16_t));
+	for (uint8_t i = 0; i < NUM_SHIPS; i++) {
+		uint8_t len = SHIP_LENGTHS[i];
+		uint16_t fit[GRID_ROWS][2];
+		uint32_t count = 0;
+		for (uint8_t r = 0; r < GRID_ROWS; r++) {
+			fit[r][0] = ship_fit_row(rows, r, len, true);
+			fit[r][1] = ship_fit_row(rows, r, len, false);
+			count += __builtin_popcount(fit[r][0]) + __builtin_popcount(fit[r][1]);
+		}
+		if (!count)
+			return false;
+
+		/* Same order as the firmware's placement codes: row, column, then across before down */
+		uint32_t pick = rng_below(rng, count);
+		for (uint8_t r = 0; r < GRID_ROWS; r++) {
+			for (uint8_t c = 0; c < GRID_COLS; c++) {
+				for (uint8_t v = 0; v < 2; v++) {
+					if (!((fit[r][v] >> c) & 1) || pick--)
+						continue;
+					uint16_t span = v ? 1u << c : ((1u << len) - 1) << c;
+					for (uint8_t k = r; k < r + (v ? len : 1); k++)
+						rows[k] |= span;
+					goto placed;
+				}
+			}
+		}
+	placed:;
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	uint32_t boards = 2000000;
+	uint64_t seed = 1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+			case 'n': boards = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 's': seed = strtoull(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "usage: %s [-n boards] [-s seed]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	uint64_t rng = seed;
+	uint32_t placed = 0;
+	while (placed < boards) {
+		uint16_t rows[GRID_ROWS];
+		if (!place_fleet(&rng, rows))
+			continue;
+		placed++;
+		for (uint8_t r = 0; r < GRID_ROWS; r++)
+			for (uint8_t c = 0; c < GRID_COLS; c++)
+				cells[r][c] += (rows[r] >> c) & 1;
+	}
+
+	uint64_t quad[HALF][HALF], max = 0;
+	for (uint8_t r = 0; r < HALF; r++) {
+		for (uint8_t c = 0; c < HALF; c++) {
+			uint8_t r2 = GRID_ROWS - 1 - r, c2 = GRID_COLS - 1 - c;
+			quad[r][c] = cells[r][c] + cells[r][c2] + cells[r2][c] + cells[r2][c2];
+		}
+	}
+	for (uint8_t r = 0; r < HALF; r++) {
+		for (uint8_t c = 0; c <= r; c++) {
+			quad[r][c] = quad[c][r] = quad[r][c] + quad[c][r];
+			if (quad[r][c] > max)
+				max = quad[r][c];
+		}
+	}
+
+	printf("static const uint8_t AI_PRIOR[PRIOR_HALF][PRIOR_HALF] PROGMEM = {\n");
+	for (uint8_t r = 0; r < HALF; r++) {
+		printf("\t{");
+		for (uint8_t c = 0; c < HALF; c++)
+			printf(" %3u%s", (unsigned)((quad[r][c] * 255 + max / 2) / max), c < HALF - 1 ? "," : " ");
+		printf("},\n");
+	}
+	printf("};\n");
+	fprintf(stderr, "prior: %u boards, corner %.3f and centre %.3f of fleets cover the cell\n", boards,
+			(double)quad[0][0] / 8 / boards, (double)quad[HALF - 1][HALF - 1] / 8 / boards);
+	return 0;
+}
@@ -0,0 +1,37 @@
+/* ---------------------------------------------------------------------------
+ * probe.c - Which firmware function is running (host "draw" image only)
+ * --------------------------------------------------------------------------- */
+#include "probe.h"
+
+#include <stddef.h>
+
+#define PROBE_DEPTH		64
+
+void game_tick(void);
+
+static void		*stack[PROBE_DEPTH];
+static uint8_t	depth;				/* May exceed PROBE_DEPTH; deeper frames aren't kept */
+static uint32_t	ticks;
+
+void __cyg_profile_func_enter(void *fn, void *site) {
+	if (fn == (void *)game_tick)
+		ticks++;
+	if (depth < PROBE_DEPTH)
+		stack[depth] = fn;
+	depth++;
+}
+
+void __cyg_profile_func_exit(void *fn, void *site) {
+	if (depth)
+		depth--;
+}
+
+void probe_site(void **fn, void **caller) {
+	uint8_t top = depth < PROBE_DEPTH ? depth : PROBE_DEPTH;
+	*fn = top >= 1 ? stack[top - 1] : NULL;
+	*caller = top >= 2 ? stack[top - 2] : NULL;
+}
+
+uint32_t probe_tick(void) {
+	return ticks;
+}
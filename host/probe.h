@@ -0,0 +1,20 @@
+/* ---------------------------------------------------------------------------
+ * probe.h - Which firmware function is running (host "draw" image only)
+ *
+ * The draw image is compiled with -finstrument-functions, except for gfx.c
+ * and hal/: every other firmware function pushes itself on a shadow stack on
+ * entry. While a gfx primitive writes pixels, the top of that stack is the
+ * function that asked for them. Linked into the image, so each board keeps
+ * its own stack.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_PROBE_H
+#define HOST_PROBE_H
+
+#include <stdint.h>
+
+/* The innermost instrumented function and the one that called it (NULL if none) */
+void	 probe_site(void **fn, void **caller);
+/* game_tick() passes so far: one per 1 ms pass of the main loop */
+uint32_t probe_tick(void);
+
+#endif
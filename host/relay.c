@@ -0,0 +1,548 @@
+/* ---------------------------------------------------------------------------
+ * relay.c - Carry boards' serial links over TCP, to a relay at the far end
+ *
+ *     relay (-l [addr:]port | -c host:port) (-D device | -p count)...
+ *           [-i report-s] [-v]
+ *
+ * -l        accept the far relay's sessions on this port
+ * -c        dial them to the far relay (and redial when dropped)
+ * -D        a board's serial port (9600 8N1, raw); repeat for more boards
+ * -p        make this many ptys instead, printing "session N pty /dev/pts/M"
+ * -i        print every session's report this often (also on SIGUSR1, exit)
+ * -v        log sessions coming and going
+ *
+ * Session N is the Nth board given on each side: the dialling relay opens
+ * one TCP connection per board and names it with a "RELAY N" line; the
+ * listening one ties it to its own board N. After that the connection
+ * carries the boards' lines as they are.
+ *
+ * Lines go out as soon as their newline is read, all the lines from one read
+ * in one write (TCP_NODELAY). Bytes are never held for a partial line longer
+ * than the serial port takes to deliver it; while a session has no far end,
+ * its board's lines are dropped (the board resends).
+ *
+ * Per session it keeps two histograms: "fwd", from a line's first byte read
+ * to its write to TCP, and "answer", from the board's attack or scan to the
+ * far board's answer coming back, which is the round trip the firmware's
+ * resend timers see.
+ * --------------------------------------------------------------------------- */
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "latency.h"
+
+#define MAX_SESSIONS	256
+#define MAX_PENDING		16				/* Accepted, waiting for their RELAY line */
+#define LINE_MAX		128
+#define OUT_MAX			4096			/* Unsent bytes each way before dropping */
+#define REDIAL_NS		(1000 * NS_PER_MS)
+#define EVENTS			64
+
+/* epoll tags: kind in the low bits, index above */
+enum { TAG_SERIAL, TAG_TCP, TAG_PENDING, TAG_LISTEN };
+#define TAG(kind, i)	((uint64_t)(i) << 2 | (kind))
+
+typedef struct {
+	uint8_t  data[OUT_MAX];
+	uint32_t len;
+} Out;
+
+typedef struct {
+	char	 text[LINE_MAX];
+	uint32_t len;
+	uint64_t start;					/* First byte read */
+} Line;
+
+typedef struct {
+	char	 name[64];				/* Serial port */
+	int		 serial, tcp;			/* -1: closed */
+	bool	 connecting;			/* Dialled, not yet up */
+	Out		 toSerial, toTcp;
+	Line	 up, down;				/* Board to TCP, TCP to board */
+
+	/* The board's move waiting for its answer */
+	bool	 waiting, scan;
+	uint8_t	 row, col;
+	uint64_t movedAt;
+
+	Latency	 fwd, answer;
+	uint32_t linesUp, linesDown;
+	uint32_t dropped;				/* Lines with no far end to go to */
+	uint32_t resends;				/* The board sent its move again */
+	uint32_t connects;				/* Times the far end came up */
+	uint64_t redialAt;
+} Session;
+
+typedef struct {
+	int		 fd;
+	char	 text[32];
+	uint32_t len;
+} Pending;
+
+static Session	sessions[MAX_SESSIONS];
+static uint32_t	sessionCount;
+static Pending	pending[MAX_PENDING];
+static int		epfd, listenFd = -1;
+static struct sockaddr_storage dialAddr;
+static socklen_t dialLen;
+static bool		verbose;
+static volatile sig_atomic_t stop, reportNow;
+
+static void on_signal(int sig) {
+	if (sig == SIGUSR1)
+		reportNow = 1;
+	else
+		stop = 1;
+}
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void watch(int fd, uint32_t events, uint64_t tag, int op) {
+	struct epoll_event ev = { .events = events, .data.u64 = tag };
+	epoll_ctl(epfd, op, fd, &ev);
+}
+
+/* -------------------------------------------------------------------------
+ *  ENDPOINTS
+ * ------------------------------------------------------------------------- */
+static bool make_raw(int fd) {
+	struct termios t;
+	if (tcgetattr(fd, &t) < 0)
+		return false;
+	cfmakeraw(&t);
+	cfsetispeed(&t, B9600);
+	cfsetospeed(&t, B9600);
+	t.c_cflag |= CLOCAL | CREAD;
+	t.c_cflag &= ~(CSTOPB | CRTSCTS);
+	return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+static bool add_serial(const char *path) {
+	if (sessionCount == MAX_SESSIONS)
+		return false;
+	Session *s = &sessions[sessionCount];
+	s->serial = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (s->serial < 0 || !make_raw(s->serial)) {
+		perror(path);
+		return false;
+	}
+	tcflush(s->serial, TCIOFLUSH);
+	snprintf(s->name, sizeof(s->name), "%s", path);
+	s->tcp = -1;
+	sessionCount++;
+	return true;
+}
+
+/**
+ * A pty for a board stand-in (peerbot -D). Its far end stays open here too,
+ * so reads don't fail while nothing is attached.
+ */
+static bool add_pty(void) {
+	if (sessionCount == MAX_SESSIONS)
+		return false;
+	Session *s = &sessions[sessionCount];
+	int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0)
+		return false;
+	const char *name = ptsname(fd);
+	int far = name ? open(name, O_RDWR | O_NOCTTY) : -1;
+	if (far < 0 || !make_raw(far))
+		return false;
+	s->serial = fd;
+	snprintf(s->name, sizeof(s->name), "%s", name);
+	s->tcp = -1;
+	printf("session %u pty %s\n", sessionCount, name);
+	sessionCount++;
+	return true;
+}
+
+static bool parse_addr(const char *spec, bool passive, struct sockaddr_storage *addr, socklen_t *len) {
+	char host[256] = "", *colon;
+	const char *port = spec;
+	if ((colon = strrchr(spec, ':'))) {
+		snprintf(host, sizeof(host), "%.*s", (int)(colon - spec), spec);
+		port = colon + 1;
+	}
+	struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = passive ? AI_PASSIVE : 0 };
+	struct addrinfo *res;
+	if (getaddrinfo(host[0] ? host : NULL, port, &hints, &res))
+		return false;
+	memcpy(addr, res->ai_addr, res->ai_addrlen);
+	*len = res->ai_addrlen;
+	freeaddrinfo(res);
+	return true;
+}
+
+static void tune(int fd) {
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/* -------------------------------------------------------------------------
+ *  SESSIONS
+ * ------------------------------------------------------------------------- */
+static void drop_tcp(Session *s, const char *why) {
+	if (s->tcp < 0)
+		return;
+	if (verbose)
+		fprintf(stderr, "session %ld: %s\n", (long)(s - sessions), why);
+	close(s->tcp);
+	s->tcp = -1;
+	s->connecting = false;
+	s->toTcp.len = 0;
+	s->down.len = 0;
+	s->waiting = false;
+	s->redialAt = now_ns() + REDIAL_NS;
+}
+
+static void connected(Session *s) {
+	s->connecting = false;
+	s->connects++;
+	if (verbose)
+		fprintf(stderr, "session %ld: connected\n", (long)(s - sessions));
+}
+
+static void attach(Session *s, int fd, uint32_t events) {
+	s->tcp = fd;
+	s->toTcp.len = 0;
+	s->down.len = 0;
+	watch(fd, events, TAG(TAG_TCP, s - sessions), EPOLL_CTL_ADD);
+}
+
+static void dial(Session *s) {
+	int fd = socket(dialAddr.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (fd < 0)
+		return;
+	tune(fd);
+	if (connect(fd, (struct sockaddr *)&dialAddr, dialLen) < 0 && errno != EINPROGRESS) {
+		close(fd);
+		s->redialAt = now_ns() + REDIAL_NS;
+		return;
+	}
+	/* The RELAY line goes once the connection is up (EPOLLOUT) */
+	attach(s, fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+	s->connecting = true;
+	s->toTcp.len = (uint32_t)snprintf((char *)s->toTcp.data, OUT_MAX, "RELAY %ld\n", (long)(s - sessions));
+}
+
+/**
+ * Write what is queued; the rest waits for EPOLLOUT. False if the fd failed.
+ */
+static bool flush(int fd, Out *o, uint64_t tag) {
+	uint32_t done = 0;
+	while (done < o->len) {
+		ssize_t n = write(fd, o->data + done, o->len - done);
+		if (n < 0) {
+			if (errno == EAGAIN)
+				break;
+			return false;
+		}
+		done += (uint32_t)n;
+	}
+	memmove(o->data, o->data + done, o->len - done);
+	o->len -= done;
+	watch(fd, EPOLLIN | EPOLLRDHUP | (o->len ? EPOLLOUT : 0), tag, EPOLL_CTL_MOD);
+	return true;
+}
+
+static void queue(Out *o, const char *data, uint32_t len, uint32_t *dropped) {
+	if (o->len + len > OUT_MAX) {
+		(*dropped)++;				// The far end stopped reading: lose the line
+		return;
+	}
+	memcpy(o->data + o->len, data, len);
+	o->len += len;
+}
+
+/**
+ * Note the board's move, or the far board's answer to it.
+ */
+static void track(Session *s, const char *l, bool up, uint64_t now) {
+	unsigned a, b, c, d, e;
+	char h;
+	if (up) {
+		bool scan = l[0] == 'S';
+		if (scan ? sscanf(l + 1, "%u %u %u", &a, &b, &c) == 3 :
+			l[0] == 'A' ? sscanf(l + 1, "%u %u", &b, &c) == 2 :
+			l[0] == 'P' && sscanf(l + 1, "%u %u %c %u %u", &a, &d, &h, &b, &c) == 5) {
+			if (s->waiting && s->scan == scan && s->row == b && s->col == c) {
+				s->resends++;
+				return;
+			}
+			s->waiting = true;
+			s->scan = scan;
+			s->row = (uint8_t)b;
+			s->col = (uint8_t)c;
+			s->movedAt = now;
+		}
+	} else if (s->waiting) {
+		bool scan = l[0] == 'Q';
+		if ((scan ? sscanf(l + 1, "%u %u %u", &a, &b, &c) == 3 :
+			 (l[0] == 'R' || l[0] == 'P') && sscanf(l + 1, "%u %u %c %u %u", &a, &b, &h, &d, &e) >= 3)
+			&& s->scan == scan && s->row == a && s->col == b) {
+			latency_add(&s->answer, now - s->movedAt);
+			s->waiting = false;
+		}
+	}
+}
+
+/**
+ * Bytes from one side: gather lines and queue each whole one for the other.
+ */
+static void carry(Session *s, const uint8_t *buf, ssize_t n, bool up, uint64_t now) {
+	Line *ln = up ? &s->up : &s->down;
+	Out *o = up ? &s->toTcp : &s->toSerial;
+	for (ssize_t i = 0; i < n; i++) {
+		if (!ln->len)
+			ln->start = now;
+		if (buf[i] == '\r')
+			continue;
+		if (ln->len < LINE_MAX - 1)
+			ln->text[ln->len++] = (char)buf[i];
+		if (buf[i] != '\n' && ln->len < LINE_MAX - 1)
+			continue;
+
+		ln->text[ln->len] = '\0';
+		if (up) {
+			s->linesUp++;
+			if (s->tcp < 0 || s->connecting) {
+				s->dropped++;
+			} else {
+				queue(o, ln->text, ln->len, &s->dropped);
+				latency_add(&s->fwd, now - ln->start);
+			}
+		} else {
+			s->linesDown++;
+			queue(o, ln->text, ln->len, &s->dropped);
+		}
+		track(s, ln->text, up, now);
+		ln->len = 0;
+	}
+}
+
+static void on_serial(Session *s, uint32_t events) {
+	uint8_t buf[256];
+	ssize_t n;
+	uint64_t now = now_ns();
+	while ((n = read(s->serial, buf, sizeof(buf))) > 0)
+		carry(s, buf, n, true, now);
+	if ((n < 0 && errno != EAGAIN) || (events & (EPOLLHUP | EPOLLERR))) {
+		fprintf(stderr, "session %ld: %s closed\n", (long)(s - sessions), s->name);
+		epoll_ctl(epfd, EPOLL_CTL_DEL, s->serial, NULL);
+		return;
+	}
+	if (events & EPOLLOUT)
+		flush(s->serial, &s->toSerial, TAG(TAG_SERIAL, s - sessions));
+	if (s->tcp >= 0 && !s->connecting && s->toTcp.len && !flush(s->tcp, &s->toTcp, TAG(TAG_TCP, s - sessions)))
+		drop_tcp(s, "write failed");
+}
+
+static void on_tcp(Session *s, uint32_t events) {
+	uint8_t buf[1024];
+	ssize_t n;
+	if (events & EPOLLIN) {
+		uint64_t now = now_ns();
+		while ((n = read(s->tcp, buf, sizeof(buf))) > 0)
+			carry(s, buf, n, false, now);
+		if (n == 0 || (n < 0 && errno != EAGAIN)) {
+			drop_tcp(s, "closed");
+			return;
+		}
+		if (s->toSerial.len)
+			flush(s->serial, &s->toSerial, TAG(TAG_SERIAL, s - sessions));
+	}
+	if ((events & (EPOLLERR | EPOLLHUP)) || !flush(s->tcp, &s->toTcp, TAG(TAG_TCP, s - sessions))) {
+		drop_tcp(s, s->connecting ? "no answer" : "connection lost");
+		return;
+	}
+	if (s->connecting && (events & EPOLLOUT))
+		connected(s);
+}
+
+/**
+ * An accepted connection names its session with "RELAY N".
+ */
+static void on_pending(Pending *p) {
+	ssize_t n = read(p->fd, p->text + p->len, sizeof(p->text) - 1 - p->len);
+	if (n < 0 && errno == EAGAIN)
+		return;
+	if (n > 0)
+		p->len += (uint32_t)n;
+	p->text[p->len] = '\0';
+	char *nl = strchr(p->text, '\n');
+	if (n <= 0 || (!nl && p->len == sizeof(p->text) - 1)) {
+		close(p->fd);
+		p->fd = -1;
+		return;
+	}
+	if (!nl)
+		return;
+
+	unsigned id;
+	int fd = p->fd;
+	p->fd = -1;
+	epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+	if (sscanf(p->text, "RELAY %u", &id) != 1 || id >= sessionCount || sessions[id].tcp >= 0) {
+		close(fd);
+		return;
+	}
+	Session *s = &sessions[id];
+	attach(s, fd, EPOLLIN | EPOLLRDHUP);
+	connected(s);
+	/* Lines that came in behind the RELAY line */
+	size_t rest = p->len - (size_t)(nl + 1 - p->text);
+	carry(s, (uint8_t *)nl + 1, (ssize_t)rest, false, now_ns());
+	flush(s->serial, &s->toSerial, TAG(TAG_SERIAL, s - sessions));
+}
+
+static void on_listen(void) {
+	int fd;
+	while ((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+		Pending *p = NULL;
+		for (uint32_t i = 0; i < MAX_PENDING && !p; i++)
+			if (pending[i].fd < 0)
+				p = &pending[i];
+		if (!p) {
+			close(fd);
+			continue;
+		}
+		tune(fd);
+		p->fd = fd;
+		p->len = 0;
+		watch(fd, EPOLLIN, TAG(TAG_PENDING, p - pending), EPOLL_CTL_ADD);
+	}
+}
+
+static void report(void) {
+	for (uint32_t i = 0; i < sessionCount; i++) {
+		Session *s = &sessions[i];
+		printf("session %u %s: %s connects=%u up=%u down=%u dropped=%u resends=%u", i, s->name,
+			   s->tcp >= 0 ? "up" : "down", s->connects, s->linesUp, s->linesDown, s->dropped, s->resends);
+		latency_print(stdout, "fwd", &s->fwd);
+		latency_print(stdout, "answer", &s->answer);
+		fputs(" hist", stdout);
+		for (uint8_t b = 0; b < LATENCY_BUCKETS; b++)
+			printf("%c%u", b ? ',' : '=', s->answer.hist[b]);
+		putchar('\n');
+	}
+	fflush(stdout);
+}
+
+static int usage(const char *argv0) {
+	fprintf(stderr, "usage: %s (-l [addr:]port | -c host:port) (-D device | -p count)... [-i report-s] [-v]\n", argv0);
+	return 2;
+}
+
+int main(int argc, char **argv) {
+	const char *listenSpec = NULL, *dialSpec = NULL;
+	double every = 0;
+
+	epfd = epoll_create1(0);
+	for (uint32_t i = 0; i < MAX_PENDING; i++)
+		pending[i].fd = -1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "l:c:D:p:i:v")) != -1) {
+		switch (opt) {
+			case 'l': listenSpec = optarg; break;
+			case 'c': dialSpec = optarg; break;
+			case 'D':
+				if (!add_serial(optarg))
+					return 1;
+				break;
+			case 'p':
+				for (long n = strtol(optarg, NULL, 0); n > 0; n--)
+					if (!add_pty()) {
+						perror("pty");
+						return 1;
+					}
+				fflush(stdout);
+				break;
+			case 'i': every = atof(optarg); break;
+			case 'v': verbose = true; break;
+			default: return usage(argv[0]);
+		}
+	}
+	if (!sessionCount || !listenSpec == !dialSpec)
+		return usage(argv[0]);
+
+	if (listenSpec) {
+		struct sockaddr_storage addr;
+		socklen_t len;
+		int one = 1;
+		if (!parse_addr(listenSpec, true, &addr, &len)
+			|| (listenFd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0
+			|| setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0
+			|| bind(listenFd, (struct sockaddr *)&addr, len) < 0 || listen(listenFd, 64) < 0) {
+			perror(listenSpec);
+			return 1;
+		}
+		watch(listenFd, EPOLLIN, TAG(TAG_LISTEN, 0), EPOLL_CTL_ADD);
+	} else if (!parse_addr(dialSpec, false, &dialAddr, &dialLen)) {
+		fprintf(stderr, "%s: no such host\n", dialSpec);
+		return 1;
+	}
+	for (uint32_t i = 0; i < sessionCount; i++)
+		watch(sessions[i].serial, EPOLLIN, TAG(TAG_SERIAL, i), EPOLL_CTL_ADD);
+
+	struct sigaction sa = { .sa_handler = on_signal };
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGUSR1, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	uint64_t reportAt = every > 0 ? now_ns() + (uint64_t)(every * 1e9) : UINT64_MAX;
+	while (!stop) {
+		uint64_t now = now_ns(), due = reportAt;
+		if (dialSpec)
+			for (uint32_t i = 0; i < sessionCount; i++) {
+				Session *s = &sessions[i];
+				if (s->tcp < 0 && now >= s->redialAt)
+					dial(s);
+				if (s->tcp < 0 && s->redialAt < due)
+					due = s->redialAt;
+			}
+		if (now >= reportAt || reportNow) {
+			reportNow = 0;
+			report();
+			if (now >= reportAt)
+				reportAt = now + (uint64_t)(every * 1e9);
+		}
+
+		int wait = due == UINT64_MAX ? -1 : due <= now ? 0 : (int)((due - now) / NS_PER_MS + 1);
+		struct epoll_event ev[EVENTS];
+		int n = epoll_wait(epfd, ev, EVENTS, wait);
+		for (int k = 0; k < n; k++) {
+			uint32_t i = (uint32_t)(ev[k].data.u64 >> 2);
+			switch (ev[k].data.u64 & 3) {
+				case TAG_SERIAL:  on_serial(&sessions[i], ev[k].events); break;
+				case TAG_TCP:	  if (sessions[i].tcp >= 0) on_tcp(&sessions[i], ev[k].events); break;
+				case TAG_PENDING: if (pending[i].fd >= 0) on_pending(&pending[i]); break;
+				case TAG_LISTEN:  on_listen(); break;
+			}
+		}
+	}
+	report();
+	return 0;
+}
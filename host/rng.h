@@ -0,0 +1,27 @@
+/* ---------------------------------------------------------------------------
+ * rng.h - Seedable random numbers for the host tools (splitmix64)
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_RNG_H
+#define HOST_RNG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static inline uint64_t rng_next(uint64_t *s) {
+	uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* Uniform in [0, n) */
+static inline uint32_t rng_below(uint64_t *s, uint32_t n) {
+	return n ? (uint32_t)(((rng_next(s) >> 32) * n) >> 32) : 0;
+}
+
+/* True with probability p */
+static inline bool rng_chance(uint64_t *s, double p) {
+	return p > 0 && (rng_next(s) >> 11) * (1.0 / 9007199254740992.0) < p;
+}
+
+#endif
@@ -0,0 +1,132 @@
+/* ---------------------------------------------------------------------------
+ * runner.c - Run complete games of the real firmware in virtual time
+ *
+ *     runner [-m ai|link|bot] [-g games] [-s seed] [-n link-spec] [-r scan-chance]
+ *            [-t think-ms] [-q] [-d prefix] [-i script] [-o script] [-v]
+ *
+ * -m ai     one board against the firmware's own AI (default)
+ * -m link   two boards against each other over a simulated link
+ * -m bot    one board against the host's protocol peer (peer.c), both ways
+ *           over the simulated link
+ * -g        games each pilot plays (default 10)
+ * -n        link model, e.g. "latency=5,jitter=2,lineloss=0.01,corrupt=0.001"
+ * -r        chance a turn scans with the radar while scans are left
+ * -t        the bot's thinking time per move (default 0)
+ * -q        mute the sounds (the blocking ones take seconds of each turn)
+ * -d        decode the display stream and write each board's last frame to
+ *           <prefix>-A.ppm (else SPI bytes are only counted)
+ * -i / -o   replay board A's inputs from / record them to a script
+ * -v        echo what each board sends
+ *
+ * Exits non-zero if a board goes 10 virtual minutes without starting or
+ * finishing a game.
+ * --------------------------------------------------------------------------- */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "board.h"
+#include "instance.h"
+#include "match.h"
+
+static double seconds(const struct timespec *a, const struct timespec *b) {
+	return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv) {
+	MatchConfig cfg = { .mode = MATCH_AI, .games = 10, .seed = 1, .scanChance = 0.1 };
+	const char *display = NULL;
+	const char *replay = NULL, *record = NULL;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "m:g:s:n:r:t:qd:i:o:v")) != -1) {
+		switch (opt) {
+			case 'm':
+				cfg.mode = !strcmp(optarg, "link") ? MATCH_LINK : !strcmp(optarg, "bot") ? MATCH_BOT : MATCH_AI;
+				break;
+			case 'g': cfg.games = (uint32_t)strtoul(optarg, NULL, 0); break;
+			case 's': cfg.seed = strtoull(optarg, NULL, 0); break;
+			case 'n':
+				if (!link_parse(&cfg.model, optarg)) {
+					fprintf(stderr, "bad link spec: %s\n", optarg);
+					return 2;
+				}
+				break;
+			case 'r': cfg.scanChance = atof(optarg); break;
+			case 't': cfg.thinkNs = (uint64_t)(atof(optarg) * NS_PER_MS); break;
+			case 'q': cfg.mute = true; break;
+			case 'd': display = optarg; cfg.display = true; break;
+			case 'i': replay = optarg; break;
+			case 'o': record = optarg; break;
+			case 'v': cfg.echo = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-m ai|link|bot] [-g games] [-s seed] [-n link-spec] [-r scan-chance] [-t think-ms] [-q] [-d] [-i script] [-o script] [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	Match m;
+	match_init(&m, &cfg);
+	if (replay) {
+		Script script;
+		if (!script_load(&script, replay))
+			return 2;
+		match_script(&m, &script);
+	}
+	FILE *rec = NULL;
+	if (record && !(rec = fopen(record, "w"))) {
+		perror(record);
+		return 2;
+	}
+	m.nodes[0].pilot.record = rec;
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (match_step(&m))
+		;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	if (rec)
+		fclose(rec);
+
+	double wall = seconds(&t0, &t1);
+	PilotStats sum = { 0 };
+	uint64_t virt = 0;
+	for (uint8_t i = 0; i < m.nodeCount; i++) {
+		Node *n = &m.nodes[i];
+		instance_enter(n->in);
+		const PilotStats *s = &n->pilot.stats;
+		printf("board %c: games=%u wins=%u aborted=%u shots=%u scans=%u avg-game=%.1fs"
+			   " answer avg=%.1fms p50<=%ums p99<=%ums max=%.1fms"
+			   " uart tx=%u rx=%u overruns=%u spi=%u\n",
+			   n->name, s->games, s->wins, s->aborted, s->shots, s->scans,
+			   s->games ? (double)s->gameNs / s->games / 1e9 : 0.0,
+			   s->answers ? (double)s->answerNsSum / s->answers / 1e6 : 0.0,
+			   pilot_answer_ms(s, 50), pilot_answer_ms(s, 99), (double)s->answerNsMax / 1e6,
+			   board.stats.uartTx, board.stats.uartRx, board.stats.uartOverruns, board.stats.spiBytes);
+		if (n->lcd) {
+			char path[256];
+			snprintf(path, sizeof(path), "%s-%c.ppm", display, n->name);
+			if (!lcd_write_ppm(n->lcd, path))
+				perror(path);
+		}
+		if (m.mode != MATCH_AI)
+			printf("link %c>: bytes=%u lines=%u lost-lines=%u lost-bytes=%u corrupted=%u\n", n->name,
+				   n->out.stats.bytes, n->out.stats.lines, n->out.stats.linesLost,
+				   n->out.stats.bytesLost, n->out.stats.bytesCorrupted);
+		pilot_stats_add(&sum, s);
+		if (instance_now(n->in) > virt)
+			virt = instance_now(n->in);
+	}
+	if (m.mode == MATCH_BOT) {
+		const Link *l = &m.botOut;
+		printf("link bot>: bytes=%u lines=%u lost-lines=%u lost-bytes=%u corrupted=%u\n",
+			   l->stats.bytes, l->stats.lines, l->stats.linesLost, l->stats.bytesLost, l->stats.bytesCorrupted);
+		peer_report(&m.bot, stdout);
+	}
+	uint32_t played = m.mode == MATCH_LINK ? sum.games / 2 : sum.games;
+	printf("%u games in %.1f virtual s, %.3f wall s: %.1f games/s, %.0fx real time%s\n",
+		   played, virt / 1e9, wall, played / wall, virt / 1e9 / wall, m.stalled ? " (STALLED)" : "");
+	return m.stalled ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+/* ---------------------------------------------------------------------------
+ * screens.c - Golden frames and display cost for each of the firmware's screens
+ *
+ *     screens [-d dir] [-u] [-b slack-%] [-o prefix] [-v]
+ *
+ * Runs the "screens" image (built with -DGFX_SPI_STATS) with the display
+ * decoded. Each static screen builder ends by printing
+ *
+ *     SPI <screen> bytes=<n> us=<n>
+ *
+ * and the printf blocks the firmware, so when that line goes out the frame
+ * is exactly what the builder drew. Two runs cover every screen:
+ *
+ *   dir/settings.script   board A's inputs from power-on to the settings screen
+ *   a linked game         menu, placement, play, and win on one board, lose on
+ *                         the other
+ *
+ * Each screen's frame is compared with dir/<screen>.ppm and its cost with
+ * dir/cost.txt ("<screen> <bytes> <us>" per line). A screen fails if any
+ * pixel differs or it sends more than its golden bytes plus -b percent
+ * (default 0); its frame is written to <prefix><screen>.ppm (default
+ * "screens-") to look at. Cheaper screens pass and say so. -u writes the
+ * frames and costs as the new goldens.
+ *
+ * The runs are deterministic, so a change to the game rather than to the
+ * drawing (a different AI move, a moved ship) also shows up here: check the
+ * written frames and rerun with -u.
+ * The host's EEPROM starts erased, so the end screens' image box holds what
+ * erased bytes decode to rather than the splash image.
+ * --------------------------------------------------------------------------- */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "instance.h"
+#include "match.h"
+
+#define SCREENS		6
+
+static const char *const SCREEN_NAMES[SCREENS] = { "menu", "settings", "placement", "play", "win", "lose" };
+
+typedef struct {
+	bool	 seen;
+	char	 board;
+	uint32_t bytes, us;
+	uint16_t frame[LCD_H][LCD_W];
+} Shot;
+
+static Shot shots[SCREENS];
+static bool verbose;
+
+/**
+ * MatchLineFn: keep the first frame of each screen, as its cost line goes out.
+ */
+static void on_line(void *user, Node *n, const char *line) {
+	char name[16];
+	unsigned long bytes, us;
+	char end;
+	if (sscanf(line, "SPI %15s bytes=%lu us=%lu%c", name, &bytes, &us, &end) != 3)
+		return;
+	for (uint8_t i = 0; i < SCREENS; i++) {
+		if (strcmp(name, SCREEN_NAMES[i]) || shots[i].seen)
+			continue;
+		shots[i].seen = true;
+		shots[i].board = n->name;
+		shots[i].bytes = (uint32_t)bytes;
+		shots[i].us = (uint32_t)us;
+		memcpy(shots[i].frame, n->lcd->frame, sizeof(shots[i].frame));
+		if (verbose)
+			printf("%10.3f %c> %s\n", (double)board.now / NS_PER_MS, n->name, line);
+	}
+}
+
+static bool run(MatchConfig *cfg, const Script *s) {
+	Match m;
+	match_init(&m, cfg);
+	if (s)
+		match_script(&m, s);
+	while (match_step(&m))
+		;
+	bool ok = !m.stalled;
+	match_free(&m);
+	return ok;
+}
+
+/* -------------------------------------------------------------------------
+ *  GOLDENS
+ * ------------------------------------------------------------------------- */
+typedef struct {
+	bool	 have;
+	uint32_t bytes, us;
+} Cost;
+
+static void read_costs(const char *dir, Cost costs[SCREENS]) {
+	char path[256], line[128], name[16];
+	unsigned long bytes, us;
+	snprintf(path, sizeof(path), "%s/cost.txt", dir);
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return;
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || sscanf(line, "%15s %lu %lu", name, &bytes, &us) != 3)
+			continue;
+		for (uint8_t i = 0; i < SCREENS; i++)
+			if (!strcmp(name, SCREEN_NAMES[i]))
+				costs[i] = (Cost){ true, (uint32_t)bytes, (uint32_t)us };
+	}
+	fclose(f);
+}
+
+static bool write_goldens(const char *dir) {
+	char path[256];
+	snprintf(path, sizeof(path), "%s/cost.txt", dir);
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	fprintf(f, "# screen bytes us (written by screens -u)\n");
+	for (uint8_t i = 0; i < SCREENS; i++)
+		fprintf(f, "%s %u %u\n", SCREEN_NAMES[i], shots[i].bytes, shots[i].us);
+	bool ok = fclose(f) == 0;
+
+	for (uint8_t i = 0; i < SCREENS && ok; i++) {
+		static Lcd lcd;
+		memcpy(lcd.frame, shots[i].frame, sizeof(lcd.frame));
+		snprintf(path, sizeof(path), "%s/%s.ppm", dir, SCREEN_NAMES[i]);
+		ok = lcd_write_ppm(&lcd, path);
+	}
+	return ok;
+}
+
+/**
+ * Pixels of `a` that differ from `b`, and the box around them.
+ */
+static uint32_t diff(uint16_t a[LCD_H][LCD_W], uint16_t b[LCD_H][LCD_W], int box[4]) {
+	uint32_t n = 0;
+	box[0] = LCD_W, box[1] = LCD_H, box[2] = -1, box[3] = -1;
+	for (int y = 0; y < LCD_H; y++) {
+		for (int x = 0; x < LCD_W; x++) {
+			if (a[y][x] == b[y][x])
+				continue;
+			n++;
+			if (x < box[0]) box[0] = x;
+			if (y < box[1]) box[1] = y;
+			if (x > box[2]) box[2] = x;
+			if (y > box[3]) box[3] = y;
+		}
+	}
+	return n;
+}
+
+int main(int argc, char **argv) {
+	const char *dir = "golden", *prefix = "screens-";
+	bool update = false;
+	double slack = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "d:ub:o:v")) != -1) {
+		switch (opt) {
+			case 'd': dir = optarg; break;
+			case 'u': update = true; break;
+			case 'b': slack = atof(optarg); break;
+			case 'o': prefix = optarg; break;
+			case 'v': verbose = true; break;
+			default:
+				fprintf(stderr, "usage: %s [-d dir] [-u] [-b slack-%%] [-o prefix] [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	char path[256];
+	Script settings;
+	snprintf(path, sizeof(path), "%s/settings.script", dir);
+	if (!script_load(&settings, path))
+		return 2;
+	MatchConfig cfg = { .mode = MATCH_AI, .games = 1, .seed = 1, .mute = true, .display = true, .onLine = on_line };
+	bool ran = run(&cfg, &settings);	/* The match frees the script */
+	cfg = (MatchConfig){ .mode = MATCH_LINK, .games = 1, .seed = 1, .scanChance = 0.1, .mute = true, .display = true,
+						 .onLine = on_line };
+	ran &= run(&cfg, NULL);
+	if (!ran) {
+		fprintf(stderr, "screens: a board stalled\n");
+		return 1;
+	}
+
+	bool ok = true;
+	for (uint8_t i = 0; i < SCREENS; i++) {
+		if (!shots[i].seen) {
+			fprintf(stderr, "screens: never drew %s\n", SCREEN_NAMES[i]);
+			ok = false;
+		}
+	}
+	if (!ok)
+		return 1;
+	if (update)
+		return write_goldens(dir) ? 0 : 1;
+
+	Cost costs[SCREENS] = { 0 };
+	read_costs(dir, costs);
+	static uint16_t golden[LCD_H][LCD_W];
+
+	printf("screen       bytes        us    golden   change  pixels  result\n");
+	for (uint8_t i = 0; i < SCREENS; i++) {
+		const Shot *s = &shots[i];
+		const char *result = "ok";
+		char pixels[64] = "-";
+		uint32_t limit = costs[i].have ? (uint32_t)(costs[i].bytes * (1 + slack / 100)) : 0;
+
+		snprintf(path, sizeof(path), "%s/%s.ppm", dir, SCREEN_NAMES[i]);
+		if (!lcd_read_ppm(golden, path) || !costs[i].have) {
+			result = "FAIL: no golden";
+		} else {
+			int box[4];
+			uint32_t n = diff(shots[i].frame, golden, box);
+			snprintf(pixels, sizeof(pixels), "%u", n);
+			if (n) {
+				snprintf(pixels, sizeof(pixels), "%u in (%d,%d)-(%d,%d)", n, box[0], box[1], box[2], box[3]);
+				result = "FAIL: pixels";
+			} else if (s->bytes > limit) {
+				result = "FAIL: cost";
+			} else if (s->bytes < costs[i].bytes) {
+				result = "ok, cheaper: rerun with -u";
+			}
+		}
+		if (strcmp(result, "ok") && strncmp(result, "ok,", 3)) {
+			static Lcd lcd;
+			char out[256];
+			memcpy(lcd.frame, s->frame, sizeof(lcd.frame));
+			snprintf(out, sizeof(out), "%s%s.ppm", prefix, SCREEN_NAMES[i]);
+			lcd_write_ppm(&lcd, out);
+			ok = false;
+		}
+		double change = costs[i].have && costs[i].bytes ? 100.0 * ((double)s->bytes - costs[i].bytes) / costs[i].bytes : 0;
+		printf("%-10s %7u %9u %9u %+7.1f%%  %-6s  %s\n", SCREEN_NAMES[i], s->bytes, s->us, costs[i].bytes, change,
+			   pixels, result);
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/* ---------------------------------------------------------------------------
+ * script.c - Timed input scripts for a simulated board
+ * --------------------------------------------------------------------------- */
+#include "script.h"
+#include "board.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool parse_value(const char *word, uint16_t *value) {
+	if		(!strcmp(word, "low"))		*value = BOARD_STICK_LOW;
+	else if (!strcmp(word, "centre"))	*value = BOARD_STICK_CENTRE;
+	else if (!strcmp(word, "high"))		*value = BOARD_STICK_HIGH;
+	else {
+		char *end;
+		long v = strtol(word, &end, 10);
+		if (*end || v < 0 || v > 1023)
+			return false;
+		*value = (uint16_t)v;
+	}
+	return true;
+}
+
+bool script_load(Script *s, const char *path) {
+	memset(s, 0, sizeof(*s));
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+
+	char line[128];
+	uint32_t cap = 0, lineNo = 0;
+	while (fgets(line, sizeof(line), f)) {
+		lineNo++;
+		char *hash = strchr(line, '#');
+		if (hash)
+			*hash = '\0';
+
+		double ms;
+		char what[16], arg1[16] = "", arg2[16] = "";
+		int n = sscanf(line, "%lf %15s %15s %15s", &ms, what, arg1, arg2);
+		if (n <= 0)
+			continue;
+
+		ScriptStep step = { .at = (uint64_t)llround(ms * 1000.0) * NS_PER_US };
+		bool ok = false;
+		if (n == 4 && !strcmp(what, "stick") && (!strcmp(arg1, "x") || !strcmp(arg1, "y"))) {
+			step.kind = BOARD_EV_ADC;
+			step.channel = arg1[0] == 'x' ? 0 : 1;
+			ok = parse_value(arg2, &step.value);
+		} else if (n == 3 && !strcmp(what, "button") && (!strcmp(arg1, "down") || !strcmp(arg1, "up"))) {
+			step.kind = BOARD_EV_BUTTON;
+			step.value = arg1[0] == 'd';
+			ok = true;
+		}
+		if (!ok || (s->count && step.at < s->steps[s->count - 1].at)) {
+			fprintf(stderr, "%s:%u: bad or out-of-order step\n", path, lineNo);
+			fclose(f);
+			script_free(s);
+			return false;
+		}
+
+		if (s->count == cap) {
+			cap = cap ? cap * 2 : 256;
+			s->steps = realloc(s->steps, cap * sizeof(ScriptStep));
+		}
+		s->steps[s->count++] = step;
+	}
+	fclose(f);
+	return true;
+}
+
+void script_free(Script *s) {
+	free(s->steps);
+	memset(s, 0, sizeof(*s));
+}
+
+void script_post(Script *s, uint64_t until) {
+	while (s->next < s->count && s->steps[s->next].at < until) {
+		const ScriptStep *step = &s->steps[s->next++];
+		if (step->kind == BOARD_EV_ADC)
+			board_stick_at(step->at, step->channel, step->value);
+		else
+			board_button_at(step->at, step->value);
+	}
+}
+
+bool script_done(const Script *s) {
+	return s->next == s->count;
+}
+
+static const char *value_word(uint16_t value, char *buf) {
+	if (value == BOARD_STICK_LOW)		return "low";
+	if (value == BOARD_STICK_CENTRE)	return "centre";
+	if (value == BOARD_STICK_HIGH)		return "high";
+	sprintf(buf, "%u", value);
+	return buf;
+}
+
+void script_write_stick(FILE *f, uint64_t at, uint8_t channel, uint16_t value) {
+	char buf[8];
+	fprintf(f, "%.3f stick %c %s\n", (double)at / NS_PER_MS, channel ? 'y' : 'x', value_word(value, buf));
+}
+
+void script_write_button(FILE *f, uint64_t at, bool pressed) {
+	fprintf(f, "%.3f button %s\n", (double)at / NS_PER_MS, pressed ? "down" : "up");
+}
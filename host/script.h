@@ -0,0 +1,46 @@
+/* ---------------------------------------------------------------------------
+ * script.h - Timed input scripts for a simulated board
+ *
+ * One input change per line, at a virtual time in ms since power-on:
+ *
+ *     # comment
+ *     1520.000 stick y low       (axis x or y: low, centre, high or 0..1023)
+ *     1670.000 stick y centre
+ *     1700.000 button down
+ *     1740.000 button up
+ *
+ * Times are whole microseconds. The simulation is deterministic, so a script the pilot recorded replays
+ * the same game, against the same peer seed.
+ * --------------------------------------------------------------------------- */
+#ifndef HOST_SCRIPT_H
+#define HOST_SCRIPT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct {
+	uint64_t at;
+	uint8_t	 kind;			/* BoardEventKind */
+	uint8_t	 channel;
+	uint16_t value;
+} ScriptStep;
+
+typedef struct {
+	ScriptStep *steps;
+	uint32_t	count;
+	uint32_t	next;
+} Script;
+
+/* Load a script; false (with a message on stderr) on a bad line */
+bool script_load(Script *s, const char *path);
+void script_free(Script *s);
+/* Post the steps due before `until` to the live board */
+void script_post(Script *s, uint64_t until);
+bool script_done(const Script *s);
+
+/* Append one step to a script being recorded */
+void script_write_stick(FILE *f, uint64_t at, uint8_t channel, uint16_t value);
+void script_write_button(FILE *f, uint64_t at, bool pressed);
+
+#endif